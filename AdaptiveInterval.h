@@ -0,0 +1,77 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+/**
+ * @brief Collection interval that can temporarily be shortened (a "burst") and then decays back to the normal interval
+ *
+ * After a burst is requested, the burst interval is used for the hold period. Once that expires, the interval doubles
+ * on each tick until it is back at the baseline. Requesting another burst during the hold period extends it.
+ *
+ * Not thread-safe - callers are expected to hold the metric lock
+ */
+class AdaptiveInterval
+{
+public:
+    explicit AdaptiveInterval(std::chrono::milliseconds baseline = std::chrono::milliseconds(0))
+            : mBaseline(baseline),
+              mCurrent(baseline),
+              mHoldUntil()
+    {
+    }
+
+    void Burst(std::chrono::milliseconds interval, std::chrono::milliseconds hold)
+    {
+        mCurrent = std::min(std::max(interval, std::chrono::milliseconds(1)), mBaseline);
+        mHoldUntil = std::chrono::steady_clock::now() + hold;
+    }
+
+    /**
+     * @return How long to wait before the next collection
+     */
+    std::chrono::milliseconds Next()
+    {
+        auto next = mCurrent;
+
+        if (mCurrent < mBaseline && std::chrono::steady_clock::now() >= mHoldUntil) {
+            mCurrent = std::min(mCurrent * 2, mBaseline);
+        }
+
+        return next;
+    }
+
+    bool IsBursting() const
+    {
+        return mCurrent < mBaseline;
+    }
+
+    std::chrono::milliseconds Baseline() const
+    {
+        return mBaseline;
+    }
+
+private:
+    std::chrono::milliseconds mBaseline;
+    std::chrono::milliseconds mCurrent;
+    std::chrono::steady_clock::time_point mHoldUntil;
+};
@@ -0,0 +1,142 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "CollectorStats.h"
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+static double roundMs(long double us)
+{
+    return std::round(us) / 1000.0;
+}
+
+CollectorStats::ScopedSample::ScopedSample(CollectorStats *stats, std::string source, bool trackIo)
+        : mStats(stats),
+          mSource(std::move(source)),
+          mTrackIo(trackIo && stats && stats->mIoAccountingAvailable),
+          mStart(std::chrono::steady_clock::now()),
+          mBytesRead(0),
+          mReadCalls(0)
+{
+    if (mTrackIo) {
+        mStats->readThreadIo(&mBytesRead, &mReadCalls);
+    }
+}
+
+CollectorStats::ScopedSample::~ScopedSample()
+{
+    if (!mStats) {
+        return;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(end - mStart);
+
+    if (mStats->mTraceRecorder) {
+        mStats->mTraceRecorder->AddSpan(mSource, mStart, end);
+    }
+
+    uint64_t bytesRead;
+    uint64_t readCalls;
+    if (mTrackIo && mStats->readThreadIo(&bytesRead, &readCalls)) {
+        mStats->Record(mSource, latency, bytesRead - mBytesRead, readCalls - mReadCalls);
+    } else {
+        mStats->Record(mSource, latency);
+    }
+}
+
+CollectorStats::CollectorStats() : mIoAccountingAvailable(access("/proc/thread-self/io", R_OK) == 0)
+{
+}
+
+void CollectorStats::Record(const std::string &source, std::chrono::microseconds latency)
+{
+    std::lock_guard<std::mutex> locker(mLock);
+    mSources[source].Latency.Record(latency);
+}
+
+void CollectorStats::Record(const std::string &source, std::chrono::microseconds latency, uint64_t bytesRead,
+                            uint64_t readCalls)
+{
+    std::lock_guard<std::mutex> locker(mLock);
+
+    auto &stats = mSources[source];
+    stats.Latency.Record(latency);
+    stats.BytesRead.AddDataPoint(bytesRead);
+    stats.ReadCalls.AddDataPoint(readCalls);
+}
+
+/**
+ * Uses rchar/syscr from the thread's IO accounting. rchar counts everything passed to read() including procfs and
+ * sysfs, which is what we want here as none of our sources touch the block layer
+ */
+bool CollectorStats::readThreadIo(uint64_t *bytesRead, uint64_t *readCalls) const
+{
+    int fd = open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    char buffer[512];
+    ssize_t len = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+
+    if (len <= 0) {
+        return false;
+    }
+    buffer[len] = '\0';
+
+    return sscanf(buffer, "rchar: %" SCNu64 " wchar: %*u syscr: %" SCNu64, bytesRead, readCalls) == 2;
+}
+
+nlohmann::json CollectorStats::ToJson() const
+{
+    std::lock_guard<std::mutex> locker(mLock);
+
+    auto result = nlohmann::json::array();
+
+    for (const auto &[name, stats]: mSources) {
+        nlohmann::json source;
+
+        source["source"] = name;
+        source["samples"] = stats.Latency.GetCount();
+        source["meanMs"] = roundMs(stats.Latency.GetMeanUs());
+        source["p50Ms"] = roundMs(stats.Latency.GetPercentileUs(50));
+        source["p90Ms"] = roundMs(stats.Latency.GetPercentileUs(90));
+        source["p99Ms"] = roundMs(stats.Latency.GetPercentileUs(99));
+        source["maxMs"] = roundMs(stats.Latency.GetMaxUs());
+        source["buckets"] = stats.Latency.BucketsToJson();
+
+        if (stats.BytesRead.GetCount() > 0) {
+            source["bytesReadPerTick"] = stats.BytesRead.GetAverageRounded();
+            source["readCallsPerTick"] = stats.ReadCalls.GetAverageRounded();
+        } else {
+            source["bytesReadPerTick"] = nullptr;
+            source["readCallsPerTick"] = nullptr;
+        }
+
+        result.emplace_back(source);
+    }
+
+    return result;
+}
@@ -0,0 +1,108 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include "nlohmann/json.hpp"
+
+#include "LatencyHistogram.h"
+#include "Measurement.h"
+#include "TraceRecorder.h"
+
+/**
+ * @brief Records how long each data source takes to collect, so the cost of running MemCapture itself is visible
+ * in the report
+ *
+ * Safe to record into from any thread. Sources that are sampled once per tick can also track how much they read,
+ * taken from the IO accounting of the thread doing the collection. If a trace recorder is set, every sample is also
+ * recorded as a trace span
+ */
+class CollectorStats
+{
+public:
+    /**
+     * @brief Times a block of code and records it against a source when it goes out of scope
+     */
+    class ScopedSample
+    {
+    public:
+        ScopedSample(CollectorStats *stats, std::string source, bool trackIo = false);
+
+        ~ScopedSample();
+
+        ScopedSample(const ScopedSample &) = delete;
+
+        ScopedSample &operator=(const ScopedSample &) = delete;
+
+    private:
+        CollectorStats *const mStats;
+        const std::string mSource;
+        const bool mTrackIo;
+
+        const std::chrono::steady_clock::time_point mStart;
+        uint64_t mBytesRead;
+        uint64_t mReadCalls;
+    };
+
+    CollectorStats();
+
+    /**
+     * Must be set before any collection starts
+     */
+    void SetTraceRecorder(std::shared_ptr<TraceRecorder> traceRecorder)
+    {
+        mTraceRecorder = std::move(traceRecorder);
+    }
+
+    void Record(const std::string &source, std::chrono::microseconds latency);
+
+    void Record(const std::string &source, std::chrono::microseconds latency, uint64_t bytesRead, uint64_t readCalls);
+
+    nlohmann::json ToJson() const;
+
+private:
+    struct SourceStats
+    {
+        SourceStats() : BytesRead("BytesRead"), ReadCalls("ReadCalls")
+        {
+        }
+
+        LatencyHistogram Latency;
+        Measurement BytesRead;
+        Measurement ReadCalls;
+    };
+
+    /**
+     * Read the bytes read and read syscalls made so far by the calling thread
+     */
+    bool readThreadIo(uint64_t *bytesRead, uint64_t *readCalls) const;
+
+private:
+    mutable std::mutex mLock;
+    std::map<std::string, SourceStats> mSources;
+
+    // Not every kernel has per-task IO accounting enabled
+    const bool mIoAccountingAvailable;
+
+    std::shared_ptr<TraceRecorder> mTraceRecorder;
+};
@@ -0,0 +1,298 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "ControlServer.h"
+#include "Log.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+// Stop anyone sending us an unbounded line
+static constexpr size_t kMaxCommandLength = 4096;
+
+ControlServer::ControlServer(std::filesystem::path socketPath, CommandHandler handler)
+        : mSocketPath(std::move(socketPath)),
+          mHandler(std::move(handler)),
+          mListenFd(-1),
+          mEpollFd(-1),
+          mStopFd(-1)
+{
+
+}
+
+ControlServer::~ControlServer()
+{
+    Stop();
+}
+
+bool ControlServer::Start()
+{
+    struct sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+
+    if (mSocketPath.string().size() >= sizeof(addr.sun_path)) {
+        LOG_ERROR("Control socket path %s is too long", mSocketPath.string().c_str());
+        return false;
+    }
+    strncpy(addr.sun_path, mSocketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    mListenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (mListenFd < 0) {
+        LOG_SYS_ERROR(errno, "Failed to create control socket");
+        return false;
+    }
+
+    // Clean up after a previous run that didn't exit cleanly
+    unlink(mSocketPath.c_str());
+
+    if (bind(mListenFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 || listen(mListenFd, 4) < 0) {
+        LOG_SYS_ERROR(errno, "Failed to listen on control socket %s", mSocketPath.string().c_str());
+        Stop();
+        return false;
+    }
+
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    mStopFd = eventfd(0, EFD_CLOEXEC);
+    if (mEpollFd < 0 || mStopFd < 0) {
+        LOG_SYS_ERROR(errno, "Failed to create control socket epoll");
+        Stop();
+        return false;
+    }
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = mListenFd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mListenFd, &event);
+
+    event.data.fd = mStopFd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mStopFd, &event);
+
+    LOG_INFO("Listening for commands on %s", mSocketPath.string().c_str());
+
+    mThread = std::thread(&ControlServer::Run, this);
+    return true;
+}
+
+void ControlServer::Stop()
+{
+    if (mStopFd >= 0) {
+        uint64_t value = 1;
+        if (write(mStopFd, &value, sizeof(value)) < 0) {
+            LOG_SYS_WARN(errno, "Failed to signal control socket thread");
+        }
+    }
+
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+
+    for (const auto &c: mClients) {
+        close(c.first);
+    }
+    mClients.clear();
+
+    if (mListenFd >= 0) {
+        close(mListenFd);
+        mListenFd = -1;
+        unlink(mSocketPath.c_str());
+    }
+
+    if (mEpollFd >= 0) {
+        close(mEpollFd);
+        mEpollFd = -1;
+    }
+
+    if (mStopFd >= 0) {
+        close(mStopFd);
+        mStopFd = -1;
+    }
+}
+
+void ControlServer::Run()
+{
+    pthread_setname_np(pthread_self(), "ControlServer");
+
+    struct epoll_event events[8];
+
+    while (true) {
+        int count = epoll_wait(mEpollFd, events, 8, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_SYS_ERROR(errno, "epoll_wait() failed on control socket");
+            return;
+        }
+
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+
+            if (fd == mStopFd) {
+                return;
+            }
+
+            if (fd == mListenFd) {
+                acceptClients();
+                continue;
+            }
+
+            auto itr = mClients.find(fd);
+            if (itr == mClients.end()) {
+                continue;
+            }
+
+            bool ok = true;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                ok = readClient(fd, itr->second);
+            }
+            if (ok && !itr->second.Out.empty()) {
+                ok = writeClient(fd, itr->second);
+            }
+
+            if (!ok || (itr->second.Finished && itr->second.Out.empty())) {
+                closeClient(fd);
+            }
+        }
+    }
+}
+
+void ControlServer::acceptClients()
+{
+    while (true) {
+        int fd = accept4(mListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_SYS_WARN(errno, "Failed to accept control socket connection");
+            }
+            return;
+        }
+
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event);
+
+        mClients.emplace(fd, client());
+    }
+}
+
+/**
+ * Read everything available and run any complete commands
+ * @return False if the client has gone away
+ */
+bool ControlServer::readClient(int fd, client &c)
+{
+    char buffer[512];
+
+    while (true) {
+        ssize_t len = read(fd, buffer, sizeof(buffer));
+        if (len == 0) {
+            c.Finished = true;
+            break;
+        }
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return false;
+        }
+
+        c.In.append(buffer, len);
+    }
+
+    size_t newline;
+    while ((newline = c.In.find('\n')) != std::string::npos) {
+        std::string line = c.In.substr(0, newline);
+        c.In.erase(0, newline + 1);
+
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        auto space = line.find(' ');
+        std::string command = line.substr(0, space);
+        std::string argument = space == std::string::npos ? "" : line.substr(space + 1);
+
+        nlohmann::json response;
+        try {
+            response = mHandler(command, argument);
+        } catch (const std::exception &e) {
+            response = {{"ok", false}, {"error", e.what()}};
+        }
+
+        c.Out += response.dump() + "\n";
+    }
+
+    if (c.In.size() > kMaxCommandLength) {
+        LOG_WARN("Control socket command too long - disconnecting client");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Send as much of the pending output as the socket will take, waiting for EPOLLOUT if it's full
+ * @return False if the client has gone away
+ */
+bool ControlServer::writeClient(int fd, client &c)
+{
+    while (!c.Out.empty()) {
+        ssize_t len = send(fd, c.Out.data(), c.Out.size(), MSG_NOSIGNAL);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return false;
+        }
+
+        c.Out.erase(0, len);
+    }
+
+    struct epoll_event event = {};
+    event.events = c.Out.empty() ? EPOLLIN : (EPOLLIN | EPOLLOUT);
+    event.data.fd = fd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_MOD, fd, &event);
+
+    return true;
+}
+
+void ControlServer::closeClient(int fd)
+{
+    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    mClients.erase(fd);
+}
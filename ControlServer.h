@@ -0,0 +1,83 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief Local Unix socket for controlling and querying a running capture
+ *
+ * Clients send one command per line, made up of the command name and an optional argument separated by a space
+ * (e.g. "mark video-playback"). Each command gets a single line JSON response. All clients are served by one thread
+ * using epoll, and commands are handled on that thread one at a time
+ */
+class ControlServer
+{
+public:
+    using CommandHandler = std::function<nlohmann::json(const std::string &command, const std::string &argument)>;
+
+    ControlServer(std::filesystem::path socketPath, CommandHandler handler);
+
+    ~ControlServer();
+
+    ControlServer(const ControlServer &) = delete;
+
+    ControlServer &operator=(const ControlServer &) = delete;
+
+    bool Start();
+
+    void Stop();
+
+private:
+    struct client
+    {
+        std::string In;
+        std::string Out;
+
+        // Client has finished sending, close once any responses have been sent
+        bool Finished = false;
+    };
+
+    void Run();
+
+    void acceptClients();
+
+    bool readClient(int fd, client &c);
+
+    bool writeClient(int fd, client &c);
+
+    void closeClient(int fd);
+
+private:
+    const std::filesystem::path mSocketPath;
+    const CommandHandler mHandler;
+
+    int mListenFd;
+    int mEpollFd;
+    int mStopFd;
+
+    std::thread mThread;
+    std::map<int, client> mClients;
+};
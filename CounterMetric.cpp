@@ -0,0 +1,235 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "CounterMetric.h"
+#include "Log.h"
+#include "RollingWindow.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+
+// Don't let a typo in the config turn into a busy loop
+static constexpr std::chrono::milliseconds kMinimumInterval(100);
+
+CounterMetric::CounterMetric(std::shared_ptr<JsonReportGenerator> reportGenerator, const nlohmann::json &config)
+        : mQuit(false),
+          mCv(),
+          mCounters{},
+          mPrune(false),
+          mBuffer{},
+          mReportGenerator(std::move(reportGenerator))
+{
+    auto counters = config["counters"];
+    if (!counters.is_array()) {
+        LOG_ERROR("Counters not a valid array - no custom counters will be collected");
+        return;
+    }
+
+    for (const auto &entry: counters) {
+        if (!entry.contains("name") || !entry.contains("path") || !entry.contains("pattern")) {
+            LOG_WARN("Found malformed counter - must have 'name', 'path' and 'pattern' fields");
+            continue;
+        }
+
+        counter c;
+        c.Name = entry["name"];
+        c.Path = entry["path"];
+        c.Scale = entry.value("scale", 1.0L);
+        c.Unit = entry.value("unit", "");
+        c.ConfiguredInterval = std::chrono::milliseconds(entry.value("intervalMs", 0));
+
+        try {
+            c.Pattern = std::regex(entry["pattern"].get<std::string>(), std::regex::ECMAScript | std::regex::optimize);
+        } catch (const std::regex_error &e) {
+            LOG_WARN("Invalid pattern for counter %s: %s", c.Name.c_str(), e.what());
+            continue;
+        }
+
+        if (c.Pattern.mark_count() < 1 || c.Pattern.mark_count() > 2) {
+            LOG_WARN("Pattern for counter %s must have one (value) or two (label, value) capture groups",
+                     c.Name.c_str());
+            continue;
+        }
+
+        mCounters.emplace_back(std::move(c));
+    }
+
+    LOG_INFO("Loaded %zu custom counters", mCounters.size());
+}
+
+CounterMetric::~CounterMetric()
+{
+    if (!mQuit) {
+        StopCollection();
+    }
+}
+
+/**
+ * @param frequency Used for any counters that don't specify their own interval
+ */
+void CounterMetric::EnablePruning()
+{
+    mPrune = true;
+}
+
+void CounterMetric::StartCollection(const std::chrono::milliseconds frequency)
+{
+    auto now = std::chrono::steady_clock::now();
+
+    for (auto &c: mCounters) {
+        c.Interval = std::max(c.ConfiguredInterval.count() != 0 ? c.ConfiguredInterval : frequency, kMinimumInterval);
+        c.NextSample = now;
+
+        c.Fd = open(c.Path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (c.Fd < 0) {
+            LOG_WARN("Failed to open %s for counter %s", c.Path.c_str(), c.Name.c_str());
+        }
+    }
+
+    mQuit = false;
+    mCollectionThread = std::thread(&CounterMetric::CollectData, this);
+}
+
+void CounterMetric::StopCollection()
+{
+    std::unique_lock<std::mutex> locker(mLock);
+    mQuit = true;
+    mCv.notify_all();
+    locker.unlock();
+
+    if (mCollectionThread.joinable()) {
+        LOG_INFO("Waiting for CounterMetric collection thread to terminate");
+        mCollectionThread.join();
+    }
+
+    // Opened again if collection is restarted
+    for (auto &c: mCounters) {
+        if (c.Fd >= 0) {
+            close(c.Fd);
+            c.Fd = -1;
+        }
+    }
+}
+
+void CounterMetric::CollectData()
+{
+    std::unique_lock<std::mutex> lock(mLock);
+
+    do {
+        auto now = std::chrono::steady_clock::now();
+        auto nextWake = now + std::chrono::hours(1);
+
+        for (auto &c: mCounters) {
+            if (c.Fd < 0) {
+                continue;
+            }
+
+            if (c.NextSample <= now) {
+                ReadCounter(c);
+
+                // Keep to the schedule, but don't try to catch up if we've fallen behind
+                c.NextSample = std::max(c.NextSample + c.Interval, now);
+            }
+
+            nextWake = std::min(nextWake, c.NextSample);
+        }
+
+        // Wait until the next counter is due, or until cancelled
+        mCv.wait_until(lock, nextWake);
+    } while (!mQuit);
+
+    LOG_INFO("Collection thread quit");
+}
+
+void CounterMetric::ReadCounter(counter &c)
+{
+    // sysfs files are limited to a page, but procfs files can be longer so keep reading until we hit the end
+    mBuffer.clear();
+    char chunk[4096];
+    ssize_t bytesRead;
+    while ((bytesRead = pread(c.Fd, chunk, sizeof(chunk), mBuffer.size())) > 0) {
+        mBuffer.append(chunk, bytesRead);
+    }
+
+    if (bytesRead < 0) {
+        LOG_WARN("Failed to read %s for counter %s", c.Path.c_str(), c.Name.c_str());
+        return;
+    }
+
+    const bool hasLabel = c.Pattern.mark_count() == 2;
+
+    for (auto itr = std::sregex_iterator(mBuffer.begin(), mBuffer.end(), c.Pattern);
+         itr != std::sregex_iterator(); ++itr) {
+        const auto &match = *itr;
+        std::string label = hasLabel ? match[1].str() : c.Name;
+
+        char *end;
+        const std::string valueStr = match[hasLabel ? 2 : 1].str();
+        long double value = strtold(valueStr.c_str(), &end);
+        if (end == valueStr.c_str()) {
+            continue;
+        }
+
+        auto valueItr = c.Values.find(label);
+        if (valueItr == c.Values.end()) {
+            valueItr = c.Values.emplace(label, counterValue(label)).first;
+            if (mPrune) {
+                valueItr->second.Series.SetRetention(RollingWindow::kMaxWindow);
+            }
+        }
+
+        valueItr->second.Value.AddDataPoint(value * c.Scale);
+        valueItr->second.Series.AddDataPoint(value * c.Scale);
+
+        // Without a label there's only one value to read
+        if (!hasLabel) {
+            break;
+        }
+    }
+}
+
+void CounterMetric::SaveResults()
+{
+    // Can be called whilst collection is running when saving a snapshot
+    std::lock_guard<std::mutex> locker(mLock);
+
+    std::vector<JsonReportGenerator::dataItems> data{};
+
+    for (const auto &c: mCounters) {
+        std::vector<TimeSeries> series;
+
+        for (const auto &value: c.Values) {
+            data.emplace_back(JsonReportGenerator::dataItems{
+                    std::make_pair("Counter", c.Name),
+                    std::make_pair("Label", value.first),
+                    std::make_pair("Unit", c.Unit),
+                    value.second.Value
+            });
+
+            series.emplace_back(value.second.Series);
+        }
+
+        if (!series.empty()) {
+            mReportGenerator->addTimeSeries(c.Unit.empty() ? c.Name : c.Name + " (" + c.Unit + ")", series);
+        }
+    }
+
+    mReportGenerator->addDataset("Custom Counters", data);
+}
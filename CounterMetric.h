@@ -0,0 +1,111 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "IMetric.h"
+
+#include <thread>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <regex>
+#include <vector>
+#include "JsonReportGenerator.h"
+#include "Measurement.h"
+#include "TimeSeries.h"
+
+/**
+ * @brief Collects arbitrary sysfs/procfs counters described in a JSON config file
+ *
+ * Lets vendor specific counters be added to a capture without writing a parser and rebuilding. Each counter is a file
+ * and a regex with either one capture group (the value) or two (a label and the value, for files with a row per
+ * region/device). Files are kept open for the whole capture and re-read from the start with pread() each sample
+ *
+ * See counters.example.json for the format
+ */
+class CounterMetric : public IMetric
+{
+public:
+    CounterMetric(std::shared_ptr<JsonReportGenerator> reportGenerator, const nlohmann::json &config);
+
+    ~CounterMetric() override;
+
+    void StartCollection(std::chrono::milliseconds frequency) override;
+
+    void StopCollection() override;
+
+    void SaveResults() override;
+
+    /**
+     * Only chart the largest rolling window of each counter. Used when running indefinitely. Must be called before
+     * collection starts
+     */
+    void EnablePruning();
+
+private:
+    struct counterValue
+    {
+        explicit counterValue(const std::string &label)
+                : Value("Value"),
+                  Series(label)
+        {
+        }
+
+        Measurement Value;
+        TimeSeries Series;
+    };
+
+    struct counter
+    {
+        std::string Name;
+        std::string Path;
+        std::regex Pattern;
+        long double Scale = 1;
+        std::string Unit;
+        // Interval from the config (0 to use the collection interval) and the interval currently in use
+        std::chrono::milliseconds ConfiguredInterval{0};
+        std::chrono::milliseconds Interval{0};
+
+        int Fd = -1;
+        std::chrono::steady_clock::time_point NextSample;
+
+        // Keyed by label, or the counter name if the pattern has no label
+        std::map<std::string, counterValue> Values;
+    };
+
+private:
+    void CollectData();
+
+    void ReadCounter(counter &c);
+
+private:
+    std::thread mCollectionThread;
+    bool mQuit;
+    std::condition_variable mCv;
+    std::mutex mLock;
+
+    std::vector<counter> mCounters;
+    bool mPrune;
+
+    // Reused between reads to avoid an allocation per sample
+    std::string mBuffer;
+
+    const std::shared_ptr<JsonReportGenerator> mReportGenerator;
+};
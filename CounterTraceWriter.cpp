@@ -0,0 +1,148 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "CounterTraceWriter.h"
+#include "Log.h"
+
+#include <unistd.h>
+#include "nlohmann/json.hpp"
+
+CounterTraceWriter::CounterTraceWriter(const std::filesystem::path &path)
+        : mOutput(path, std::ios::trunc | std::ios::binary),
+          mOpen(false),
+          mPid(getpid())
+{
+    if (!mOutput) {
+        LOG_ERROR("Failed to open %s to write counter timeline", path.string().c_str());
+        return;
+    }
+
+    mOpen = true;
+    mOutput << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    // Every other event is written with a leading comma, so write the first one here
+    nlohmann::json processName = {
+            {"name", "process_name"},
+            {"ph",   "M"},
+            {"pid",  mPid},
+            {"args", {{"name", "MemCapture"}}}
+    };
+    mOutput << processName.dump();
+    mNamedProcesses.insert(mPid);
+
+    LOG_INFO("Writing counter timeline to %s", path.string().c_str());
+}
+
+CounterTraceWriter::~CounterTraceWriter()
+{
+    Close();
+}
+
+void CounterTraceWriter::AddCounter(const std::string &track, const std::map<std::string, long double> &values)
+{
+    std::lock_guard<std::mutex> locker(mLock);
+
+    if (!mOpen) {
+        return;
+    }
+
+    writeEvent(mPid, track, values);
+}
+
+void CounterTraceWriter::AddProcessCounter(pid_t pid, const std::string &processName, const std::string &track,
+                                           const std::map<std::string, long double> &values)
+{
+    std::lock_guard<std::mutex> locker(mLock);
+
+    if (!mOpen) {
+        return;
+    }
+
+    if (mNamedProcesses.insert(pid).second) {
+        writeProcessName(pid, processName);
+    }
+
+    writeEvent(pid, track, values);
+}
+
+void CounterTraceWriter::AddMarker(const std::string &name)
+{
+    std::lock_guard<std::mutex> locker(mLock);
+
+    if (!mOpen) {
+        return;
+    }
+
+    nlohmann::json event = {
+            {"name", name},
+            {"ph",   "i"},
+            {"s",    "g"},
+            {"ts",   std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count()},
+            {"pid",  mPid}
+    };
+
+    mOutput << ",\n" << event.dump();
+}
+
+void CounterTraceWriter::Close()
+{
+    std::lock_guard<std::mutex> locker(mLock);
+
+    if (!mOpen) {
+        return;
+    }
+
+    mOpen = false;
+    mOutput << "\n]}\n";
+    mOutput.close();
+}
+
+void CounterTraceWriter::writeEvent(pid_t pid, const std::string &track,
+                                    const std::map<std::string, long double> &values)
+{
+    auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    nlohmann::json event = {
+            {"name", track},
+            {"ph",   "C"},
+            {"ts",   now},
+            {"pid",  pid}
+    };
+
+    auto &args = event["args"];
+    for (const auto &value: values) {
+        args[value.first] = static_cast<double>(value.second);
+    }
+
+    mOutput << ",\n" << event.dump();
+}
+
+void CounterTraceWriter::writeProcessName(pid_t pid, const std::string &name)
+{
+    nlohmann::json event = {
+            {"name", "process_name"},
+            {"ph",   "M"},
+            {"pid",  pid},
+            {"args", {{"name", name}}}
+    };
+
+    mOutput << ",\n" << event.dump();
+}
@@ -0,0 +1,94 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <sys/types.h>
+
+/**
+ * @brief Streams memory counters to a Chrome trace-event JSON file so they can be viewed on a timeline in Perfetto
+ *
+ * Counters are written to the file as soon as they're collected rather than kept in memory, so long captures don't
+ * grow the memory usage of MemCapture. System-wide counters go on the MemCapture process, per-process counters go on a
+ * track for that process so they sit next to its threads when loaded with a system trace.
+ *
+ * If MemCapture is killed before the file is closed, the trace is missing the closing bracket. Both Perfetto and
+ * chrome://tracing accept this.
+ *
+ * Timestamps are CLOCK_MONOTONIC (steady_clock) in microseconds, to match the collector trace
+ */
+class CounterTraceWriter
+{
+public:
+    explicit CounterTraceWriter(const std::filesystem::path &path);
+
+    ~CounterTraceWriter();
+
+    CounterTraceWriter(const CounterTraceWriter &) = delete;
+
+    CounterTraceWriter &operator=(const CounterTraceWriter &) = delete;
+
+    bool IsOpen() const
+    {
+        return mOpen;
+    }
+
+    /**
+     * Add a system-wide counter track. Each value becomes its own series on the track
+     */
+    void AddCounter(const std::string &track, const std::map<std::string, long double> &values);
+
+    /**
+     * Add a counter track to a specific process
+     */
+    void AddProcessCounter(pid_t pid, const std::string &processName, const std::string &track,
+                           const std::map<std::string, long double> &values);
+
+    /**
+     * Add a global instant event, e.g. to mark the start of a test case
+     */
+    void AddMarker(const std::string &name);
+
+    /**
+     * Finish the trace. No more counters can be added after this
+     */
+    void Close();
+
+private:
+    void writeEvent(pid_t pid, const std::string &track, const std::map<std::string, long double> &values);
+
+    void writeProcessName(pid_t pid, const std::string &name);
+
+private:
+    std::mutex mLock;
+    std::ofstream mOutput;
+    bool mOpen;
+
+    const pid_t mPid;
+
+    // Processes that we've already written the name of
+    std::set<pid_t> mNamedProcesses;
+};
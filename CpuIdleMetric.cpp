@@ -33,7 +33,7 @@ CpuIdleMetric::CpuIdleMetric(std::shared_ptr<JsonReportGenerator> reportGenerato
 }
 
 
-void CpuIdleMetric::StartCollection([[maybe_unused]] const std::chrono::seconds frequency)
+void CpuIdleMetric::StartCollection([[maybe_unused]] const std::chrono::milliseconds frequency)
 {
     // Check if collectd is running in the background. If it is, it might interfere with the stat collection since
     // the idle metrics are globally scoped
@@ -28,7 +28,6 @@
 #include <thread>
 #include <condition_variable>
 #include <mutex>
-#include "Platform.h"
 #include <sys/prctl.h>
 
 /**
@@ -43,7 +42,7 @@ public:
 
     ~CpuIdleMetric() override = default;
 
-    void StartCollection(std::chrono::seconds frequency) override;
+    void StartCollection(std::chrono::milliseconds frequency) override;
 
     void StopCollection() override;
 
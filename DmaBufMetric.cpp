@@ -0,0 +1,409 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "DmaBufMetric.h"
+#include "FileParsers/DmaBufFdInfo.h"
+#include "Process.h"
+#include "Log.h"
+#include "RollingWindow.h"
+
+#include <dirent.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <set>
+#include <vector>
+
+static const char *kSysfsBuffersPath = "/sys/kernel/dmabuf/buffers";
+static const char *kDebugfsBufinfoPath = "/sys/kernel/debug/dma_buf/bufinfo";
+
+DmaBufMetric::DmaBufMetric(std::shared_ptr<JsonReportGenerator> reportGenerator,
+                           std::shared_ptr<DmaBufSnapshot> dmaBufSnapshot)
+        : mQuit(false),
+          mCv(),
+          mBuffers{},
+          mExporterMeasurements{},
+          mImporterMeasurements{},
+          mDmaBufFds([](const char *target)
+                     {
+                         // Depending on kernel version the link will either be "/dmabuf:<name>" or "anon_inode:dmabuf"
+                         return strstr(target, "dmabuf") != nullptr;
+                     }),
+          mPrune(false),
+          mTotal("Size_KB"),
+          mBufferCount("Buffers"),
+          mTotalSeries("DMA-BUF Total"),
+          mReportGenerator(std::move(reportGenerator)),
+          mDmaBufSnapshot(std::move(dmaBufSnapshot))
+{
+
+}
+
+DmaBufMetric::~DmaBufMetric()
+{
+    if (!mQuit) {
+        StopCollection();
+    }
+}
+
+bool DmaBufMetric::IsSupported()
+{
+    return std::filesystem::exists(kSysfsBuffersPath) || access(kDebugfsBufinfoPath, R_OK) == 0;
+}
+
+void DmaBufMetric::EnablePruning()
+{
+    mPrune = true;
+    mTotalSeries.SetRetention(RollingWindow::kMaxWindow);
+}
+
+void DmaBufMetric::StartCollection(const std::chrono::milliseconds frequency)
+{
+    mQuit = false;
+    mCollectionThread = std::thread(&DmaBufMetric::CollectData, this, frequency);
+}
+
+void DmaBufMetric::StopCollection()
+{
+    std::unique_lock<std::mutex> locker(mLock);
+    mQuit = true;
+    mCv.notify_all();
+    locker.unlock();
+
+    if (mCollectionThread.joinable()) {
+        LOG_INFO("Waiting for DmaBufMetric collection thread to terminate");
+        mCollectionThread.join();
+    }
+}
+
+void DmaBufMetric::CollectData(std::chrono::milliseconds frequency)
+{
+    std::unique_lock<std::mutex> lock(mLock);
+
+    const bool useSysfs = std::filesystem::exists(kSysfsBuffersPath);
+    LOG_INFO("Reading DMA-BUF buffers from %s", useSysfs ? kSysfsBuffersPath : kDebugfsBufinfoPath);
+
+    do {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        if (useSysfs) {
+            ReadSysfsBuffers();
+        } else {
+            ReadDebugfsBuffers();
+        }
+
+        // Total by exporter
+        uint64_t totalBytes = 0;
+        std::map<std::string, std::pair<size_t, uint64_t>> exporterTotals;
+        for (const auto &buffer: mBuffers) {
+            totalBytes += buffer.second.SizeBytes;
+
+            auto &exporter = exporterTotals[buffer.second.Exporter];
+            exporter.first++;
+            exporter.second += buffer.second.SizeBytes;
+        }
+
+        // Exporters we've seen before with no buffers now still need a data point so the min/average are correct
+        for (const auto &exporter: exporterTotals) {
+            mExporterMeasurements.emplace(exporter.first, exporterMeasurement());
+        }
+
+        for (auto &exporter: mExporterMeasurements) {
+            auto itr = exporterTotals.find(exporter.first);
+            size_t count = itr != exporterTotals.end() ? itr->second.first : 0;
+            uint64_t bytes = itr != exporterTotals.end() ? itr->second.second : 0;
+
+            exporter.second.Buffers.AddDataPoint(count);
+            exporter.second.Size.AddDataPoint(bytes / 1024.0L);
+        }
+
+        mTotal.AddDataPoint(totalBytes / 1024.0L);
+        mBufferCount.AddDataPoint(mBuffers.size());
+        mTotalSeries.AddDataPoint(totalBytes / 1024.0L);
+
+        AttachImporters();
+        if (mPrune) {
+            PruneImporters();
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        LOG_INFO("DmaBufMetric completed in %lld ms",
+                 (long long) std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+
+        // Wait for period before doing collection again, or until cancelled
+        mCv.wait_for(lock, frequency);
+    } while (!mQuit);
+
+    LOG_INFO("Collection thread quit");
+}
+
+/**
+ * Each buffer has a directory named after its inode containing (amongst others) "size" and "exporter_name". Buffers
+ * can't change size or exporter, so only the directories that weren't there last time need to be read
+ */
+void DmaBufMetric::ReadSysfsBuffers()
+{
+    DIR *buffersDir = opendir(kSysfsBuffersPath);
+    if (!buffersDir) {
+        LOG_WARN("Failed to open %s", kSysfsBuffersPath);
+        return;
+    }
+
+    std::set<ino_t> present;
+    char filePath[PATH_MAX];
+
+    struct dirent *entry;
+    while ((entry = readdir(buffersDir)) != nullptr) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+
+        auto inode = static_cast<ino_t>(strtoull(entry->d_name, nullptr, 10));
+        present.insert(inode);
+
+        if (mBuffers.find(inode) != mBuffers.end()) {
+            continue;
+        }
+
+        dmaBufBuffer buffer{0, ""};
+
+        // Buffer might be freed whilst we're reading it, in which case just skip it
+        snprintf(filePath, sizeof(filePath), "%s/%s/size", kSysfsBuffersPath, entry->d_name);
+        std::ifstream sizeFile(filePath);
+        if (!(sizeFile >> buffer.SizeBytes)) {
+            present.erase(inode);
+            continue;
+        }
+
+        snprintf(filePath, sizeof(filePath), "%s/%s/exporter_name", kSysfsBuffersPath, entry->d_name);
+        std::ifstream exporterFile(filePath);
+        std::getline(exporterFile, buffer.Exporter);
+
+        mBuffers.emplace(inode, std::move(buffer));
+    }
+
+    closedir(buffersDir);
+
+    // Remove any buffers that have been freed since the last sample
+    for (auto itr = mBuffers.begin(); itr != mBuffers.end();) {
+        if (present.find(itr->first) == present.end()) {
+            itr = mBuffers.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
+
+/**
+ * The debugfs file lists every buffer along with its attachments, so is re-read in full each time
+ *
+ * Dma-buf Objects:
+ * size            flags           mode            count           exp_name        ino             name
+ * 08294400        00000002        00080007        00000003        ion-system      00001063        <none>
+ *         Attached Devices:
+ * Total 0 devices attached
+ *
+ * Older kernels don't include the inode, so those buffers can't be matched to a process
+ */
+void DmaBufMetric::ReadDebugfsBuffers()
+{
+    FILE *fp = fopen(kDebugfsBufinfoPath, "re");
+    if (!fp) {
+        LOG_WARN("Failed to open %s", kDebugfsBufinfoPath);
+        return;
+    }
+
+    mBuffers.clear();
+
+    // Give buffers without an inode a key that won't clash with a real one
+    ino_t anonymousKey = std::numeric_limits<ino_t>::max();
+
+    char line[512];
+    while (fgets(line, sizeof(line), fp)) {
+        uint64_t size;
+        unsigned int flags;
+        unsigned int mode;
+        unsigned long count;
+        char exporter[128];
+        unsigned long inode;
+
+        int fields = sscanf(line, "%" SCNu64 " %x %x %lu %127s %lu", &size, &flags, &mode, &count, exporter, &inode);
+        if (fields < 5) {
+            continue;
+        }
+
+        ino_t key = fields == 6 ? static_cast<ino_t>(inode) : anonymousKey--;
+        mBuffers[key] = dmaBufBuffer{size, exporter};
+    }
+
+    fclose(fp);
+}
+
+/**
+ * Find all the processes holding a DMA-BUF fd. A buffer shared between N processes adds 1/N of its size to each
+ * process' share
+ */
+void DmaBufMetric::AttachImporters()
+{
+    std::map<pid_t, std::map<ino_t, uint64_t>> processBuffers;
+    std::map<ino_t, size_t> holders;
+    std::set<pid_t> running;
+
+    std::error_code ec;
+    for (const auto &entry: std::filesystem::directory_iterator("/proc", ec)) {
+        const auto name = entry.path().filename().string();
+        if (name.empty() || !std::all_of(name.begin(), name.end(), ::isdigit)) {
+            continue;
+        }
+
+        pid_t pid = std::stoi(name);
+        running.insert(pid);
+
+        auto &dmaBufFds = mDmaBufFds.Update(pid);
+        if (dmaBufFds.empty()) {
+            continue;
+        }
+
+        // Drop any fds that have been closed and re-used for something else since they were found
+        DmaBufFdInfo fdInfo(pid, dmaBufFds);
+        dmaBufFds = fdInfo.Fds();
+        if (fdInfo.Buffers().empty()) {
+            continue;
+        }
+
+        auto &buffers = processBuffers[pid];
+        for (const auto &buffer: fdInfo.Buffers()) {
+            // Prefer the size from the system-wide list, fdinfo is only a fallback
+            auto itr = mBuffers.find(buffer.first);
+            buffers[buffer.first] = itr != mBuffers.end() ? itr->second.SizeBytes : buffer.second.sizeBytes;
+            holders[buffer.first]++;
+        }
+    }
+
+    mDmaBufFds.Prune(running);
+
+    auto now = std::chrono::steady_clock::now();
+    std::map<pid_t, long double> totalKb;
+
+    for (const auto &process: processBuffers) {
+        long double totalBytes = 0;
+        long double shareBytes = 0;
+
+        for (const auto &buffer: process.second) {
+            totalBytes += buffer.second;
+            shareBytes += buffer.second / (long double) holders[buffer.first];
+        }
+
+        auto itr = mImporterMeasurements.find(process.first);
+        if (itr == mImporterMeasurements.end()) {
+            Process p(process.first);
+            itr = mImporterMeasurements.emplace(process.first, importerMeasurement(p.name())).first;
+        }
+
+        itr->second.Buffers.AddDataPoint(process.second.size());
+        itr->second.Total.AddDataPoint(totalBytes / 1024.0L);
+        itr->second.Share.AddDataPoint(shareBytes / 1024.0L);
+        itr->second.LastSeen = now;
+
+        totalKb[process.first] = totalBytes / 1024.0L;
+    }
+
+    if (mDmaBufSnapshot) {
+        mDmaBufSnapshot->Publish(totalKb);
+    }
+}
+
+void DmaBufMetric::PruneImporters()
+{
+    auto now = std::chrono::steady_clock::now();
+
+    for (auto itr = mImporterMeasurements.begin(); itr != mImporterMeasurements.end();) {
+        if (now - itr->second.LastSeen > RollingWindow::kMaxWindow) {
+            itr = mImporterMeasurements.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
+
+void DmaBufMetric::SaveResults()
+{
+    // Can be called whilst collection is running when saving a snapshot
+    std::lock_guard<std::mutex> locker(mLock);
+
+    std::vector<JsonReportGenerator::dataItems> exporterData{};
+
+    // Largest exporters first
+    std::vector<std::pair<std::string, const exporterMeasurement *>> exporters;
+    for (const auto &exporter: mExporterMeasurements) {
+        exporters.emplace_back(exporter.first, &exporter.second);
+    }
+    std::sort(exporters.begin(), exporters.end(), [](const auto &a, const auto &b)
+    {
+        return a.second->Size.GetAverage() > b.second->Size.GetAverage();
+    });
+
+    exporterData.emplace_back(JsonReportGenerator::dataItems{
+            std::make_pair("Exporter", "Total"),
+            mBufferCount,
+            mTotal
+    });
+
+    for (const auto &exporter: exporters) {
+        exporterData.emplace_back(JsonReportGenerator::dataItems{
+                std::make_pair("Exporter", exporter.first.empty() ? "Unknown" : exporter.first),
+                exporter.second->Buffers,
+                exporter.second->Size
+        });
+    }
+
+    mReportGenerator->addDataset("DMA-BUF Exporters", exporterData);
+
+    // Processes with the largest share first
+    std::vector<std::pair<pid_t, const importerMeasurement *>> importers;
+    for (const auto &importer: mImporterMeasurements) {
+        importers.emplace_back(importer.first, &importer.second);
+    }
+    std::sort(importers.begin(), importers.end(), [](const auto &a, const auto &b)
+    {
+        return a.second->Share.GetAverage() > b.second->Share.GetAverage();
+    });
+
+    std::vector<JsonReportGenerator::dataItems> importerData{};
+    for (const auto &importer: importers) {
+        importerData.emplace_back(JsonReportGenerator::dataItems{
+                std::make_pair("PID", std::to_string(importer.first)),
+                std::make_pair("Process", importer.second->Name),
+                importer.second->Buffers,
+                importer.second->Share,
+                importer.second->Total
+        });
+    }
+
+    mReportGenerator->addDataset("DMA-BUF Importers", importerData);
+
+    mReportGenerator->addTimeSeries("DMA-BUF Total (KB)", {mTotalSeries});
+}
@@ -0,0 +1,134 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "IMetric.h"
+
+#include <sys/types.h>
+#include <thread>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "JsonReportGenerator.h"
+#include "Measurement.h"
+#include "TimeSeries.h"
+#include "DmaBufSnapshot.h"
+#include "FileParsers/FdTable.h"
+
+/**
+ * @brief System-wide DMA-BUF accounting
+ *
+ * Codec, display and GPU buffers are often allocated as DMA-BUFs, which don't show up in any process' PSS. This
+ * metric reads every buffer in the system from sysfs (/sys/kernel/dmabuf/buffers, kernel 5.13+) or from the debugfs
+ * bufinfo file on older kernels, and totals them by exporter. Buffers are attached to the processes that hold an fd
+ * to them, and each process is charged an equal share of every buffer it holds.
+ *
+ * As with DrmGpuMemory, the fd table of each process is cached so only fds opened since the last sample need a
+ * readlink to find new DMA-BUFs. The per-process totals are published to ProcessMetric for its footprint
+ */
+class DmaBufMetric : public IMetric
+{
+public:
+    explicit DmaBufMetric(std::shared_ptr<JsonReportGenerator> reportGenerator,
+                          std::shared_ptr<DmaBufSnapshot> dmaBufSnapshot = nullptr);
+
+    ~DmaBufMetric() override;
+
+    void StartCollection(std::chrono::milliseconds frequency) override;
+
+    void StopCollection() override;
+
+    void SaveResults() override;
+
+    static bool IsSupported();
+
+    /**
+     * Forget processes that haven't held a buffer for longer than the largest rolling window, and only chart the largest
+     * window. Used when running indefinitely. Must be called before collection starts
+     */
+    void EnablePruning();
+
+private:
+    struct dmaBufBuffer
+    {
+        uint64_t SizeBytes;
+        std::string Exporter;
+    };
+
+    struct exporterMeasurement
+    {
+        Measurement Buffers = Measurement("Buffers");
+        Measurement Size = Measurement("Size_KB");
+    };
+
+    struct importerMeasurement
+    {
+        explicit importerMeasurement(std::string name) : Name(std::move(name))
+        {
+        }
+
+        std::string Name;
+        Measurement Buffers = Measurement("Buffers");
+
+        // Every buffer the process holds counted in full, and divided between all processes holding it
+        Measurement Total = Measurement("Total_KB");
+        Measurement Share = Measurement("Share_KB");
+
+        std::chrono::steady_clock::time_point LastSeen;
+    };
+
+private:
+    void CollectData(std::chrono::milliseconds frequency);
+
+    void ReadSysfsBuffers();
+
+    void ReadDebugfsBuffers();
+
+    void AttachImporters();
+
+    void PruneImporters();
+
+private:
+    std::thread mCollectionThread;
+    bool mQuit;
+    std::condition_variable mCv;
+    std::mutex mLock;
+
+    // All buffers currently in the system, keyed by inode. With sysfs this is kept between samples so only new
+    // buffers need to be read
+    std::map<ino_t, dmaBufBuffer> mBuffers;
+
+    std::map<std::string, exporterMeasurement> mExporterMeasurements;
+    std::map<pid_t, importerMeasurement> mImporterMeasurements;
+
+    // DMA-BUF fds of each process, cached between samples
+    FdTable mDmaBufFds;
+
+    bool mPrune;
+
+    Measurement mTotal;
+    Measurement mBufferCount;
+    TimeSeries mTotalSeries;
+
+    const std::shared_ptr<JsonReportGenerator> mReportGenerator;
+    const std::shared_ptr<DmaBufSnapshot> mDmaBufSnapshot;
+};
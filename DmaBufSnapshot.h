@@ -0,0 +1,56 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+
+#pragma once
+
+#include <sys/types.h>
+#include <map>
+#include <mutex>
+
+/**
+ * @brief The most recent DMA-BUF usage per process
+ *
+ * DmaBufMetric already keeps a cached table of the DMA-BUF fds each process holds, so rather than walking every fd of
+ * every process again ProcessMetric reads the per-process totals DmaBufMetric published on its last tick
+ */
+class DmaBufSnapshot
+{
+public:
+    void Publish(const std::map<pid_t, long double> &totalKb)
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mTotalKb = totalKb;
+    }
+
+    /**
+     * @return Size of the unique DMA-BUF buffers the process holds an fd to in KB, or 0 if it holds none
+     */
+    long double TotalKb(pid_t pid) const
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        auto itr = mTotalKb.find(pid);
+        return itr != mTotalKb.end() ? itr->second : 0;
+    }
+
+private:
+    mutable std::mutex mLock;
+    std::map<pid_t, long double> mTotalKb;
+};
@@ -0,0 +1,148 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "DrmGpuMemory.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+DrmGpuMemory::DrmGpuMemory()
+        : mDrmFds([](const char *target)
+                  {
+                      return strncmp(target, "/dev/dri/", strlen("/dev/dri/")) == 0;
+                  })
+{
+
+}
+
+bool DrmGpuMemory::IsSupported()
+{
+    return std::filesystem::exists("/dev/dri");
+}
+
+void DrmGpuMemory::GetUsage(std::map<pid_t, long double> &usageKb)
+{
+    std::set<pid_t> running;
+
+    std::error_code ec;
+    for (const auto &entry: std::filesystem::directory_iterator("/proc", ec)) {
+        const auto name = entry.path().filename().string();
+        if (name.empty() || !std::all_of(name.begin(), name.end(), ::isdigit)) {
+            continue;
+        }
+
+        pid_t pid = std::stoi(name);
+        running.insert(pid);
+
+        auto &drmFds = mDrmFds.Update(pid);
+
+        // A client can be shared by multiple fds (e.g. after dup()), so only count each client once
+        std::set<std::string> clients;
+        for (auto itr = drmFds.begin(); itr != drmFds.end();) {
+            std::string clientId;
+            long double kb = ReadClientUsageKb(pid, *itr, &clientId);
+
+            if (clientId.empty()) {
+                // fd has been closed or re-used for something else since it was classified
+                itr = drmFds.erase(itr);
+                continue;
+            }
+
+            if (clients.insert(clientId).second && kb > 0) {
+                usageKb[pid] += kb;
+            }
+            ++itr;
+        }
+    }
+
+    mDrmFds.Prune(running);
+}
+
+/**
+ * DRM fdinfo looks like:
+ *
+ * drm-driver:     panfrost
+ * drm-client-id:  13
+ * drm-engine-fragment:    4436253 ns
+ * drm-total-memory:       32956 KiB
+ * drm-shared-memory:      0
+ * drm-active-memory:      0
+ * drm-resident-memory:    32956 KiB
+ * drm-purgeable-memory:   0
+ *
+ * Older drivers report drm-memory-<region> instead of drm-resident-<region>. Values without a unit are in bytes.
+ * Resident memory is preferred as it's what is actually using RAM
+ *
+ * @return Memory used by the client in KB. clientId is left empty if this isn't a DRM fd
+ */
+long double DrmGpuMemory::ReadClientUsageKb(pid_t pid, int fd, std::string *clientId) const
+{
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "/proc/%d/fdinfo/%d", pid, fd);
+
+    FILE *fp = fopen(path, "re");
+    if (!fp) {
+        return 0;
+    }
+
+    long double residentKb = 0;
+    long double memoryKb = 0;
+    bool hasResident = false;
+
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        char key[128];
+        char unit[8] = "";
+        unsigned long long value;
+
+        int fields = sscanf(line, "%127[^:]: %llu %7s", key, &value, unit);
+        if (fields < 2) {
+            continue;
+        }
+
+        if (strcmp(key, "drm-client-id") == 0) {
+            *clientId = std::to_string(value);
+            continue;
+        }
+
+        long double kb = value / 1024.0L;
+        if (fields == 3) {
+            if (strcmp(unit, "KiB") == 0) {
+                kb = value;
+            } else if (strcmp(unit, "MiB") == 0) {
+                kb = value * 1024.0L;
+            } else if (strcmp(unit, "GiB") == 0) {
+                kb = value * 1024.0L * 1024.0L;
+            }
+        }
+
+        if (strncmp(key, "drm-resident-", strlen("drm-resident-")) == 0) {
+            residentKb += kb;
+            hasResident = true;
+        } else if (strncmp(key, "drm-memory-", strlen("drm-memory-")) == 0) {
+            memoryKb += kb;
+        }
+    }
+
+    fclose(fp);
+    return hasResident ? residentKb : memoryKb;
+}
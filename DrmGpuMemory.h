@@ -0,0 +1,55 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <sys/types.h>
+#include <map>
+#include <set>
+#include <string>
+#include "FileParsers/FdTable.h"
+
+/**
+ * @brief Platform independent GPU memory usage from DRM fdinfo
+ *
+ * Since kernel 6.x, DRM drivers (panfrost, panthor, v3d, etnaviv, amdgpu, i915...) report the memory used by each
+ * client in /proc/<pid>/fdinfo/<fd> using standard keys (see Documentation/gpu/drm-usage-stats.rst), so GPU usage
+ * can be captured on any SoC without a platform specific debugfs parser.
+ *
+ * DRM fds are found with an FdTable, so the fd table of each process isn't walked in full every sample. The fdinfo of
+ * known DRM fds is re-read each time as the values change
+ */
+class DrmGpuMemory
+{
+public:
+    DrmGpuMemory();
+
+    static bool IsSupported();
+
+    /**
+     * Add the GPU memory used by each process (in KB) to usageKb
+     */
+    void GetUsage(std::map<pid_t, long double> &usageKb);
+
+private:
+    long double ReadClientUsageKb(pid_t pid, int fd, std::string *clientId) const;
+
+private:
+    FdTable mDrmFds;
+};
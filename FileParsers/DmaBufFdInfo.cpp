@@ -0,0 +1,147 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "DmaBufFdInfo.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <climits>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+DmaBufFdInfo::DmaBufFdInfo(pid_t pid) : mPid(pid), mTotalBytes(0), mBuffers()
+{
+    parseFds();
+}
+
+DmaBufFdInfo::DmaBufFdInfo(pid_t pid, const std::set<int> &fds) : mPid(pid), mTotalBytes(0), mBuffers()
+{
+    for (const int fd: fds) {
+        addFd(fd);
+    }
+}
+
+void DmaBufFdInfo::parseFds()
+{
+    char fdDirPath[PATH_MAX];
+    snprintf(fdDirPath, sizeof(fdDirPath), "/proc/%d/fd", mPid);
+
+    // Process might have died or we might not have permission, don't log anything
+    DIR *fdDir = opendir(fdDirPath);
+    if (!fdDir) {
+        return;
+    }
+
+    char linkPath[PATH_MAX];
+    char target[PATH_MAX];
+
+    struct dirent *entry;
+    while ((entry = readdir(fdDir)) != nullptr) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+
+        // Readlink is much cheaper than opening the fdinfo file, so use it to skip anything that isn't a dmabuf.
+        // Depending on kernel version the link will either be "/dmabuf:<name>" or "anon_inode:dmabuf"
+        snprintf(linkPath, sizeof(linkPath), "/proc/%d/fd/%s", mPid, entry->d_name);
+        ssize_t len = readlink(linkPath, target, sizeof(target) - 1);
+        if (len <= 0) {
+            continue;
+        }
+        target[len] = '\0';
+
+        if (!strstr(target, "dmabuf")) {
+            continue;
+        }
+
+        addFd(atoi(entry->d_name));
+    }
+
+    closedir(fdDir);
+}
+
+void DmaBufFdInfo::addFd(int fd)
+{
+    ino_t inode = 0;
+    Buffer buffer{0, ""};
+    if (!parseFdInfo(fd, &inode, &buffer)) {
+        return;
+    }
+
+    // Older kernels don't include the inode in fdinfo, so fall back to stat-ing the link
+    if (inode == 0) {
+        char linkPath[PATH_MAX];
+        snprintf(linkPath, sizeof(linkPath), "/proc/%d/fd/%d", mPid, fd);
+
+        struct stat statBuf = {};
+        if (stat(linkPath, &statBuf) != 0) {
+            return;
+        }
+        inode = statBuf.st_ino;
+    }
+
+    mFds.insert(fd);
+    if (mBuffers.insert(std::make_pair(inode, buffer)).second) {
+        mTotalBytes += buffer.sizeBytes;
+    }
+}
+
+/**
+ * fdinfo for a dmabuf looks like:
+ *
+ * pos:    0
+ * flags:  02000002
+ * mnt_id: 15
+ * ino:    1063
+ * size:   8294400
+ * count:  3
+ * exp_name:       ion_system_heap
+ * name:   <none>
+ */
+bool DmaBufFdInfo::parseFdInfo(int fd, ino_t *inode, Buffer *buffer) const
+{
+    char filePath[PATH_MAX];
+    snprintf(filePath, sizeof(filePath), "/proc/%d/fdinfo/%d", mPid, fd);
+
+    FILE *fp = fopen(filePath, "re");
+    if (!fp) {
+        return false;
+    }
+
+    bool foundSize = false;
+    char line[256];
+    char exporter[128];
+
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long value;
+        if (sscanf(line, "size: %" SCNu64, &buffer->sizeBytes) == 1) {
+            foundSize = true;
+        } else if (sscanf(line, "ino: %lu", &value) == 1) {
+            *inode = static_cast<ino_t>(value);
+        } else if (sscanf(line, "exp_name: %127s", exporter) == 1) {
+            buffer->exporter = exporter;
+        }
+    }
+
+    fclose(fp);
+    return foundSize;
+}
@@ -0,0 +1,83 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <sys/types.h>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+
+/**
+ * Finds the DMA-BUF buffers a process holds a file descriptor to by walking /proc/<pid>/fd and reading the matching
+ * /proc/<pid>/fdinfo entries
+ *
+ * The same buffer is often imported more than once by a process (e.g. once by the decoder and once by the
+ * compositor client) so buffers are de-duplicated by inode number. Buffers that are only mapped and not held
+ * open by an fd are not visible here
+ */
+class DmaBufFdInfo
+{
+public:
+    struct Buffer
+    {
+        uint64_t sizeBytes;
+        std::string exporter;
+    };
+
+    explicit DmaBufFdInfo(pid_t pid);
+
+    /**
+     * Only read the given fds, which are already known to be DMA-BUFs, instead of walking every fd of the process.
+     * Any that turn out not to be (e.g. the fd has been closed and re-used) are skipped
+     */
+    DmaBufFdInfo(pid_t pid, const std::set<int> &fds);
+
+    // Total size of all unique buffers held by the process
+    uint64_t TotalKb() const
+    {
+        return mTotalBytes / 1024;
+    }
+
+    // Unique buffers held by the process, keyed by inode
+    const std::map<ino_t, Buffer> &Buffers() const
+    {
+        return mBuffers;
+    }
+
+    // The fds the buffers were found on
+    const std::set<int> &Fds() const
+    {
+        return mFds;
+    }
+
+private:
+    void parseFds();
+
+    void addFd(int fd);
+
+    bool parseFdInfo(int fd, ino_t *inode, Buffer *buffer) const;
+
+private:
+    pid_t mPid;
+    uint64_t mTotalBytes;
+    std::map<ino_t, Buffer> mBuffers;
+    std::set<int> mFds;
+};
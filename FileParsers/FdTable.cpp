@@ -0,0 +1,112 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "FdTable.h"
+
+#include <dirent.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+FdTable::FdTable(std::function<bool(const char *target)> matches)
+        : mMatches(std::move(matches))
+{
+
+}
+
+std::set<int> &FdTable::Update(pid_t pid)
+{
+    auto inserted = mProcesses.emplace(pid, processFds());
+    auto &cached = inserted.first->second;
+    if (inserted.second) {
+        cached.Samples = pid % kRecheckSamples;
+    }
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+
+    DIR *fdDir = opendir(path);
+    if (!fdDir) {
+        // Process might have died or we might not have permission, don't log anything
+        cached.Fds.clear();
+        cached.Matching.clear();
+        return cached.Matching;
+    }
+
+    std::vector<int> fds;
+    struct dirent *entry;
+    while ((entry = readdir(fdDir)) != nullptr) {
+        if (entry->d_name[0] != '.') {
+            fds.emplace_back(atoi(entry->d_name));
+        }
+    }
+    closedir(fdDir);
+
+    std::sort(fds.begin(), fds.end());
+
+    std::vector<int> toCheck;
+    if (++cached.Samples % kRecheckSamples == 0) {
+        // Any fd could have been closed and reopened under the same number since it was last checked
+        toCheck = fds;
+        cached.Matching.clear();
+    } else if (fds != cached.Fds) {
+        std::set_difference(fds.begin(), fds.end(), cached.Fds.begin(), cached.Fds.end(),
+                            std::back_inserter(toCheck));
+
+        // Drop any matching fds that have been closed
+        for (auto itr = cached.Matching.begin(); itr != cached.Matching.end();) {
+            if (!std::binary_search(fds.begin(), fds.end(), *itr)) {
+                itr = cached.Matching.erase(itr);
+            } else {
+                ++itr;
+            }
+        }
+    }
+
+    char target[PATH_MAX];
+    for (const int fd: toCheck) {
+        snprintf(path, sizeof(path), "/proc/%d/fd/%d", pid, fd);
+        ssize_t len = readlink(path, target, sizeof(target) - 1);
+        if (len <= 0) {
+            continue;
+        }
+        target[len] = '\0';
+
+        if (mMatches(target)) {
+            cached.Matching.insert(fd);
+        }
+    }
+
+    cached.Fds = std::move(fds);
+    return cached.Matching;
+}
+
+void FdTable::Prune(const std::set<pid_t> &running)
+{
+    for (auto itr = mProcesses.begin(); itr != mProcesses.end();) {
+        if (running.find(itr->first) == running.end()) {
+            itr = mProcesses.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
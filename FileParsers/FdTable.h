@@ -0,0 +1,75 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <sys/types.h>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+/**
+ * @brief Caches which fds of each process point at a particular kind of file, e.g. DRM devices or DMA-BUFs
+ *
+ * Checking what an fd points at means a readlink of /proc/<pid>/fd/<fd>, and doing that for every fd of every process
+ * on every sample is expensive. Instead the fd list of each process is cached and only fds that weren't open on the
+ * previous sample are checked.
+ *
+ * That isn't exact - the kernel re-uses the lowest free fd number, so an fd can be closed and reopened as something
+ * else between samples without the fd list changing. To catch those, every fd of a process is re-checked every
+ * kRecheckSamples samples (staggered by PID so they don't all happen on the same sample). Callers should drop any
+ * matching fd that turns out to point at something else when they read it
+ */
+class FdTable
+{
+public:
+    static constexpr uint32_t kRecheckSamples = 10;
+
+    /**
+     * @param matches Called with the link target of each fd, e.g. "/dev/dri/card0"
+     */
+    explicit FdTable(std::function<bool(const char *target)> matches);
+
+    /**
+     * Re-read the fd list of the process
+     *
+     * @return The fds that match. Callers can erase any that turn out not to be what they expected
+     */
+    std::set<int> &Update(pid_t pid);
+
+    /**
+     * Forget any process not in running, so a re-used PID starts from scratch
+     */
+    void Prune(const std::set<pid_t> &running);
+
+private:
+    struct processFds
+    {
+        // All open fds on the last sample, sorted
+        std::vector<int> Fds;
+        std::set<int> Matching;
+        uint32_t Samples = 0;
+    };
+
+private:
+    const std::function<bool(const char *target)> mMatches;
+    std::map<pid_t, processFds> mProcesses;
+};
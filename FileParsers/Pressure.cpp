@@ -0,0 +1,112 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "Pressure.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+Pressure::Pressure(std::string path) : mPath(std::move(path)), mFd(-1), mSome(), mFull()
+{
+    mFd = open(mPath.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+Pressure::~Pressure()
+{
+    if (mFd >= 0) {
+        close(mFd);
+    }
+}
+
+Pressure::Pressure(Pressure &&other) noexcept
+        : mPath(std::move(other.mPath)),
+          mFd(other.mFd),
+          mSome(other.mSome),
+          mFull(other.mFull)
+{
+    other.mFd = -1;
+}
+
+bool Pressure::Reopen()
+{
+    if (mFd >= 0) {
+        close(mFd);
+    }
+
+    mFd = open(mPath.c_str(), O_RDONLY | O_CLOEXEC);
+    return mFd >= 0;
+}
+
+/**
+ * Re-read the PSI values from the file
+ *
+ * Example contents:
+ *
+ * some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+ * full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+ *
+ * The "full" line is missing for the cpu resource on older kernels
+ *
+ * @return false if the file could not be read (e.g. the cgroup was removed)
+ */
+bool Pressure::Read()
+{
+    if (mFd < 0) {
+        return false;
+    }
+
+    // Only ~100 bytes, so read in one go from the start of the file without needing to re-open it
+    char buffer[256];
+    ssize_t bytesRead = pread(mFd, buffer, sizeof(buffer) - 1, 0);
+    if (bytesRead <= 0) {
+        return false;
+    }
+    buffer[bytesRead] = '\0';
+
+    char *line = buffer;
+    while (line && *line) {
+        char *next = strchr(line, '\n');
+        if (next) {
+            *next++ = '\0';
+        }
+
+        pressureLine *target = nullptr;
+        if (strncmp(line, "some ", 5) == 0) {
+            target = &mSome;
+        } else if (strncmp(line, "full ", 5) == 0) {
+            target = &mFull;
+        }
+
+        if (target) {
+            pressureLine tmp;
+            if (sscanf(line + 5, "avg10=%lf avg60=%lf avg300=%lf total=%" SCNu64, &tmp.avg10, &tmp.avg60,
+                       &tmp.avg300, &tmp.total) == 4) {
+                *target = tmp;
+            }
+        }
+
+        line = next;
+    }
+
+    return true;
+}
@@ -0,0 +1,116 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+/**
+ * Parser for a pressure stall information (PSI) file - either /proc/pressure/<resource> or a cgroup v2
+ * <resource>.pressure file
+ *
+ * Unlike the other parsers, the file is held open and re-read with each call to Read() since PSI is designed to be
+ * polled frequently
+ */
+class Pressure
+{
+public:
+    explicit Pressure(std::string path);
+
+    ~Pressure();
+
+    Pressure(const Pressure &) = delete;
+
+    Pressure &operator=(const Pressure &) = delete;
+
+    Pressure(Pressure &&other) noexcept;
+
+    bool IsOpen() const
+    {
+        return mFd >= 0;
+    }
+
+    bool Read();
+
+    /**
+     * Close and re-open the file, e.g. if the cgroup has been removed and re-created under the same path
+     *
+     * @return false if the file could not be opened
+     */
+    bool Reopen();
+
+    double SomeAvg10() const
+    {
+        return mSome.avg10;
+    }
+
+    double SomeAvg60() const
+    {
+        return mSome.avg60;
+    }
+
+    double SomeAvg300() const
+    {
+        return mSome.avg300;
+    }
+
+    // Total stall time in microseconds
+    uint64_t SomeTotalUs() const
+    {
+        return mSome.total;
+    }
+
+    double FullAvg10() const
+    {
+        return mFull.avg10;
+    }
+
+    double FullAvg60() const
+    {
+        return mFull.avg60;
+    }
+
+    double FullAvg300() const
+    {
+        return mFull.avg300;
+    }
+
+    // Total stall time in microseconds
+    uint64_t FullTotalUs() const
+    {
+        return mFull.total;
+    }
+
+private:
+    struct pressureLine
+    {
+        double avg10 = 0;
+        double avg60 = 0;
+        double avg300 = 0;
+        uint64_t total = 0;
+    };
+
+private:
+    std::string mPath;
+    int mFd;
+
+    pressureLine mSome;
+    pressureLine mFull;
+};
@@ -0,0 +1,74 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "ProcStat.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+ProcStat::ProcStat(pid_t pid) : mPid(pid), mValid(false), mComm(), mState('?'), mPpid(0), mFlags(0), mMinorFaults(0),
+                                mMajorFaults(0), mUserTime(0), mSystemTime(0)
+{
+    parseStat();
+}
+
+/**
+ * The stat file is a single line. The comm field is wrapped in parentheses but can itself contain spaces and
+ * parentheses, so find the last ')' and parse the rest of the fields from there in one go
+ *
+ * 1234 (my (weird) name) S 1 1234 1234 0 -1 4194560 1010 0 2 0 31 12 ...
+ */
+void ProcStat::parseStat()
+{
+    char filePath[PATH_MAX];
+    snprintf(filePath, sizeof(filePath), "/proc/%d/stat", mPid);
+
+    int fd = open(filePath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        // Process might have died, don't log anything
+        return;
+    }
+
+    char buffer[1024];
+    ssize_t bytesRead = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+
+    if (bytesRead <= 0) {
+        return;
+    }
+    buffer[bytesRead] = '\0';
+
+    char *commStart = strchr(buffer, '(');
+    char *commEnd = strrchr(buffer, ')');
+    if (!commStart || !commEnd || commEnd < commStart) {
+        return;
+    }
+
+    mComm.assign(commStart + 1, commEnd - commStart - 1);
+
+    // Fields 3 - 15: state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt utime stime
+    if (sscanf(commEnd + 1, " %c %d %*d %*d %*d %*d %u %" SCNu64 " %*u %" SCNu64 " %*u %" SCNu64 " %" SCNu64, &mState,
+               &mPpid, &mFlags, &mMinorFaults, &mMajorFaults, &mUserTime, &mSystemTime) == 7) {
+        mValid = true;
+    }
+}
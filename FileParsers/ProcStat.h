@@ -0,0 +1,98 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <sys/types.h>
+#include <cstdint>
+#include <string>
+
+/**
+ * Parser for /proc/<pid>/stat
+ *
+ * Only the fields up to stime are parsed. Times are in clock ticks (see sysconf(_SC_CLK_TCK))
+ */
+class ProcStat
+{
+public:
+    explicit ProcStat(pid_t pid);
+
+    bool IsValid() const
+    {
+        return mValid;
+    }
+
+    // Name of the executable, truncated to 15 characters by the kernel. Unlike cmdline, this is set for kernel threads
+    const std::string &Comm() const
+    {
+        return mComm;
+    }
+
+    char State() const
+    {
+        return mState;
+    }
+
+    pid_t Ppid() const
+    {
+        return mPpid;
+    }
+
+    // PF_* flags from the kernel task struct
+    unsigned int Flags() const
+    {
+        return mFlags;
+    }
+
+    uint64_t MinorFaults() const
+    {
+        return mMinorFaults;
+    }
+
+    uint64_t MajorFaults() const
+    {
+        return mMajorFaults;
+    }
+
+    uint64_t UserTimeTicks() const
+    {
+        return mUserTime;
+    }
+
+    uint64_t SystemTimeTicks() const
+    {
+        return mSystemTime;
+    }
+
+private:
+    void parseStat();
+
+private:
+    pid_t mPid;
+    bool mValid;
+
+    std::string mComm;
+    char mState;
+    pid_t mPpid;
+    unsigned int mFlags;
+    uint64_t mMinorFaults;
+    uint64_t mMajorFaults;
+    uint64_t mUserTime;
+    uint64_t mSystemTime;
+};
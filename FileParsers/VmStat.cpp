@@ -0,0 +1,81 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "VmStat.h"
+
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include "Log.h"
+
+VmStat::VmStat() : mCounters()
+{
+    parseVmStat();
+}
+
+uint64_t VmStat::Get(const std::string &name) const
+{
+    auto itr = mCounters.find(name);
+    if (itr == mCounters.end()) {
+        return 0;
+    }
+
+    return itr->second;
+}
+
+/**
+ * Each line of /proc/vmstat is "<name> <value>". There are 100-200 lines depending on kernel version, so avoid
+ * sscanf and split each line manually
+ */
+void VmStat::parseVmStat()
+{
+    std::ifstream vmstat("/proc/vmstat");
+    if (!vmstat) {
+        LOG_WARN("Failed to open /proc/vmstat");
+        return;
+    }
+
+    std::stringstream buffer;
+    buffer << vmstat.rdbuf();
+    const std::string contents = buffer.str();
+
+    mCounters.reserve(256);
+
+    const char *line = contents.c_str();
+    while (*line) {
+        const char *space = strchr(line, ' ');
+        if (!space) {
+            break;
+        }
+
+        char *end;
+        uint64_t value = strtoull(space + 1, &end, 10);
+        if (end != space + 1) {
+            mCounters.emplace(std::string(line, space - line), value);
+        }
+
+        // Move to the start of the next line
+        const char *next = strchr(end, '\n');
+        if (!next) {
+            break;
+        }
+        line = next + 1;
+    }
+}
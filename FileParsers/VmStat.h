@@ -0,0 +1,49 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Parser for /proc/vmstat. All counters are read in a single pass - use Get() to look up the value of a counter.
+ *
+ * Counter names and availability vary between kernel versions (e.g. some counters are split per-zone on older
+ * kernels), so missing counters are treated as 0
+ */
+class VmStat
+{
+public:
+    VmStat();
+
+    bool IsValid() const
+    {
+        return !mCounters.empty();
+    }
+
+    uint64_t Get(const std::string &name) const;
+
+private:
+    void parseVmStat();
+
+private:
+    std::unordered_map<std::string, uint64_t> mCounters;
+};
@@ -0,0 +1,55 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <sys/types.h>
+#include <map>
+#include <mutex>
+
+/**
+ * @brief The most recent GPU memory usage per process
+ *
+ * GPU usage is collected by MemoryMetric but is needed by ProcessMetric to calculate each process' total footprint.
+ * MemoryMetric publishes the values it read on each tick and ProcessMetric reads them on its own tick
+ */
+class GpuMemorySnapshot
+{
+public:
+    void Publish(const std::map<pid_t, long double> &usageKb)
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mUsageKb = usageKb;
+    }
+
+    /**
+     * @return GPU memory used by the process in KB, or 0 if the process has no GPU allocations
+     */
+    long double UsageKb(pid_t pid) const
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+
+        auto itr = mUsageKb.find(pid);
+        return itr != mUsageKb.end() ? itr->second : 0;
+    }
+
+private:
+    mutable std::mutex mLock;
+    std::map<pid_t, long double> mUsageKb;
+};
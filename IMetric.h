@@ -31,19 +31,31 @@ public:
     virtual ~IMetric() = default;
 
     /**
-     * @brief Start collecting data every X seconds and store the results in memory
+     * @brief Start collecting data every X milliseconds and store the results in memory
      *
      * It is expected this will start a new thread and return
      *
      * @param[in]   frequency   How often to collect the data
      */
-    virtual void StartCollection(std::chrono::seconds frequency) = 0;
+    virtual void StartCollection(std::chrono::milliseconds frequency) = 0;
 
     /**
      * @brief Stop any running data collection
      */
     virtual void StopCollection() = 0;
 
+    /**
+     * @brief Temporarily collect data more frequently, for example when the system comes under memory pressure
+     *
+     * The metric should collect data as soon as possible, then use the burst interval for a short period before
+     * returning to the normal frequency. Metrics that don't support this can ignore it
+     *
+     * @param[in]   interval    How often to collect data during the burst
+     */
+    virtual void RequestBurst([[maybe_unused]] std::chrono::milliseconds interval)
+    {
+    }
+
     /**
      * Print the results of the data collection to stdout
      *
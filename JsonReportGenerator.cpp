@@ -21,13 +21,31 @@
 #include "JsonReportGenerator.h"
 #include "Log.h"
 
+#include <cmath>
 #include <utility>
 
+// Enough points for a chart to keep its shape, however long the capture ran for
+static constexpr size_t kMaxChartPoints = 1000;
+
 JsonReportGenerator::JsonReportGenerator(std::shared_ptr<Metadata> metadata,
                                          std::optional<std::shared_ptr<GroupManager>> groupManager)
-        : mMetadata(std::move(metadata)), mGroupManager(std::move(groupManager)), mJson()
+        : mMetadata(std::move(metadata)), mGroupManager(std::move(groupManager)), mJson(),
+          mStartTime(std::chrono::steady_clock::now()), mCollectorStats(std::make_shared<CollectorStats>()),
+          mPhases(nlohmann::json::array())
 {
+    reset();
+}
+
+/**
+ * Clear everything added by the metrics so the results can be saved again, used when writing a snapshot
+ * without stopping the capture
+ */
+void JsonReportGenerator::reset()
+{
+    mJson = nlohmann::json();
+
     mJson["processes"] = nlohmann::json::array();
+    mJson["timeSeries"] = nlohmann::json::array();
     mJson["metadata"] = {};
     mJson["cpuIdleStats"] = nullptr;
 
@@ -72,6 +90,10 @@ void JsonReportGenerator::addDataset(const std::string &name, const std::vector<
                         tmp[v.GetName()]["Min"] = v.GetMinRounded();
                         tmp[v.GetName()]["Max"] = v.GetMaxRounded();
                         tmp[v.GetName()]["Average"] = v.GetAverageRounded();
+                        // Not shown in the tables, but needed to tell whether a change between captures is significant
+                        tmp[v.GetName()]["StdDev"] = (double) std::round(v.GetStdDev() * 100) / 100;
+                        tmp[v.GetName()]["Samples"] = v.GetCount();
+                        tmp[v.GetName()]["EffectiveSamples"] = std::round(v.GetEffectiveCount() * 10) / 10;
 
                         if (!setColumnOrder) {
                             dataSet["_columnOrder"].emplace_back(v.GetName() + " (Min)");
@@ -88,6 +110,35 @@ void JsonReportGenerator::addDataset(const std::string &name, const std::vector<
     mJson["data"].emplace_back(dataSet);
 }
 
+/**
+ * Add a chart of one or more time series. Each series will be drawn as a separate line on the same chart, with
+ * the x-axis in seconds since the start of the capture
+ */
+void JsonReportGenerator::addTimeSeries(const std::string &name, const std::vector<TimeSeries> &series)
+{
+    if (series.empty()) {
+        return;
+    }
+
+    nlohmann::json chart;
+    chart["name"] = name;
+    chart["series"] = nlohmann::json::array();
+
+    for (const auto &s: series) {
+        if (s.GetCount() == 0) {
+            continue;
+        }
+
+        chart["series"].push_back({
+                {"name", s.GetName()},
+                {"data", s.ToJson(mStartTime, kMaxChartPoints)}
+        });
+    }
+
+    if (!chart["series"].empty()) {
+        mJson["timeSeries"].emplace_back(chart);
+    }
+}
 
 nlohmann::json JsonReportGenerator::getJson()
 {
@@ -100,6 +151,13 @@ nlohmann::json JsonReportGenerator::getJson()
             {"swapEnabled", mMetadata->SwapEnabled()}
     };
 
+    mJson["collectorStats"] = mCollectorStats->ToJson();
+
+    {
+        std::lock_guard<std::mutex> locker(mPhaseLock);
+        mJson["phases"] = mPhases;
+    }
+
     return mJson;
 }
 
@@ -134,16 +192,52 @@ void JsonReportGenerator::addProcesses(std::vector<processMeasurement> &processe
 
         processJson["rss"] = process.Rss.ToJson();
         processJson["pss"] = process.Pss.ToJson();
+        processJson["gpu"] = process.Gpu.ToJson();
+        processJson["dmabuf"] = process.DmaBuf.ToJson();
+        processJson["footprint"] = process.Footprint.ToJson();
+        processJson["minorFaults"] = process.MinorFaults.ToJson(2);
+        processJson["majorFaults"] = process.MajorFaults.ToJson(2);
+        processJson["cpuUser"] = process.CpuUser.ToJson(2);
+        processJson["cpuSystem"] = process.CpuSystem.ToJson(2);
         processJson["uss"] = process.Uss.ToJson();
         processJson["vss"] = process.Vss.ToJson();
         processJson["swap"] = process.Swap.ToJson();
         processJson["swapPss"] = process.SwapPss.ToJson();
         processJson["swapZram"] = process.SwapZram.ToJson();
         processJson["locked"] = process.Locked.ToJson();
+        processJson["pssTrend"] = process.PssTrend.ToJson();
 
         mJson["processes"].emplace_back(processJson);
     }
 
+    // Processes ranked by total footprint, split into PSS, GPU and DMA-BUF so the chart shows where the memory is
+    std::vector<const processMeasurement *> byFootprint;
+    byFootprint.reserve(processes.size());
+    for (const auto &process: processes) {
+        byFootprint.emplace_back(&process);
+    }
+
+    std::sort(byFootprint.begin(), byFootprint.end(), [](const processMeasurement *a, const processMeasurement *b)
+    {
+        return a->Footprint.GetAverageRounded() > b->Footprint.GetAverageRounded();
+    });
+
+    if (byFootprint.size() > 20) {
+        byFootprint.resize(20);
+    }
+
+    mJson["footprintTop"] = nlohmann::json::array();
+    for (const auto *process: byFootprint) {
+        nlohmann::json tmp;
+        tmp["name"] = process->ProcessInfo.name();
+        tmp["pss"] = process->Pss.GetAverageRounded();
+        tmp["gpu"] = process->Gpu.GetAverageRounded();
+        tmp["dmabuf"] = process->DmaBuf.GetAverageRounded();
+        tmp["footprint"] = process->Footprint.GetAverageRounded();
+
+        mJson["footprintTop"].emplace_back(tmp);
+    }
+
 
     // Calculate PSS memory per group
     if (mGroupManager.has_value()) {
@@ -183,6 +277,15 @@ void JsonReportGenerator::addProcesses(std::vector<processMeasurement> &processe
 
 }
 
+void JsonReportGenerator::addPhase(const std::string &name)
+{
+    auto offsetMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - mStartTime).count();
+
+    std::lock_guard<std::mutex> locker(mPhaseLock);
+    mPhases.push_back({{"name", name}, {"time", offsetMs / 1000.0}});
+}
+
 void JsonReportGenerator::setAverageLinuxMemoryUsage(int valueKb)
 {
     // Store in MB
@@ -20,13 +20,19 @@
 
 #pragma once
 
+#include <mutex>
 #include <variant>
 
 #include "nlohmann/json.hpp"
 
 #include "ProcessMeasurement.h"
+#include "TimeSeries.h"
 #include "GroupManager.h"
 #include "Metadata.h"
+#include "CollectorStats.h"
+#include "CounterTraceWriter.h"
+#include "MetricsExporter.h"
+#include "StreamWriter.h"
 
 #ifdef ENABLE_CPU_IDLE_METRICS
 #include <sys/prctl.h>
@@ -53,10 +59,14 @@ public:
 
     JsonReportGenerator(std::shared_ptr<Metadata> metadata, std::optional<std::shared_ptr<GroupManager>> groupManager);
 
+    void reset();
+
     void addDataset(const std::string& name, const std::vector<dataItems>& data);
 
     void addProcesses(std::vector<processMeasurement> &processes);
 
+    void addTimeSeries(const std::string &name, const std::vector<TimeSeries> &series);
+
 #ifdef ENABLE_CPU_IDLE_METRICS
     void addCpuIdleMetrics(const IDLE_METRICS_V2& metrics);
 #endif
@@ -65,6 +75,63 @@ public:
 
     void addToAccumulatedMemoryUsage(long double valueKb);
 
+    /**
+     * Mark the start of a new phase of the capture (e.g. a test case), kept across resets
+     */
+    void addPhase(const std::string &name);
+
+    /**
+     * Collection latency for each data source, shared with the metrics so they can record into it
+     */
+    std::shared_ptr<CollectorStats> collectorStats() const
+    {
+        return mCollectorStats;
+    }
+
+    const std::optional<std::shared_ptr<GroupManager>> &groupManager() const
+    {
+        return mGroupManager;
+    }
+
+    /**
+     * Optional timeline of every counter as it's collected, null if not enabled
+     */
+    std::shared_ptr<CounterTraceWriter> counterTrace() const
+    {
+        return mCounterTrace;
+    }
+
+    void setCounterTrace(std::shared_ptr<CounterTraceWriter> counterTrace)
+    {
+        mCounterTrace = std::move(counterTrace);
+    }
+
+    /**
+     * Optional live gauges for Prometheus, null if not enabled
+     */
+    std::shared_ptr<MetricsExporter> metricsExporter() const
+    {
+        return mMetricsExporter;
+    }
+
+    void setMetricsExporter(std::shared_ptr<MetricsExporter> metricsExporter)
+    {
+        mMetricsExporter = std::move(metricsExporter);
+    }
+
+    /**
+     * Optional newline-delimited JSON output of each sample as it's taken, null if not enabled
+     */
+    std::shared_ptr<StreamWriter> streamWriter() const
+    {
+        return mStreamWriter;
+    }
+
+    void setStreamWriter(std::shared_ptr<StreamWriter> streamWriter)
+    {
+        mStreamWriter = std::move(streamWriter);
+    }
+
     nlohmann::json getJson();
 
 private:
@@ -73,5 +140,16 @@ private:
 
     nlohmann::json mJson;
 
+    const std::chrono::steady_clock::time_point mStartTime;
+
     std::vector<Process> mProcesses;
+
+    const std::shared_ptr<CollectorStats> mCollectorStats;
+
+    std::shared_ptr<CounterTraceWriter> mCounterTrace;
+    std::shared_ptr<MetricsExporter> mMetricsExporter;
+    std::shared_ptr<StreamWriter> mStreamWriter;
+
+    std::mutex mPhaseLock;
+    nlohmann::json mPhases;
 };
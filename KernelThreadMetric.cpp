@@ -0,0 +1,204 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "KernelThreadMetric.h"
+#include "FileParsers/ProcStat.h"
+#include "Log.h"
+#include "RollingWindow.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <regex>
+#include <unistd.h>
+
+// From include/linux/sched.h - set for all kernel threads
+static constexpr unsigned int PF_KTHREAD = 0x00200000;
+
+// Memory management threads are plotted over time as well as summarised in the table
+static const std::regex kMemoryThreadRegex("^(kswapd|kcompactd|zram|zswap|oom_reaper|writeback|kworker.*(zram|writeback))");
+
+KernelThreadMetric::KernelThreadMetric(std::shared_ptr<JsonReportGenerator> reportGenerator)
+        : mQuit(false),
+          mCv(),
+          mMeasurements{},
+          mPrune(false),
+          mReportGenerator(std::move(reportGenerator))
+{
+
+}
+
+KernelThreadMetric::~KernelThreadMetric()
+{
+    if (!mQuit) {
+        StopCollection();
+    }
+}
+
+void KernelThreadMetric::EnablePruning()
+{
+    mPrune = true;
+}
+
+void KernelThreadMetric::StartCollection(const std::chrono::milliseconds frequency)
+{
+    mQuit = false;
+    mCollectionThread = std::thread(&KernelThreadMetric::CollectData, this, frequency);
+}
+
+void KernelThreadMetric::StopCollection()
+{
+    std::unique_lock<std::mutex> locker(mLock);
+    mQuit = true;
+    mCv.notify_all();
+    locker.unlock();
+
+    if (mCollectionThread.joinable()) {
+        LOG_INFO("Waiting for KernelThreadMetric collection thread to terminate");
+        mCollectionThread.join();
+    }
+}
+
+void KernelThreadMetric::CollectData(std::chrono::milliseconds frequency)
+{
+    std::unique_lock<std::mutex> lock(mLock);
+
+    static const long double clockTicksPerSecond = sysconf(_SC_CLK_TCK);
+
+    do {
+        std::error_code ec;
+        for (const auto &entry: std::filesystem::directory_iterator("/proc", ec)) {
+            const auto name = entry.path().filename().string();
+            if (name.empty() || !std::all_of(name.begin(), name.end(), ::isdigit)) {
+                continue;
+            }
+
+            pid_t pid = std::stoi(name);
+            ProcStat stat(pid);
+            if (!stat.IsValid() || !(stat.Flags() & PF_KTHREAD)) {
+                continue;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            uint64_t ticks = stat.UserTimeTicks() + stat.SystemTimeTicks();
+
+            auto itr = mMeasurements.find(pid);
+            if (itr == mMeasurements.end() || itr->second.LastTicks > ticks) {
+                // New thread (or the PID has been re-used), nothing to compare against yet
+                if (itr != mMeasurements.end()) {
+                    mMeasurements.erase(itr);
+                }
+
+                kernelThreadMeasurement measurement(stat.Comm());
+                if (mPrune) {
+                    measurement.Series.SetRetention(RollingWindow::kMaxWindow);
+                }
+                measurement.LastTicks = ticks;
+                measurement.LastSampleTime = now;
+                measurement.LastSeen = now;
+                mMeasurements.emplace(pid, std::move(measurement));
+                continue;
+            }
+
+            auto &measurement = itr->second;
+            auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    now - measurement.LastSampleTime).count();
+
+            if (elapsedMs > 0) {
+                uint64_t delta = ticks - measurement.LastTicks;
+                long double cpuMsPerSecond = (delta * 1000.0L / clockTicksPerSecond) / (elapsedMs / 1000.0L);
+
+                measurement.TotalTicks += delta;
+                measurement.Cpu.AddDataPoint(cpuMsPerSecond);
+
+                if (std::regex_search(measurement.Name, kMemoryThreadRegex)) {
+                    measurement.Series.AddDataPoint(cpuMsPerSecond);
+                }
+            }
+
+            // kworker names change depending on the work they're doing, so keep the latest
+            measurement.Name = stat.Comm();
+            measurement.LastTicks = ticks;
+            measurement.LastSampleTime = now;
+            measurement.LastSeen = now;
+        }
+
+        if (mPrune) {
+            PruneExitedThreads();
+        }
+
+        // Wait for period before doing collection again, or until cancelled
+        mCv.wait_for(lock, frequency);
+    } while (!mQuit);
+
+    LOG_INFO("Collection thread quit");
+}
+
+void KernelThreadMetric::PruneExitedThreads()
+{
+    auto now = std::chrono::steady_clock::now();
+
+    for (auto itr = mMeasurements.begin(); itr != mMeasurements.end();) {
+        if (now - itr->second.LastSeen > RollingWindow::kMaxWindow) {
+            itr = mMeasurements.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
+
+void KernelThreadMetric::SaveResults()
+{
+    // Can be called whilst collection is running when saving a snapshot
+    std::lock_guard<std::mutex> locker(mLock);
+
+    static const long double clockTicksPerSecond = sysconf(_SC_CLK_TCK);
+
+    // Only report threads that actually did something, busiest first
+    std::vector<std::pair<pid_t, const kernelThreadMeasurement *>> active;
+    for (const auto &measurement: mMeasurements) {
+        if (measurement.second.TotalTicks > 0) {
+            active.emplace_back(measurement.first, &measurement.second);
+        }
+    }
+
+    std::sort(active.begin(), active.end(), [](const auto &a, const auto &b)
+    {
+        return a.second->TotalTicks > b.second->TotalTicks;
+    });
+
+    std::vector<JsonReportGenerator::dataItems> data{};
+    std::vector<TimeSeries> memoryThreadSeries{};
+
+    for (const auto &thread: active) {
+        data.emplace_back(JsonReportGenerator::dataItems{
+                std::make_pair("PID", std::to_string(thread.first)),
+                std::make_pair("Thread", thread.second->Name),
+                thread.second->Cpu,
+                std::make_pair("Total_CPU_ms",
+                               std::to_string((long long) (thread.second->TotalTicks * 1000.0L / clockTicksPerSecond)))
+        });
+
+        if (thread.second->Series.GetCount() > 0) {
+            memoryThreadSeries.emplace_back(thread.second->Series);
+        }
+    }
+
+    mReportGenerator->addDataset("Kernel Threads", data);
+    mReportGenerator->addTimeSeries("Memory Management Kernel Threads CPU (ms/s)", memoryThreadSeries);
+}
@@ -0,0 +1,100 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "IMetric.h"
+
+#include <thread>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include "JsonReportGenerator.h"
+#include "Measurement.h"
+#include "TimeSeries.h"
+
+/**
+ * @brief Tracks the CPU usage of kernel threads such as kswapd, kcompactd and zram workers
+ *
+ * Kernel threads have no cmdline and no userspace memory so are skipped by Procrank, but the CPU time spent in memory
+ * management threads is a good indicator of how much memory pressure is costing the system
+ */
+class KernelThreadMetric : public IMetric
+{
+public:
+    explicit KernelThreadMetric(std::shared_ptr<JsonReportGenerator> reportGenerator);
+
+    ~KernelThreadMetric() override;
+
+    void StartCollection(std::chrono::milliseconds frequency) override;
+
+    void StopCollection() override;
+
+    void SaveResults() override;
+
+    /**
+     * Forget threads that haven't been seen for longer than the largest rolling window, as kworkers come and go all
+     * the time, and only chart the largest window. Used when running indefinitely. Must be called before collection
+     * starts
+     */
+    void EnablePruning();
+
+private:
+    struct kernelThreadMeasurement
+    {
+        explicit kernelThreadMeasurement(std::string name)
+                : Name(std::move(name)),
+                  Cpu("Cpu_ms_per_s"),
+                  Series(Name)
+        {
+        }
+
+        std::string Name;
+        Measurement Cpu;
+
+        // Only populated for memory management threads
+        TimeSeries Series;
+
+        // Total CPU time (in clock ticks) used during the capture
+        uint64_t TotalTicks = 0;
+
+        uint64_t LastTicks = 0;
+        std::chrono::steady_clock::time_point LastSampleTime;
+
+        // Updated on every sample the thread is found in
+        std::chrono::steady_clock::time_point LastSeen;
+    };
+
+private:
+    void CollectData(std::chrono::milliseconds frequency);
+
+    void PruneExitedThreads();
+
+private:
+    std::thread mCollectionThread;
+    bool mQuit;
+    std::condition_variable mCv;
+    std::mutex mLock;
+
+    std::map<pid_t, kernelThreadMeasurement> mMeasurements;
+
+    bool mPrune;
+
+    const std::shared_ptr<JsonReportGenerator> mReportGenerator;
+};
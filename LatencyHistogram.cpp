@@ -0,0 +1,100 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram() : mBuckets{}, mCount(0), mMaxUs(0), mTotalUs(0)
+{
+}
+
+/**
+ * Values below 4us get a bucket each. Above that, the bucket is found from the position of the highest set bit
+ * (the power of two) and the next two bits (which quarter of that range the value falls in)
+ */
+size_t LatencyHistogram::bucketIndex(uint64_t us)
+{
+    if (us < kSubBuckets) {
+        return us;
+    }
+
+    size_t power = 63 - __builtin_clzll(us);
+    if (power >= kMaxPower) {
+        return kBucketCount - 1;
+    }
+
+    size_t subBucket = (us >> (power - 2)) & (kSubBuckets - 1);
+    return kSubBuckets + (power - 2) * kSubBuckets + subBucket;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index)
+{
+    if (index < kSubBuckets) {
+        return index + 1;
+    }
+
+    size_t power = (index - kSubBuckets) / kSubBuckets + 2;
+    size_t subBucket = (index - kSubBuckets) % kSubBuckets;
+
+    return (1ULL << power) + (subBucket + 1) * (1ULL << (power - 2));
+}
+
+void LatencyHistogram::Record(std::chrono::microseconds latency)
+{
+    auto us = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+
+    mBuckets[bucketIndex(us)]++;
+    mCount++;
+    mMaxUs = std::max(mMaxUs, us);
+    mTotalUs += us;
+}
+
+uint64_t LatencyHistogram::GetPercentileUs(double percentile) const
+{
+    if (mCount == 0) {
+        return 0;
+    }
+
+    auto target = static_cast<uint64_t>(std::max(1.0, (percentile / 100.0) * mCount + 0.5));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; i++) {
+        seen += mBuckets[i];
+        if (seen >= target) {
+            // Don't report a value bigger than anything we've actually seen
+            return std::min(bucketUpperBound(i), mMaxUs);
+        }
+    }
+
+    return mMaxUs;
+}
+
+nlohmann::json LatencyHistogram::BucketsToJson() const
+{
+    auto buckets = nlohmann::json::array();
+
+    for (size_t i = 0; i < kBucketCount; i++) {
+        if (mBuckets[i] > 0) {
+            buckets.push_back({bucketUpperBound(i), mBuckets[i]});
+        }
+    }
+
+    return buckets;
+}
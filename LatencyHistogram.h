@@ -0,0 +1,81 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief Fixed size log-linear histogram of latencies
+ *
+ * Each power of two range of microseconds is split into 4 linear buckets, which keeps the relative error of any
+ * percentile below 25% whilst using a fixed amount of memory regardless of how many samples are recorded. Covers
+ * 1us up to ~4.5 minutes, anything longer goes in the last bucket
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void Record(std::chrono::microseconds latency);
+
+    uint64_t GetCount() const
+    {
+        return mCount;
+    }
+
+    /**
+     * @param percentile 0 - 100
+     * @return Upper bound of the bucket containing the percentile, in microseconds
+     */
+    uint64_t GetPercentileUs(double percentile) const;
+
+    uint64_t GetMaxUs() const
+    {
+        return mMaxUs;
+    }
+
+    long double GetMeanUs() const
+    {
+        return mCount > 0 ? mTotalUs / (long double) mCount : 0;
+    }
+
+    /**
+     * Non-empty buckets as an array of [upper bound us, count]
+     */
+    nlohmann::json BucketsToJson() const;
+
+private:
+    static constexpr size_t kSubBuckets = 4;
+    static constexpr size_t kMaxPower = 28;
+    static constexpr size_t kBucketCount = kSubBuckets + (kMaxPower - 2) * kSubBuckets;
+
+    static size_t bucketIndex(uint64_t us);
+
+    static uint64_t bucketUpperBound(size_t index);
+
+private:
+    std::array<uint64_t, kBucketCount> mBuckets;
+    uint64_t mCount;
+    uint64_t mMaxUs;
+    long double mTotalUs;
+};
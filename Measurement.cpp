@@ -18,6 +18,7 @@
 */
 
 #include "Measurement.h"
+#include <algorithm>
 #include <limits>
 #include <utility>
 #include <cmath>
@@ -28,7 +29,11 @@ Measurement::Measurement(std::string name)
           mMin(std::numeric_limits<double>::max()),
           mMax(std::numeric_limits<double>::min()),
           mAverage(0),
-          mTotal(0)
+          mTotal(0),
+          mLast(0),
+          mM2(0),
+          mFirst(0),
+          mSumLagProduct(0)
 {
 
 }
@@ -47,11 +52,20 @@ void Measurement::AddDataPoint(long double value)
         mMax = value;
     }
 
+    if (mCount == 0) {
+        mFirst = value;
+    } else {
+        mSumLagProduct += (value - mFirst) * (mLast - mFirst);
+    }
+
     // TODO:: This is simplistic and has the potential for overflowing for long data collection sessions.
     mTotal += value;
     mCount++;
+    mLast = value;
 
+    auto previousAverage = mAverage;
     mAverage = mTotal / mCount;
+    mM2 += (value - previousAverage) * (value - mAverage);
 }
 
 long double Measurement::GetMin() const
@@ -61,6 +75,10 @@ long double Measurement::GetMin() const
 
 int Measurement::GetMinRounded() const
 {
+    if (mCount == 0) {
+        return 0;
+    }
+
     return (int) std::round(mMin);
 }
 
@@ -71,6 +89,10 @@ long double Measurement::GetMax() const
 
 int Measurement::GetMaxRounded() const
 {
+    if (mCount == 0) {
+        return 0;
+    }
+
     return (int) std::round(mMax);
 }
 
@@ -84,16 +106,83 @@ int Measurement::GetAverageRounded() const
     return (int) std::round(mAverage);
 }
 
+/**
+ * @return The most recently added data point
+ */
+long double Measurement::GetLast() const
+{
+    return mLast;
+}
+
+long double Measurement::GetStdDev() const
+{
+    if (mCount < 2) {
+        return 0;
+    }
+
+    return std::sqrt(mM2 / (mCount - 1));
+}
+
+/**
+ * @return Number of data points added
+ */
+int Measurement::GetCount() const
+{
+    return mCount;
+}
+
+/**
+ * Samples taken a second apart are far from independent, so the standard error of the average is larger than
+ * stdDev / sqrt(count) suggests. Estimate the lag-1 autocorrelation r and use the AR(1) approximation
+ * count * (1 - r) / (1 + r)
+ */
+double Measurement::GetEffectiveCount() const
+{
+    if (mCount < 3 || mM2 <= 0) {
+        return mCount;
+    }
+
+    // Sum of (x[i] - mean) * (x[i-1] - mean) over consecutive pairs, expanded so it can be found from running sums
+    long double mean = mAverage - mFirst;
+    long double sum = mTotal - mCount * mFirst;
+    long double sumPrevious = sum - (mLast - mFirst);
+    long double autocovariance = mSumLagProduct - mean * (sum + sumPrevious) + (mCount - 1) * mean * mean;
+
+    // Negative correlation would make the samples worth more than their count, which we don't trust
+    double r = std::clamp((double) (autocovariance / mM2), 0.0, 0.99);
+    return std::max(1.0, mCount * (1 - r) / (1 + r));
+}
+
 std::string Measurement::GetName() const
 {
     return mName;
 }
 
-nlohmann::json Measurement::ToJson() const
+nlohmann::json Measurement::ToJson(int decimals) const
 {
+    if (decimals <= 0) {
+        return {
+                {"min",              GetMinRounded()},
+                {"max",              GetMaxRounded()},
+                {"average",          GetAverageRounded()},
+                {"stdDev",           (double) std::round(GetStdDev() * 100) / 100},
+                {"samples",          GetCount()},
+                {"effectiveSamples", std::round(GetEffectiveCount() * 10) / 10}
+        };
+    }
+
+    double scale = std::pow(10.0, decimals);
+    auto round = [scale](long double value)
+    {
+        return (double) (std::round(value * scale) / scale);
+    };
+
     return {
-            {"min",     GetMinRounded()},
-            {"max",     GetMaxRounded()},
-            {"average", GetAverageRounded()}
+            {"min",              mCount == 0 ? 0 : round(mMin)},
+            {"max",              mCount == 0 ? 0 : round(mMax)},
+            {"average",          round(mAverage)},
+            {"stdDev",           (double) std::round(GetStdDev() * 100) / 100},
+            {"samples",          GetCount()},
+            {"effectiveSamples", std::round(GetEffectiveCount() * 10) / 10}
     };
 }
\ No newline at end of file
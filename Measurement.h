@@ -44,9 +44,27 @@ public:
     long double GetAverage() const;
     int GetAverageRounded() const;
 
+    long double GetLast() const;
+
+    /**
+     * Sample standard deviation of the data points, 0 if there are fewer than two
+     */
+    long double GetStdDev() const;
+
+    int GetCount() const;
+
+    /**
+     * Number of independent samples the data points are worth, allowing for each one being correlated with the last
+     */
+    double GetEffectiveCount() const;
+
     std::string GetName() const;
 
-    nlohmann::json ToJson() const;
+    /**
+     * Min/max/average are rounded to whole numbers by default, which is fine for sizes in KB. Rates that are often
+     * below 1 (e.g. page faults per second) need some decimal places to be distinguishable from 0
+     */
+    nlohmann::json ToJson(int decimals = 0) const;
 
 private:
     std::string mName;
@@ -57,4 +75,12 @@ private:
 
     long double mAverage;
     long double mTotal;
+    long double mLast;
+
+    // Sum of squared differences from the mean, updated incrementally (Welford's method)
+    long double mM2;
+
+    // Sum of the products of consecutive data points, offset by the first data point to keep the sums small
+    long double mFirst;
+    long double mSumLagProduct;
 };
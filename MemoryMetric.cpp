@@ -19,24 +19,89 @@
 
 #include "MemoryMetric.h"
 #include "FileParsers/MemInfo.h"
+#include "FileParsers/VmStat.h"
 #include <thread>
 #include <fstream>
 #include <filesystem>
 #include <unistd.h>
 #include <cmath>
 #include <regex>
+#include <set>
 
-MemoryMetric::MemoryMetric(Platform platform, std::shared_ptr<JsonReportGenerator> reportGenerator)
+// How long to stay at the burst interval after the last request before decaying back to normal
+static constexpr std::chrono::seconds kBurstHoldTime(5);
+
+// How long to wait for each source before giving up on it for this sample. debugfs sources can block on driver locks
+// so are given longer
+static constexpr std::chrono::milliseconds kProcfsSourceDeadline(500);
+static constexpr std::chrono::milliseconds kDebugfsSourceDeadline(1500);
+
+// How long to wait for a source that's still running before saving results without it. A debugfs read stuck on a
+// driver lock might never return
+static constexpr std::chrono::milliseconds kSourceIdleTimeout(1500);
+
+/**
+ * /proc/vmstat counters to report rates for. Some counters are split into multiple entries depending on the kernel
+ * version - e.g. per-zone (pgscan_kswapd_normal) on older kernels or per-LRU (workingset_refault_file) on newer ones.
+ * Split counters are summed across all variants. The chart name groups related counters together in the report
+ */
+enum class vmstatSplit
+{
+    None,
+    Zone,
+    Lru
+};
+
+struct vmstatCounter
+{
+    const char *name;
+    vmstatSplit split;
+    const char *chart;
+};
+
+static const vmstatCounter kVmStatCounters[] = {
+        {"pgscan_kswapd",      vmstatSplit::Zone, "Reclaim (pages/s)"},
+        {"pgscan_direct",      vmstatSplit::Zone, "Reclaim (pages/s)"},
+        {"pgsteal_kswapd",     vmstatSplit::Zone, "Reclaim (pages/s)"},
+        {"pgsteal_direct",     vmstatSplit::Zone, "Reclaim (pages/s)"},
+        {"allocstall",         vmstatSplit::Zone, "Stalls (events/s)"},
+        {"compact_stall",      vmstatSplit::None, "Stalls (events/s)"},
+        {"compact_fail",       vmstatSplit::None, "Stalls (events/s)"},
+        {"compact_success",    vmstatSplit::None, "Stalls (events/s)"},
+        {"oom_kill",           vmstatSplit::None, "Stalls (events/s)"},
+        {"pgfault",            vmstatSplit::None, "Faults (faults/s)"},
+        {"pgmajfault",         vmstatSplit::None, "Faults (faults/s)"},
+        {"workingset_refault", vmstatSplit::Lru,  "Faults (faults/s)"},
+        {"pswpin",             vmstatSplit::None, "Swap (pages/s)"},
+        {"pswpout",            vmstatSplit::None, "Swap (pages/s)"},
+        // Despite the name, these count KB read from and written to block devices rather than pages
+        {"pgpgin",             vmstatSplit::None, "Block I/O (KB/s)"},
+        {"pgpgout",            vmstatSplit::None, "Block I/O (KB/s)"},
+};
+
+static const std::vector<std::string> kVmStatZoneSuffixes{"", "_dma", "_dma32", "_normal", "_high", "_movable",
+                                                          "_device"};
+static const std::vector<std::string> kVmStatLruSuffixes{"", "_anon", "_file"};
+
+MemoryMetric::MemoryMetric(std::shared_ptr<IPlatform> platform, std::shared_ptr<JsonReportGenerator> reportGenerator,
+                           std::shared_ptr<GpuMemorySnapshot> gpuSnapshot)
         : mQuit(false),
           mCv(),
+          mBurstRequested(false),
           mLinuxMemoryMeasurements{},
           mCmaFree("Value_KB"),
           mCmaBorrowed("Value_KB"),
           mMemoryBandwidth("Memory_Bandwidth_kbps"),
-          mMemoryBandwidthSupported(false),
+          mMemoryBandwidthSupported(platform->MemoryBandwidthSupported()),
+          mGPUMemorySupported(platform->GpuMemorySupported()),
+          mUseDrmGpuMemory(false),
           mMemoryFragmentation{},
-          mPlatform(platform),
-          mReportGenerator(std::move(reportGenerator))
+          mVmStatMeasurements{},
+          mVmStatHasPrevious(false),
+          mRollingWindows(false),
+          mPlatform(std::move(platform)),
+          mReportGenerator(std::move(reportGenerator)),
+          mGpuSnapshot(std::move(gpuSnapshot))
 {
 
     // Some metrics are returned as a number of pages instead of bytes, so get page size to be able to calculate
@@ -45,56 +110,7 @@ MemoryMetric::MemoryMetric(Platform platform, std::shared_ptr<JsonReportGenerato
 
     // Create a map of CMA regions that converts the directories in /sys/kernel/debug/cma/ to a human-readable name
     // based on the kernel DTS file
-    // *** This will likely need updating for your particular device ***
-    if (platform == Platform::AMLOGIC) {
-        mCmaNames = {
-                std::make_pair("cma-0", "secmon_reserved"),
-                std::make_pair("cma-1", "logo_reserved"),
-                std::make_pair("cma-2", "codec_mm_cma"),
-                std::make_pair("cma-3", "ion_cma_reserved"),
-                std::make_pair("cma-4", "vdin1_cma_reserved"),
-                std::make_pair("cma-5", "demod_cma_reserved"),
-                std::make_pair("cma-6", "kernel_reserved"),
-        };
-    } else if (platform == Platform::AMLOGIC_950D4) {
-        mCmaNames = {
-                std::make_pair("cma-linux,secmo", "secmon_reserved"),
-                std::make_pair("cma-reserved", "reserved"),
-                std::make_pair("cma-linux,codec", "codec_mm_cma"),
-                std::make_pair("cma-linux,ion-d", "ion_cma_reserved"),
-                std::make_pair("cma-linux,vdin1", "vdin1_cma_reserved"),
-                std::make_pair("cma-linux,meson", "kernel_reserved")
-        };
-    } else if (platform == Platform::REALTEK) {
-        mCmaNames = {
-                std::make_pair("cma-0", "cma-0"),
-                std::make_pair("cma-1", "cma-1"),
-                std::make_pair("cma-2", "cma-2"),
-                std::make_pair("cma-3", "cma-3"),
-                std::make_pair("cma-4", "cma-4"),
-                std::make_pair("cma-5", "cma-5"),
-                std::make_pair("cma-6", "cma-6"),
-                std::make_pair("cma-7", "cma-7"),
-                std::make_pair("cma-8", "cma-8"),
-        };
-    } else if (platform == Platform::REALTEK64) {
-        mCmaNames = {
-                std::make_pair("cma-linux,defau", "default_dma_pool"),
-                std::make_pair("cma-linux,cma_1", "video_output_pool_2"),
-                std::make_pair("cma-linux,cma_3", "audio_pool"),
-                std::make_pair("cma-linux,cma_4", "svp_video_pool"),
-                std::make_pair("cma-linux,cma_5", "audio_output_pool"),
-                std::make_pair("cma-linux,cma_6", "ota_pool"),
-                std::make_pair("cma-linux,cma_7", "audio_fw_pool"),
-                std::make_pair("cma-linux,cma_8", "audio_hifi_pool"),
-                std::make_pair("cma-linux,cma_9", "video_output_pool_1"),
-        };
-    } else if (platform == Platform::BROADCOM) {
-        mCmaNames = {
-                std::make_pair("cma-WiFi@4C0000", "cma-WiFi@4C0000"),
-                std::make_pair("cma-reserved", "cma-reserved")
-        };
-    }
+    mCmaNames = mPlatform->CmaNames();
 
     // Create static measurements for linux memory usage - store in KB
     const std::vector<std::string> usageCategories{"Total", "Used", "Buffered", "Cached", "Free", "Available",
@@ -105,36 +121,16 @@ MemoryMetric::MemoryMetric(Platform platform, std::shared_ptr<JsonReportGenerato
         mLinuxMemoryMeasurements.insert(std::make_pair(category, value));
     }
 
-    switch (platform) {
-        case Platform::AMLOGIC: 
-        case Platform::AMLOGIC_950D4: 
-        {
-            // Amlogic should allow reporting memory bandwidth
-            if (std::filesystem::exists("/sys/class/aml_ddr/mode")) {
-                mMemoryBandwidthSupported = true;
-                std::ofstream ddrMode("/sys/class/aml_ddr/mode", std::ios::binary);
-                ddrMode << "1";
-            }
-
-            // Amlogic reports GPU memory allocations
-            mGPUMemorySupported = true;
-            break;
-        }
-
-        case Platform::REALTEK:
-        case Platform::REALTEK64:
-            // Realtek does not report memory bandwidth
-            mMemoryBandwidthSupported = false;
-            // Realtek reports GPU memory allocations
-            mGPUMemorySupported = true;
-            break;
+    for (const auto &counter: kVmStatCounters) {
+        mVmStatMeasurements.emplace_back(counter.name);
+    }
 
-        case Platform::BROADCOM:
-            // Line of enquiry open with Broadcom as to whether there is a way to get this info.
-            // TODO: Complete investigation.
-            mMemoryBandwidthSupported = false;
-            mGPUMemorySupported = true;
-            break;
+    // Newer SoCs might not have a debugfs GPU memory file we know how to parse, so fall back to the generic DRM fdinfo
+    // stats if the driver supports them
+    if (!mGPUMemorySupported && DrmGpuMemory::IsSupported()) {
+        LOG_INFO("Platform GPU memory stats not available - using DRM fdinfo");
+        mUseDrmGpuMemory = true;
+        mGPUMemorySupported = true;
     }
 
 }
@@ -145,15 +141,44 @@ MemoryMetric::~MemoryMetric()
         StopCollection();
     }
 
-    // Disable memory bandwidth monitoring
-    std::ofstream ddrMode("/sys/class/aml_ddr/mode", std::ios::binary);
-    ddrMode << "0";
+    // The sources write straight into this object, so wait for any that are still running rather than leaving them to
+    // write into freed memory - the library can be destroyed in a process that keeps running
+    mSources.clear();
 }
 
-void MemoryMetric::StartCollection(const std::chrono::seconds frequency)
+void MemoryMetric::StartCollection(const std::chrono::milliseconds frequency)
 {
+    // Snapshots read mSources, so only change it whilst holding the lock
+    std::lock_guard<std::mutex> locker(mLock);
     mQuit = false;
-    mCollectionThread = std::thread(&MemoryMetric::CollectData, this, frequency);
+    mInterval = AdaptiveInterval(frequency);
+
+    // The workers are kept when collection is stopped and restarted. A source that's stuck in the kernel can't be
+    // stopped, and a new worker for the same source would write to the same measurements at the same time
+    if (mSources.empty()) {
+        // Each source writes to its own measurements, so they can safely run in parallel
+        auto addSource = [&](const std::string &name, std::chrono::milliseconds deadline,
+                             void (MemoryMetric::*source)())
+        {
+            mSources.emplace_back(std::make_unique<SourceWorker>(name, deadline,
+                                                                [this, source]() { (this->*source)(); },
+                                                                mReportGenerator->collectorStats()));
+        };
+
+        addSource("Linux Memory", kProcfsSourceDeadline, &MemoryMetric::GetLinuxMemoryUsage);
+        addSource("CMA", kDebugfsSourceDeadline, &MemoryMetric::GetCmaMemoryUsage);
+        addSource("GPU", kDebugfsSourceDeadline, &MemoryMetric::GetGpuMemoryUsage);
+        addSource("Containers", kProcfsSourceDeadline, &MemoryMetric::GetContainerMemoryUsage);
+        addSource("Memory Bandwidth", kDebugfsSourceDeadline, &MemoryMetric::GetMemoryBandwidth);
+        addSource("Fragmentation", kProcfsSourceDeadline, &MemoryMetric::CalculateFragmentation);
+        addSource("VM Statistics", kProcfsSourceDeadline, &MemoryMetric::GetVmStatRates);
+
+        if (!mPlatform->ExtraMemoryName().empty()) {
+            addSource(mPlatform->ExtraMemoryName(), kDebugfsSourceDeadline, &MemoryMetric::GetExtraMemoryUsage);
+        }
+    }
+
+    mCollectionThread = std::thread(&MemoryMetric::CollectData, this);
 }
 
 void MemoryMetric::StopCollection()
@@ -169,56 +194,169 @@ void MemoryMetric::StopCollection()
     }
 }
 
-void MemoryMetric::CollectData(std::chrono::seconds frequency)
+/**
+ * Collect data immediately, then collect more frequently for a short period
+ */
+void MemoryMetric::RequestBurst(std::chrono::milliseconds interval)
+{
+    std::lock_guard<std::mutex> locker(mLock);
+    mInterval.Burst(interval, kBurstHoldTime);
+    mBurstRequested = true;
+    mCv.notify_all();
+}
+
+void MemoryMetric::CollectData()
 {
     std::unique_lock<std::mutex> lock(mLock);
 
     do {
         auto start = std::chrono::high_resolution_clock::now();
+        mBurstRequested = false;
 
-        GetLinuxMemoryUsage();
-        GetCmaMemoryUsage();
-        GetGpuMemoryUsage();
-        GetContainerMemoryUsage();
-        GetMemoryBandwidth();
-        CalculateFragmentation();
+        // Run all sources at once and wait for each up to its deadline, so one slow driver doesn't hold up the rest
+        std::vector<std::chrono::steady_clock::time_point> deadlines;
+        deadlines.reserve(mSources.size());
+        for (auto &source: mSources) {
+            deadlines.emplace_back(source->Trigger());
+        }
 
-        if (mPlatform == Platform::BROADCOM) {
-            GetBroadcomBmemUsage();
+        for (size_t i = 0; i < mSources.size(); i++) {
+            mSources[i]->Wait(deadlines[i]);
         }
 
         auto end = std::chrono::high_resolution_clock::now();
         LOG_INFO("MemoryMetric completed in %lld ms",
                  (long long) std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
 
-        // Wait for period before doing collection again, or until cancelled
-        mCv.wait_for(lock, frequency);
+        // Wait for period before doing collection again, or until cancelled or a burst is requested
+        mCv.wait_for(lock, mInterval.Next(), [&]
+        {
+            return mQuit || mBurstRequested;
+        });
     } while (!mQuit);
 
     LOG_INFO("Collection thread quit");
 }
 
+void MemoryMetric::EnableRollingWindows()
+{
+    mRollingWindows = true;
+
+    for (const auto &measurement: mLinuxMemoryMeasurements) {
+        mLinuxMemoryWindows.emplace(measurement.first, RollingWindow());
+    }
+
+    for (auto &measurement: mVmStatMeasurements) {
+        measurement.Series.SetRetention(RollingWindow::kMaxWindow);
+    }
+}
+
+void MemoryMetric::EnableOomForecast(std::chrono::seconds warningHorizon, std::function<void()> onWarning)
+{
+    mOomForecaster = std::make_unique<OomForecaster>(warningHorizon, [onWarning](const OomForecaster::Forecast &)
+    {
+        if (onWarning) {
+            onWarning();
+        }
+    });
+}
+
+std::map<std::string, Measurement> MemoryMetric::GetLinuxMemory()
+{
+    std::lock_guard<std::mutex> locker(mLock);
+
+    // The source might have overrun its deadline and still be writing
+    for (auto &source: mSources) {
+        if (source->Name() == "Linux Memory" && !source->WaitIdle(kSourceIdleTimeout)) {
+            return {};
+        }
+    }
+
+    return mLinuxMemoryMeasurements;
+}
+
 void MemoryMetric::SaveResults()
 {
+    // Can be called whilst collection is running when saving a snapshot, so make sure nothing is being written. A
+    // source that's still stuck is left out of this report rather than holding it up
+    std::lock_guard<std::mutex> locker(mLock);
+    std::set<std::string> staleSources;
+    for (auto &source: mSources) {
+        if (!source->WaitIdle(kSourceIdleTimeout)) {
+            staleSources.insert(source->Name());
+        }
+    }
+
+    auto isStale = [&](const std::string &name)
+    {
+        return staleSources.find(name) != staleSources.end();
+    };
+
     std::vector<JsonReportGenerator::dataItems> data{};
 
-    for (const auto &result: mLinuxMemoryMeasurements) {
-        data.emplace_back(JsonReportGenerator::dataItems{
-                std::make_pair("Value", result.first),
-                result.second
-        });
-    }
-    mReportGenerator->addDataset("Linux Memory", data);
+    if (!isStale("Linux Memory")) {
+        for (const auto &result: mLinuxMemoryMeasurements) {
+            data.emplace_back(JsonReportGenerator::dataItems{
+                    std::make_pair("Value", result.first),
+                    result.second
+            });
+        }
+        mReportGenerator->addDataset("Linux Memory", data);
+
+        if (mRollingWindows) {
+            static const std::vector<std::pair<std::string, std::chrono::seconds>> windows = {
+                    {"1 Min",  std::chrono::minutes(1)},
+                    {"15 Min", std::chrono::minutes(15)},
+                    {"1 Hour", std::chrono::minutes(60)}
+            };
+
+            std::vector<JsonReportGenerator::dataItems> windowData{};
+            for (const auto &window: mLinuxMemoryWindows) {
+                JsonReportGenerator::dataItems row{std::make_pair("Value", window.first)};
+
+                for (const auto &w: windows) {
+                    auto summary = window.second.Get(w.second);
+                    row.emplace_back(std::make_pair(w.first + " Avg_KB", std::to_string((long long) summary.Average)));
+                    row.emplace_back(std::make_pair(w.first + " Max_KB", std::to_string((long long) summary.Max)));
+                }
 
-    // Set the average Used memory value
-    auto it = mLinuxMemoryMeasurements.find("Used");
-    if (it != mLinuxMemoryMeasurements.end()) {
-        mReportGenerator->setAverageLinuxMemoryUsage(it->second.GetAverageRounded());
+                windowData.emplace_back(row);
+            }
+            mReportGenerator->addDataset("Rolling Windows - Linux Memory", windowData);
+        }
+
+        if (mOomForecaster) {
+            auto forecast = mOomForecaster->Get();
+
+            auto seconds = [](const std::optional<double> &value)
+            {
+                return value.has_value() ? std::to_string((long long) value.value()) : "-";
+            };
+
+            std::vector<JsonReportGenerator::dataItems> forecastData{JsonReportGenerator::dataItems{
+                    std::make_pair("Low_Watermark_KB", std::to_string(mOomForecaster->LowWatermarkKb())),
+                    std::make_pair("Headroom_KB", std::to_string((long long) forecast.HeadroomKb)),
+                    std::make_pair("Headroom_KB_per_min", std::to_string((long long) forecast.HeadroomKbPerMinute)),
+                    std::make_pair("Available_KB_per_min", std::to_string((long long) forecast.AvailableKbPerMinute)),
+                    std::make_pair("Swap_Free_KB_per_min", std::to_string((long long) forecast.SwapFreeKbPerMinute)),
+                    std::make_pair("Zram_KB_per_min", std::to_string((long long) forecast.ZramKbPerMinute)),
+                    std::make_pair("Seconds_To_OOM", seconds(forecast.SecondsToOom)),
+                    std::make_pair("Min_Seconds_To_OOM", seconds(mOomForecaster->MinSecondsToOom())),
+                    std::make_pair("Warnings", std::to_string(mOomForecaster->Warnings()))
+            }};
+            mReportGenerator->addDataset("OOM Forecast", forecastData);
+        }
+
+        // Set the average Used memory value
+        auto it = mLinuxMemoryMeasurements.find("Used");
+        if (it != mLinuxMemoryMeasurements.end()) {
+            mReportGenerator->setAverageLinuxMemoryUsage(it->second.GetAverageRounded());
+        }
+        data.clear();
     }
-    data.clear();
 
     // *** GPU Memory Usage ***
-    if (mGPUMemorySupported) {
+    if (mGPUMemorySupported && !isStale("GPU")) {
         for (const auto &result: mGpuMeasurements) {
             data.emplace_back(JsonReportGenerator::dataItems{
                     std::make_pair("PID", std::to_string(result.first)),
@@ -244,51 +382,56 @@ void MemoryMetric::SaveResults()
     }
 
     // *** CMA Memory Usage and breakdown ***
-    for (const auto &result: mCmaMeasurements) {
-        data.emplace_back(JsonReportGenerator::dataItems{
-                std::make_pair("Region", result.first),
-                std::make_pair("Size_KB", std::to_string(result.second.sizeKb)),
-                result.second.Used,
-                result.second.Unused
-        });
-    }
-    mReportGenerator->addDataset("CMA Regions", data);
-
-    // Add all CMA memory to accumulated total
-    long double cmaSum = 0;
-    std::for_each(mCmaMeasurements.begin(), mCmaMeasurements.end(), [&](const std::pair<std::string, cmaMeasurement> &m)
-    {
-        cmaSum += m.second.Used.GetAverage();
-    });
-    mReportGenerator->addToAccumulatedMemoryUsage(cmaSum);
+    if (!isStale("CMA")) {
+        for (const auto &result: mCmaMeasurements) {
+            data.emplace_back(JsonReportGenerator::dataItems{
+                    std::make_pair("Region", result.first),
+                    std::make_pair("Size_KB", std::to_string(result.second.sizeKb)),
+                    result.second.Used,
+                    result.second.Unused
+            });
+        }
+        mReportGenerator->addDataset("CMA Regions", data);
 
-    data.clear();
+        // Add all CMA memory to accumulated total
+        long double cmaSum = 0;
+        std::for_each(mCmaMeasurements.begin(), mCmaMeasurements.end(),
+                      [&](const std::pair<std::string, cmaMeasurement> &m)
+        {
+            cmaSum += m.second.Used.GetAverage();
+        });
+        mReportGenerator->addToAccumulatedMemoryUsage(cmaSum);
 
+        data.clear();
 
-    // *** CMA Summary ***
-    data.emplace_back(JsonReportGenerator::dataItems{
-            std::make_pair("Value", "CMA Free"),
-            mCmaFree
-    });
-    data.emplace_back(JsonReportGenerator::dataItems{
-            std::make_pair("Value", "CMA Borrowed by Kernel"),
-            mCmaBorrowed
-    });
-    mReportGenerator->addDataset("CMA Summary", data);
-    data.clear();
 
-    // *** Per-container memory usage ***
-    for (const auto &result: mContainerMeasurements) {
+        // *** CMA Summary ***
+        data.emplace_back(JsonReportGenerator::dataItems{
+                std::make_pair("Value", "CMA Free"),
+                mCmaFree
+        });
         data.emplace_back(JsonReportGenerator::dataItems{
-                std::make_pair("Container", result.first),
-                result.second
+                std::make_pair("Value", "CMA Borrowed by Kernel"),
+                mCmaBorrowed
         });
+        mReportGenerator->addDataset("CMA Summary", data);
+        data.clear();
+    }
+
+    // *** Per-container memory usage ***
+    if (!isStale("Containers")) {
+        for (const auto &result: mContainerMeasurements) {
+            data.emplace_back(JsonReportGenerator::dataItems{
+                    std::make_pair("Container", result.first),
+                    result.second
+            });
+        }
+        mReportGenerator->addDataset("Containers", data);
+        data.clear();
     }
-    mReportGenerator->addDataset("Containers", data);
-    data.clear();
 
     // *** Memory bandwidth (if supported) ***
-    if (mMemoryBandwidthSupported) {
+    if (mMemoryBandwidthSupported && !isStale("Memory Bandwidth")) {
 
         data.emplace_back(JsonReportGenerator::dataItems{
                 mMemoryBandwidth
@@ -298,39 +441,77 @@ void MemoryMetric::SaveResults()
     }
 
     // *** Memory fragmentation - break down per zone ***
-    for (const auto &memoryZone: mMemoryFragmentation) {
-        std::string reportName = "Memory Fragmentation - Zone " + memoryZone.first;
+    if (!isStale("Fragmentation")) {
+        for (const auto &memoryZone: mMemoryFragmentation) {
+            std::string reportName = "Memory Fragmentation - Zone " + memoryZone.first;
+
+            int i = 0;
+            for (const auto &measurement: memoryZone.second) {
+                data.emplace_back(JsonReportGenerator::dataItems{
+                        std::make_pair("Order", std::to_string(i)),
+                        measurement.FreePages,
+                        measurement.Fragmentation
+                });
+                i++;
+            }
+            mReportGenerator->addDataset(reportName, data);
+            data.clear();
+        }
+    }
+
+    // *** VM statistics ***
+    if (mVmStatHasPrevious && !isStale("VM Statistics")) {
+        std::map<std::string, std::vector<TimeSeries>> charts;
+
+        for (size_t i = 0; i < mVmStatMeasurements.size(); i++) {
+            const auto &measurement = mVmStatMeasurements[i];
 
-        int i = 0;
-        for (const auto &measurement: memoryZone.second) {
             data.emplace_back(JsonReportGenerator::dataItems{
-                    std::make_pair("Order", std::to_string(i)),
-                    measurement.FreePages,
-                    measurement.Fragmentation
+                    std::make_pair("Counter", kVmStatCounters[i].name),
+                    measurement.Rate,
+                    std::make_pair("Total", std::to_string(measurement.Total))
             });
-            i++;
+
+            charts[kVmStatCounters[i].chart].emplace_back(measurement.Series);
         }
-        mReportGenerator->addDataset(reportName, data);
+        mReportGenerator->addDataset("VM Statistics", data);
         data.clear();
+
+        for (const auto &chart: charts) {
+            mReportGenerator->addTimeSeries("VM Statistics - " + chart.first, chart.second);
+        }
     }
 
-    // *** Broadcom BMEM (if applicable) ***
-    if (mPlatform == Platform::BROADCOM) {
-        for (const auto &measurement: mBroadcomBmemMeasurements) {
+    // *** Platform specific memory regions (e.g. Broadcom BMEM) ***
+    if (!mPlatform->ExtraMemoryName().empty() && !isStale(mPlatform->ExtraMemoryName())) {
+        for (const auto &measurement: mExtraMemoryMeasurements) {
             data.emplace_back(JsonReportGenerator::dataItems{
                     std::make_pair("Region", measurement.first),
                     measurement.second});
         }
-        mReportGenerator->addDataset("BMEM", data);
+        mReportGenerator->addDataset(mPlatform->ExtraMemoryName(), data);
 
-        // Add all BMEM memory to accumulated total
-        long double bmemSum = 0;
-        std::for_each(mBroadcomBmemMeasurements.begin(), mBroadcomBmemMeasurements.end(), [&](const auto &m)
+        // Add all platform specific memory to accumulated total
+        long double extraSum = 0;
+        std::for_each(mExtraMemoryMeasurements.begin(), mExtraMemoryMeasurements.end(), [&](const auto &m)
         {
-            bmemSum += m.second.GetAverage();
+            extraSum += m.second.GetAverage();
+        });
+        mReportGenerator->addToAccumulatedMemoryUsage(extraSum);
+    }
+
+    // *** How long each source took to read, and whether any timed out ***
+    data.clear();
+    for (const auto &source: mSources) {
+        data.emplace_back(JsonReportGenerator::dataItems{
+                std::make_pair("Source", source->Name()),
+                source->Duration(),
+                std::make_pair("Timeouts", std::to_string(source->Timeouts())),
+                std::make_pair("Skipped", std::to_string(source->Skipped())),
+                std::make_pair("Stale", std::to_string(source->Stale()))
         });
-        mReportGenerator->addToAccumulatedMemoryUsage(bmemSum);
     }
+    mReportGenerator->addDataset("Memory Sources", data);
 }
 
 void MemoryMetric::GetLinuxMemoryUsage()
@@ -348,6 +529,45 @@ void MemoryMetric::GetLinuxMemoryUsage()
     mLinuxMemoryMeasurements.at("Slab Reclaimable").AddDataPoint(memInfoFile.SlabReclaimable());
     mLinuxMemoryMeasurements.at("Slab Unreclaimable").AddDataPoint(memInfoFile.SlabUnreclaimable());
     mLinuxMemoryMeasurements.at("Swap Used").AddDataPoint(memInfoFile.SwapUsed());
+
+    if (mOomForecaster) {
+        mOomForecaster->AddSample(std::chrono::steady_clock::now(), memInfoFile.MemAvailableKb(),
+                                  memInfoFile.SwapTotal(), memInfoFile.SwapFree());
+    }
+
+    if (mRollingWindows) {
+        for (auto &window: mLinuxMemoryWindows) {
+            window.second.AddDataPoint(mLinuxMemoryMeasurements.at(window.first).GetLast());
+        }
+    }
+
+    if (auto streamWriter = mReportGenerator->streamWriter()) {
+        nlohmann::json memoryKb;
+        for (const auto &measurement: mLinuxMemoryMeasurements) {
+            memoryKb[measurement.first] = measurement.second.GetLast();
+        }
+        streamWriter->Write(StreamWriter::Source::System, {{"type", "system"}, {"memoryKb", memoryKb}});
+    }
+
+    if (auto metricsExporter = mReportGenerator->metricsExporter()) {
+        MetricsExporter::Family family{"memcapture_system_memory_bytes", "System memory from /proc/meminfo", {}};
+        for (const auto &measurement: mLinuxMemoryMeasurements) {
+            family.Samples.push_back({{{"type", measurement.first}}, (double) measurement.second.GetLast() * 1024});
+        }
+        metricsExporter->Publish(MetricsExporter::Source::LinuxMemory, {std::move(family)});
+    }
+
+    if (auto counterTrace = mReportGenerator->counterTrace()) {
+        counterTrace->AddCounter("Linux Memory (KB)", {
+                {"Used",      memInfoFile.MemUsedKb()},
+                {"Free",      memInfoFile.MemFreeKb()},
+                {"Available", memInfoFile.MemAvailableKb()},
+                {"Cached",    memInfoFile.CachedKb()},
+                {"Buffered",  memInfoFile.BuffersKb()},
+                {"Slab",      memInfoFile.SlabKb()},
+                {"Swap Used", memInfoFile.SwapUsed()}
+        });
+    }
 }
 
 void MemoryMetric::GetCmaMemoryUsage()
@@ -361,6 +581,8 @@ void MemoryMetric::GetCmaMemoryUsage()
     long double cmaTotalKb = 0;
     long double cmaTotalUsed = 0;
 
+    auto counterTrace = mReportGenerator->counterTrace();
+
     // Start by getting CMA breakdown
     try {
         for (const auto &dirEntry: std::filesystem::directory_iterator(
@@ -393,6 +615,10 @@ void MemoryMetric::GetCmaMemoryUsage()
                 cmaName = dirEntry.path().filename();
             }
 
+            if (counterTrace) {
+                counterTrace->AddCounter("CMA " + cmaName + " (KB)", {{"Used", usedKb}, {"Unused", unusedKb}});
+            }
+
             // Add to measurements
             auto itr = mCmaMeasurements.find(cmaName);
 
@@ -424,6 +650,27 @@ void MemoryMetric::GetCmaMemoryUsage()
         long double totalUnused = cmaTotalKb - cmaTotalUsed;
         long double borrowed = totalUnused - memInfoFile.CmaFree();
         mCmaBorrowed.AddDataPoint(borrowed);
+
+        if (counterTrace) {
+            counterTrace->AddCounter("CMA (KB)", {{"Free", memInfoFile.CmaFree()}, {"Borrowed", borrowed}});
+        }
+
+        if (auto metricsExporter = mReportGenerator->metricsExporter()) {
+            MetricsExporter::Family regions{"memcapture_cma_memory_bytes", "Used and unused memory per CMA region", {}};
+            for (const auto &region: mCmaMeasurements) {
+                regions.Samples.push_back({{{"region", region.first}, {"type", "used"}},
+                                           (double) region.second.Used.GetLast() * 1024});
+                regions.Samples.push_back({{{"region", region.first}, {"type", "unused"}},
+                                           (double) region.second.Unused.GetLast() * 1024});
+            }
+
+            MetricsExporter::Family totals{"memcapture_cma_total_bytes", "Free and kernel-borrowed CMA memory", {
+                    {{{"type", "free"}}, (double) memInfoFile.CmaFree() * 1024},
+                    {{{"type", "borrowed"}}, (double) borrowed * 1024}
+            }};
+
+            metricsExporter->Publish(MetricsExporter::Source::Cma, {std::move(regions), std::move(totals)});
+        }
     } catch (std::filesystem::filesystem_error &error) {
         LOG_WARN("Failed to open CMA debug file with error %s", error.what());
     }
@@ -433,23 +680,64 @@ void MemoryMetric::GetGpuMemoryUsage()
 {
     if (mGPUMemorySupported) {
         //LOG_INFO("Getting GPU memory usage");
+        mCurrentGpuUsageKb.clear();
 
-        switch (mPlatform) {
-            case (Platform::AMLOGIC): 
-            case (Platform::AMLOGIC_950D4): 
-            {
-                GetGpuMemoryUsageAmlogic();
-                break;
+        if (mUseDrmGpuMemory) {
+            mDrmGpuMemory.GetUsage(mCurrentGpuUsageKb);
+        } else {
+            mPlatform->GetGpuMemoryUsage(mCurrentGpuUsageKb);
+        }
+
+        auto counterTrace = mReportGenerator->counterTrace();
+        auto now = std::chrono::steady_clock::now();
+
+        // A process can have multiple GPU contexts, so the backends sum the usage per-PID before adding a single
+        // data point for this sample
+        for (const auto &usage: mCurrentGpuUsageKb) {
+            auto itr = mGpuMeasurements.find(usage.first);
+
+            if (itr != mGpuMeasurements.end()) {
+                // Already got a measurement for this PID
+                itr->second.Used.AddDataPoint(usage.second);
+            } else {
+                Process process(usage.first);
+
+                Measurement used("Memory_Usage_KB");
+                used.AddDataPoint(usage.second);
+
+                auto measurement = gpuMeasurement(process, used);
+                itr = mGpuMeasurements.insert(std::make_pair(usage.first, measurement)).first;
             }
-            case (Platform::REALTEK): 
-            case (Platform::REALTEK64): 
-	    {
-                GetGpuMemoryUsageRealtek();
-                break;
+            itr->second.LastSeen = now;
+
+            if (counterTrace) {
+                counterTrace->AddProcessCounter(usage.first, itr->second.ProcessInfo.name(), "GPU Memory (KB)",
+                                                {{"Used", usage.second}});
             }
-            case (Platform::BROADCOM): {
-                GetGpuMemoryUsageBroadcom();
-                break;
+        }
+
+        if (mGpuSnapshot) {
+            mGpuSnapshot->Publish(mCurrentGpuUsageKb);
+        }
+
+        if (auto metricsExporter = mReportGenerator->metricsExporter()) {
+            MetricsExporter::Family family{"memcapture_gpu_memory_bytes", "GPU memory used by each process", {}};
+            for (const auto &usage: mCurrentGpuUsageKb) {
+                family.Samples.push_back({{{"pid",  std::to_string(usage.first)},
+                                           {"name", mGpuMeasurements.at(usage.first).ProcessInfo.name()}},
+                                          (double) usage.second * 1024});
+            }
+            metricsExporter->Publish(MetricsExporter::Source::Gpu, {std::move(family)});
+        }
+
+        if (mRollingWindows) {
+            // Don't keep every process that has ever used the GPU when running indefinitely
+            for (auto itr = mGpuMeasurements.begin(); itr != mGpuMeasurements.end();) {
+                if (now - itr->second.LastSeen > RollingWindow::kMaxWindow) {
+                    itr = mGpuMeasurements.erase(itr);
+                } else {
+                    ++itr;
+                }
             }
         }
     }
@@ -470,6 +758,10 @@ void MemoryMetric::GetContainerMemoryUsage()
         return;
     }
 
+    auto counterTrace = mReportGenerator->counterTrace();
+    auto metricsExporter = mReportGenerator->metricsExporter();
+    MetricsExporter::Family family{"memcapture_container_memory_bytes", "Memory usage of each memory cgroup", {}};
+
     // Simplest way is to report memory usage by each cgroup, although this can result in some results that don't
     // correspond to a container if something else created that cgroup
     for (const auto &dirEntry: std::filesystem::directory_iterator(
@@ -484,6 +776,14 @@ void MemoryMetric::GetContainerMemoryUsage()
             memoryUsageFile >> memoryUsageKb;
             memoryUsageKb /= (long double) 1024.0;
 
+            if (counterTrace) {
+                counterTrace->AddCounter("Container " + containerName + " (KB)", {{"Used", memoryUsageKb}});
+            }
+
+            if (metricsExporter) {
+                family.Samples.push_back({{{"container", containerName}}, (double) memoryUsageKb * 1024});
+            }
+
             auto itr = mContainerMeasurements.find(containerName);
 
             if (itr != mContainerMeasurements.end()) {
@@ -496,6 +796,10 @@ void MemoryMetric::GetContainerMemoryUsage()
             }
         }
     }
+
+    if (metricsExporter) {
+        metricsExporter->Publish(MetricsExporter::Source::Containers, {std::move(family)});
+    }
 }
 
 void MemoryMetric::GetMemoryBandwidth()
@@ -504,63 +808,37 @@ void MemoryMetric::GetMemoryBandwidth()
     if (mMemoryBandwidthSupported) {
         //LOG_INFO("Getting memory bandwidth usage");
 
-        if (mPlatform == Platform::AMLOGIC || mPlatform == Platform::AMLOGIC_950D4) {
-            std::ifstream memBandwidthFile("/sys/class/aml_ddr/bandwidth");
+        int kbps = 0;
+        if (mPlatform->GetMemoryBandwidthKbps(&kbps) && kbps != 0) {
+            mMemoryBandwidth.AddDataPoint(kbps);
 
-            if (!memBandwidthFile) {
-                LOG_WARN("Cannot get DDR usage");
-                return;
-            }
-
-            std::string line;
-            int kbps = 0;
-            double percent = 0;
-
-            while (std::getline(memBandwidthFile, line)) {
-                if (sscanf(line.c_str(), "Total bandwidth: %8d KB/s, usage:  %lf%%", &kbps, &percent) != 0) {
-                    if (kbps != 0) {
-                        mMemoryBandwidth.AddDataPoint(kbps);
-                    }
-                }
+            if (auto counterTrace = mReportGenerator->counterTrace()) {
+                counterTrace->AddCounter("Memory Bandwidth (KB/s)", {{"Bandwidth", kbps}});
             }
         }
     }
 }
 
-void MemoryMetric::GetBroadcomBmemUsage()
+void MemoryMetric::GetExtraMemoryUsage()
 {
-    // LOG_INFO("Getting BMEM Usage");
+    std::map<std::string, long double> usageKb;
+    mPlatform->GetExtraMemoryUsage(usageKb);
 
-    std::ifstream broadcomCoreInfo("/proc/brcm/core");
-
-    if (!broadcomCoreInfo) {
-        LOG_WARN("Could not open /proc/brcm/core");
-        return;
+    if (auto counterTrace = mReportGenerator->counterTrace()) {
+        counterTrace->AddCounter(mPlatform->ExtraMemoryName() + " (KB)", usageKb);
     }
 
-    std::string line;
+    for (const auto &region: usageKb) {
+        auto itr = mExtraMemoryMeasurements.find(region.first);
 
-    char regionName[128];
-    int regionSize;
-    int regionUsage;
-    while (std::getline(broadcomCoreInfo, line)) {
-        if (sscanf(line.c_str(), "%*d  %*s %*d %*s   %d %*s %d%% %*d%% %s", &regionSize, &regionUsage,
-                   regionName) == 3) {
-            // Calculate how many MB we're using since Bcom in their infinite wisdom only give us a percentage
-            // Use KB for consistency with everything else
-            double usageKb = (regionSize * (regionUsage / 100.0)) * 1024;
-
-            auto itr = mBroadcomBmemMeasurements.find(std::string(regionName));
-
-            if (itr == mBroadcomBmemMeasurements.end()) {
-                // New region
-                Measurement measurement("Memory_Usage_KB");
-                measurement.AddDataPoint(usageKb);
-                mBroadcomBmemMeasurements.insert(std::make_pair(std::string(regionName), measurement));
-            } else {
-                auto &measurement = itr->second;
-                measurement.AddDataPoint(usageKb);
-            }
+        if (itr == mExtraMemoryMeasurements.end()) {
+            // New region
+            Measurement measurement("Memory_Usage_KB");
+            measurement.AddDataPoint(region.second);
+            mExtraMemoryMeasurements.insert(std::make_pair(region.first, measurement));
+        } else {
+            auto &measurement = itr->second;
+            measurement.AddDataPoint(region.second);
         }
     }
 }
@@ -577,6 +855,10 @@ void MemoryMetric::CalculateFragmentation()
         return;
     }
 
+    auto metricsExporter = mReportGenerator->metricsExporter();
+    MetricsExporter::Family fragmentation{"memcapture_memory_fragmentation_ratio",
+                                          "Fragmentation index of each zone and order from /proc/buddyinfo", {}};
+
     std::string line;
     std::string segment;
     // Get fragmentation for all zones
@@ -594,16 +876,10 @@ void MemoryMetric::CalculateFragmentation()
         std::map<int, int> freePages;
         std::map<int, double> fragmentationPercent;
 
-        size_t columnCount = 0;
-        if (mPlatform == Platform::AMLOGIC || mPlatform == Platform::AMLOGIC_950D4) {
-            columnCount = 15;
-        } else if (mPlatform == Platform::REALTEK) {
-            columnCount = 17;
-        } else if (mPlatform == Platform::REALTEK64) {
-		/* ES1 has 15 columns */
-            columnCount = 15;
-        } else if (mPlatform == Platform::BROADCOM) {
-            columnCount = 15;
+        // Number of orders depends on the kernel config. If the platform doesn't specify, accept whatever is there
+        size_t columnCount = mPlatform->BuddyInfoColumns();
+        if (columnCount == 0 && segments.size() > 4) {
+            columnCount = segments.size();
         }
 
         if (segments.size() != columnCount) {
@@ -636,6 +912,22 @@ void MemoryMetric::CalculateFragmentation()
                 fragmentationPercent[i] = fragPercentage;
             }
 
+            if (metricsExporter) {
+                for (const auto &order: fragmentationPercent) {
+                    fragmentation.Samples.push_back({{{"zone", zoneName}, {"order", std::to_string(order.first)}},
+                                                     order.second});
+                }
+            }
+
+            if (auto counterTrace = mReportGenerator->counterTrace()) {
+                std::map<std::string, long double> values;
+                for (const auto &order: fragmentationPercent) {
+                    // Zero pad so the series sort in order
+                    values[(order.first < 10 ? "Order 0" : "Order ") + std::to_string(order.first)] = order.second * 100;
+                }
+                counterTrace->AddCounter("Fragmentation " + zoneName + " (%)", values);
+            }
+
             // Update measurements
             auto itr = mMemoryFragmentation.find(zoneName);
             if (itr != mMemoryFragmentation.end()) {
@@ -661,237 +953,62 @@ void MemoryMetric::CalculateFragmentation()
             }
         }
     }
-}
 
-/**
- * Broadcom GPU memory allocations.
- * Available from a series of directories under /sys/kernel/debug/dri/0/.
- * Each directory has a 'client' file which needs to be parsed.
- *
- * Example paths:
- *
- * root@xione-sercomm:~# find /sys/kernel/debug/dri/0/ -name client
- * /sys/kernel/debug/dri/0/13449-00000000f601794d/client
- * /sys/kernel/debug/dri/0/13030-00000000cf255c5d/client
- * /sys/kernel/debug/dri/0/12326-00000000426cbc26/client
- * /sys/kernel/debug/dri/0/12298-00000000954ee8cf/client
- * /sys/kernel/debug/dri/0/8804-000000004fe3dec5/client
- * /sys/kernel/debug/dri/0/8632-0000000055df6881/client
- * /sys/kernel/debug/dri/0/7566-000000003bfb5b6e/client
- * root@xione-sercomm:~#
- *
- * Each directory under /sys/kernel/debug/dri/0/ is of the form '<tid>-<64bit hex>'.
- *
- * tid is the thread id of the thread that allocated the gpu mem, the allocation being detailed in the 'client' file under that directory.
- * Not sure what the 64 bit hex is. An address?
- *
- * Example content of a 'client' file:
- *
- * root@xione-sercomm:~# cat /sys/kernel/debug/dri/0/13449-00000000f601794d/client
- *             command objects    Virtual  SHM pages Huge Pages
- *     SkyBrowserLaunc       2     4096KB        0KB        4MB
- * root@xione-sercomm:~#
- *
- * Need to correlate this TID to the main PID of the process to make analysis easier
- *
- * Note that the process name does not include full path so this is instead retrieved from Procrank using the pid extracted from the directory name.
-*/
-void MemoryMetric::GetGpuMemoryUsageBroadcom()
-{
-    std::string line;
-    pid_t tid;
-
-    for (const auto &entry: std::filesystem::directory_iterator("/sys/kernel/debug/dri/0/")) {
-        const auto entryStr = entry.path().filename().string();
-        if (entry.is_directory()) {
-            // Scan as far as we need to.
-            if (sscanf(entryStr.c_str(), "%d-", &tid) != 1) {
-                // Not interested in this directory.
-                continue;
-            }
-
-            std::string pathStr = std::string("/sys/kernel/debug/dri/0/") + entryStr + "/client";
-            std::ifstream gpuMem(pathStr.c_str());
-            if (!gpuMem) {
-                LOG_WARN("Could not open gpu_memory file %s", pathStr.c_str());
-                continue;
-            }
-
-            while (std::getline(gpuMem, line)) {
-                char processName[32];
-                unsigned int objectsNum;
-                unsigned long virtualMemNum;
-                char virtualMemNumUnit[3];
-                unsigned long virtualMemNumBytes;
-
-                // Scan as far as we need to.
-                if (sscanf(line.c_str(), " %s %d %ld%2c", processName, &objectsNum, &virtualMemNum,
-                           virtualMemNumUnit) == 4) {
-
-                    virtualMemNumUnit[2] = 0;
-
-                    std::string virtualMemNumUnitStr(virtualMemNumUnit);
-
-                    if (virtualMemNumUnitStr == "KB") {
-                        virtualMemNumBytes = virtualMemNum * 1024;
-                    } else if (virtualMemNumUnitStr == "MB") {
-                        virtualMemNumBytes = virtualMemNum * 1024 * 1024;
-                    } else if (virtualMemNumUnitStr == "GB") {
-                        virtualMemNumBytes = virtualMemNum * 1024 * 1024 * 1024;
-                    } else {
-                        LOG_WARN("Could not parse this line: \'%s\'", line.c_str());
-                        continue;
-                    }
-
-                    // Convert TID to parent PID (TGID) to make things easier to correlate later on
-                    pid_t pid = tidToParentPid(tid);
-
-                    auto itr = mGpuMeasurements.find(pid);
-
-                    if (itr != mGpuMeasurements.end()) {
-                        // Already got a measurement for this PID
-                        auto &measurement = itr->second;
-                        measurement.Used.AddDataPoint(virtualMemNumBytes / (long double) 1024.0);
-                    } else {
-                        Process process(pid);
-                        Measurement used("Memory_Usage_KB");
-                        used.AddDataPoint(virtualMemNumBytes / (long double) 1024.0);
-
-                        auto measurement = gpuMeasurement(process, used);
-                        mGpuMeasurements.insert(std::make_pair(pid, measurement));
-                    }
-                }
-            }
-        }
+    if (metricsExporter) {
+        metricsExporter->Publish(MetricsExporter::Source::Fragmentation, {std::move(fragmentation)});
     }
 }
 
-/* Amlogic GPU memory allocations
- *
- * Sizes are in pages, so convert to bytes
+/**
+ * Calculate the per-second rate of reclaim, fault, swap, compaction and OOM activity from /proc/vmstat
  *
- * root@sky-llama-panel:~# cat /sys/kernel/debug/mali0/gpu_memory
-    mali0            total used_pages      25939
-    ----------------------------------------------------
-    kctx             pid              used_pages
-    ----------------------------------------------------
-    f1dbf000      14880       4558
-    f1c19000      14438        135
-    f1bb1000      14292      16359
-    f18c0000      10899       4887
-*/
-void MemoryMetric::GetGpuMemoryUsageAmlogic()
+ * All counters are cumulative since boot, so rates are calculated from the difference between this sample and the
+ * previous one
+ */
+void MemoryMetric::GetVmStatRates()
 {
-    std::ifstream gpuMem("/sys/kernel/debug/mali0/gpu_memory");
-
-    if (!gpuMem) {
-        LOG_WARN("Could not open gpu_memory file");
+    VmStat vmstat;
+    if (!vmstat.IsValid()) {
         return;
     }
 
-    std::string line;
-    long gpuPages;
-    pid_t pid;
-
-    while (std::getline(gpuMem, line)) {
-        if (sscanf(line.c_str(), "%*x %d %ld", &pid, &gpuPages) != 0) {
-            unsigned long gpuBytes = gpuPages * mPageSize;
+    auto now = std::chrono::steady_clock::now();
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - mVmStatLastRead).count();
 
-            auto itr = mGpuMeasurements.find(pid);
+    for (size_t i = 0; i < mVmStatMeasurements.size(); i++) {
+        const auto &counter = kVmStatCounters[i];
+        auto &measurement = mVmStatMeasurements[i];
 
-            if (itr != mGpuMeasurements.end()) {
-                // Already got a measurement for this PID
-                auto &measurement = itr->second;
-                measurement.Used.AddDataPoint(gpuBytes / (long double) 1024.0);
-            } else {
-                Process process(pid);
-
-                Measurement used("Memory_Usage_KB");
-                used.AddDataPoint(gpuBytes / (long double) 1024.0);
-
-                auto measurement = gpuMeasurement(process, used);
-                mGpuMeasurements.insert(std::make_pair(pid, measurement));
-            }
+        uint64_t value = 0;
+        switch (counter.split) {
+            case vmstatSplit::Zone:
+                for (const auto &suffix: kVmStatZoneSuffixes) {
+                    value += vmstat.Get(counter.name + suffix);
+                }
+                break;
+            case vmstatSplit::Lru:
+                for (const auto &suffix: kVmStatLruSuffixes) {
+                    value += vmstat.Get(counter.name + suffix);
+                }
+                break;
+            case vmstatSplit::None:
+            default:
+                value = vmstat.Get(counter.name);
+                break;
         }
-    }
-}
 
+        if (mVmStatHasPrevious && elapsedMs > 0) {
+            uint64_t delta = value >= measurement.Last ? value - measurement.Last : 0;
+            long double rate = (delta * 1000.0L) / elapsedMs;
 
-/* Realtek GPU memory allocations
- *
- * Uses a similar format to Amlogic but rendered slightly differently
- *
- * Sizes are in pages, so convert to bytes
- * root@skyxione:/sys/kernel/debug/mali0# cat gpu_memory
- *
- * mali0                  45605
- * kctx-0xfa847000      14102      15898
- * kctx-0xf7953000         42      15833
- * kctx-0xff0b0000       3316       9134
- * kctx-0xfec18000      20929       8344
- * kctx-0xfb9df000        135       6235
- * kctx-0xfb12e000       7081       4962
-*/
-void MemoryMetric::GetGpuMemoryUsageRealtek()
-{
-    std::ifstream gpuMem("/sys/kernel/debug/mali0/gpu_memory");
-
-    if (!gpuMem) {
-        LOG_WARN("Could not open gpu_memory file");
-        return;
-    }
-
-    std::string line;
-    long gpuPages;
-    pid_t pid;
-
-    while (std::getline(gpuMem, line)) {
-        if (sscanf(line.c_str(), "  kctx-0x%*x %ld %d", &gpuPages, &pid) != 0) {
-            unsigned long gpuBytes = gpuPages * mPageSize;
-
-            auto itr = mGpuMeasurements.find(pid);
-
-            if (itr != mGpuMeasurements.end()) {
-                // Already got a measurement for this PID
-                auto &measurement = itr->second;
-                measurement.Used.AddDataPoint(gpuBytes / (long double) 1024.0);
-            } else {
-                Process process(pid);
-
-                Measurement used("Memory Usage KB");
-                used.AddDataPoint(gpuBytes / (long double) 1024.0);
-
-                auto measurement = gpuMeasurement(process, used);
-                mGpuMeasurements.insert(std::make_pair(pid, measurement));
-            }
+            measurement.Total += delta;
+            measurement.Rate.AddDataPoint(rate);
+            measurement.Series.AddDataPoint(rate);
         }
-    }
-}
-
-/**
- * Given a thread ID, return the main PID (TGID) the thread belongs to
- * @return PID
- */
-pid_t MemoryMetric::tidToParentPid(pid_t tid)
-{
-    std::string statusFilePath = "/proc/" + std::to_string(tid) + "/status";
-
-    std::ifstream statusFile(statusFilePath);
-
-    if (!statusFile) {
-        LOG_WARN("Failed to open file %s", statusFilePath.c_str());
-        return -1;
-    }
-
-    std::string line;
-    pid_t pid;
 
-    while (std::getline(statusFile, line)) {
-        if (sscanf(line.c_str(), "Tgid:\t%d", &pid) == 1) {
-            return pid;
-        }
+        measurement.Last = value;
     }
 
-    // Failed to find Tgid in file, weird?
-    return -1;
+    mVmStatHasPrevious = true;
+    mVmStatLastRead = now;
 }
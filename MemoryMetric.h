@@ -25,28 +25,57 @@
 #include <condition_variable>
 #include <map>
 #include <mutex>
-#include "Platform.h"
+#include "Platforms/IPlatform.h"
+#include "AdaptiveInterval.h"
 #include "GroupManager.h"
 
 #include "Procrank.h"
 #include "JsonReportGenerator.h"
+#include "TimeSeries.h"
+#include "GpuMemorySnapshot.h"
+#include "DrmGpuMemory.h"
+#include "SourceWorker.h"
+#include "RollingWindow.h"
+#include "OomForecaster.h"
 
 
 class MemoryMetric : public IMetric
 {
 public:
-    MemoryMetric(Platform platform, std::shared_ptr<JsonReportGenerator> reportGenerator);
+    MemoryMetric(std::shared_ptr<IPlatform> platform, std::shared_ptr<JsonReportGenerator> reportGenerator,
+                 std::shared_ptr<GpuMemorySnapshot> gpuSnapshot = nullptr);
 
     ~MemoryMetric() override;
 
-    void StartCollection(std::chrono::seconds frequency) override;
+    void StartCollection(std::chrono::milliseconds frequency) override;
 
     void StopCollection() override;
 
     void SaveResults() override;
 
+    void RequestBurst(std::chrono::milliseconds interval) override;
+
+    /**
+     * Keep 1 minute/15 minute/1 hour windows of system memory usage, forget GPU usage for processes that haven't been
+     * seen for longer than the largest window, and only chart the largest window. Must be called before collection
+     * starts
+     */
+    void EnableRollingWindows();
+
+    /**
+     * Forecast how long is left until the system runs out of memory on every /proc/meminfo sample, warning when it's
+     * less than the horizon. The callback is invoked from a collection thread so must not block. Must be called before
+     * collection starts
+     */
+    void EnableOomForecast(std::chrono::seconds warningHorizon, std::function<void()> onWarning = nullptr);
+
+    /**
+     * Copy of the /proc/meminfo measurements collected so far, so they can be read whilst collection is running
+     */
+    std::map<std::string, Measurement> GetLinuxMemory();
+
 private:
-    void CollectData(std::chrono::seconds frequency);
+    void CollectData();
 
     void GetLinuxMemoryUsage();
 
@@ -58,18 +87,11 @@ private:
 
     void GetMemoryBandwidth();
 
-    void GetBroadcomBmemUsage();
+    void GetExtraMemoryUsage();
 
     void CalculateFragmentation();
 
-    // GPU measurements per platform
-    void GetGpuMemoryUsageBroadcom();
-
-    void GetGpuMemoryUsageAmlogic();
-
-    void GetGpuMemoryUsageRealtek();
-
-    pid_t tidToParentPid(pid_t tid);
+    void GetVmStatRates();
 
 private:
     struct cmaMeasurement
@@ -112,6 +134,23 @@ private:
 
         Process ProcessInfo;
         Measurement Used;
+        std::chrono::steady_clock::time_point LastSeen;
+    };
+
+    struct vmstatMeasurement
+    {
+        explicit vmstatMeasurement(const std::string &name)
+                : Rate("Rate_per_s"),
+                  Series(name)
+        {
+        }
+
+        Measurement Rate;
+        TimeSeries Series;
+
+        // Value of the counter at the last sample, and the total increase across the capture
+        uint64_t Last = 0;
+        uint64_t Total = 0;
     };
 
     std::thread mCollectionThread;
@@ -119,14 +158,23 @@ private:
     std::condition_variable mCv;
     std::mutex mLock;
 
+    AdaptiveInterval mInterval;
+    bool mBurstRequested;
+
+    // Each data source runs on its own worker so it can be given a deadline
+    std::vector<std::unique_ptr<SourceWorker>> mSources;
+
     size_t mPageSize;
 
     std::map<std::string, cmaMeasurement> mCmaMeasurements;
     std::map<std::string, Measurement> mLinuxMemoryMeasurements;
+    std::map<std::string, RollingWindow> mLinuxMemoryWindows;
     std::map<pid_t, gpuMeasurement> mGpuMeasurements;
+    std::map<pid_t, long double> mCurrentGpuUsageKb;
     std::map<std::string, Measurement> mContainerMeasurements;
 
-    std::map<std::string, Measurement> mBroadcomBmemMeasurements;
+    // Platform specific memory regions, e.g. Broadcom BMEM
+    std::map<std::string, Measurement> mExtraMemoryMeasurements;
 
     Measurement mCmaFree;
     Measurement mCmaBorrowed;
@@ -135,12 +183,28 @@ private:
     bool mMemoryBandwidthSupported;
     bool mGPUMemorySupported;
 
+    // Used instead of the platform specific parsers when the platform doesn't expose GPU memory in debugfs
+    bool mUseDrmGpuMemory;
+    DrmGpuMemory mDrmGpuMemory;
+
     // Position in vector reflects order
     std::map<std::string, std::vector<memoryFragmentation>> mMemoryFragmentation;
 
-    Platform mPlatform;
+    // Position in vector matches the counter table in MemoryMetric.cpp
+    std::vector<vmstatMeasurement> mVmStatMeasurements;
+    bool mVmStatHasPrevious;
+    std::chrono::steady_clock::time_point mVmStatLastRead;
+
+    bool mRollingWindows;
+
+    std::unique_ptr<OomForecaster> mOomForecaster;
+
+    const std::shared_ptr<IPlatform> mPlatform;
 
     std::map<std::string, std::string> mCmaNames;
 
     std::shared_ptr<JsonReportGenerator> mReportGenerator;
+
+    // Latest GPU usage per process, shared with ProcessMetric
+    const std::shared_ptr<GpuMemorySnapshot> mGpuSnapshot;
 };
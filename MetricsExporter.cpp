@@ -0,0 +1,108 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "MetricsExporter.h"
+
+#include <cmath>
+#include <cstdio>
+
+MetricsExporter::MetricsExporter(std::optional<std::shared_ptr<GroupManager>> groupManager)
+        : mGroupManager(std::move(groupManager)),
+          mSnapshots()
+{
+}
+
+void MetricsExporter::Publish(Source source, std::vector<Family> families)
+{
+    auto snapshot = std::make_shared<const std::vector<Family>>(std::move(families));
+    std::atomic_store(&mSnapshots[static_cast<size_t>(source)], std::move(snapshot));
+}
+
+std::vector<std::shared_ptr<const std::vector<MetricsExporter::Family>>> MetricsExporter::Snapshot() const
+{
+    std::vector<std::shared_ptr<const std::vector<Family>>> snapshot;
+
+    for (const auto &slot: mSnapshots) {
+        if (auto families = std::atomic_load(&slot)) {
+            snapshot.emplace_back(std::move(families));
+        }
+    }
+
+    return snapshot;
+}
+
+/**
+ * Format a single label, escaping the value as required by the exposition format
+ */
+static std::string renderLabel(const std::string &name, const std::string &value)
+{
+    std::string label = name + "=\"";
+    label.reserve(label.size() + value.size() + 1);
+
+    for (char c: value) {
+        switch (c) {
+            case '\\':
+                label += "\\\\";
+                break;
+            case '"':
+                label += "\\\"";
+                break;
+            case '\n':
+                label += "\\n";
+                break;
+            default:
+                label += c;
+        }
+    }
+
+    label += '"';
+    return label;
+}
+
+std::string MetricsExporter::Render() const
+{
+    std::string output;
+    char value[64];
+
+    for (const auto &snapshot: Snapshot()) {
+        for (const auto &family: *snapshot) {
+            output += "# HELP " + family.Name + " " + family.Help + "\n";
+            output += "# TYPE " + family.Name + " gauge\n";
+
+            for (const auto &sample: family.Samples) {
+                snprintf(value, sizeof(value), "%.17g", std::isfinite(sample.Value) ? sample.Value : 0.0);
+
+                output += family.Name;
+                if (!sample.Labels.empty()) {
+                    output += "{";
+                    for (size_t i = 0; i < sample.Labels.size(); i++) {
+                        output += (i > 0 ? "," : "") + renderLabel(sample.Labels[i].first, sample.Labels[i].second);
+                    }
+                    output += "}";
+                }
+                output += " ";
+                output += value;
+                output += "\n";
+            }
+        }
+    }
+
+    output += "# EOF\n";
+    return output;
+}
@@ -0,0 +1,90 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "GroupManager.h"
+
+/**
+ * @brief Holds the latest values from each collector in a form that can be served to Prometheus
+ *
+ * Each data source publishes a complete, immutable set of gauges once per tick by swapping a pointer into its own
+ * slot, so rendering the exposition for a scrape never waits for (or holds up) a collection thread - the scrape simply
+ * renders whichever snapshot was current when it started, while the source builds the next one in a separate buffer
+ */
+class MetricsExporter
+{
+public:
+    enum class Source
+    {
+        LinuxMemory,
+        Cma,
+        Gpu,
+        Containers,
+        Fragmentation,
+        Processes,
+        Count
+    };
+
+    struct Sample
+    {
+        // Label names and values, in the order they should be rendered
+        std::vector<std::pair<std::string, std::string>> Labels;
+        double Value;
+    };
+
+    struct Family
+    {
+        std::string Name;
+        std::string Help;
+        std::vector<Sample> Samples;
+    };
+
+    explicit MetricsExporter(std::optional<std::shared_ptr<GroupManager>> groupManager);
+
+    void Publish(Source source, std::vector<Family> families);
+
+    /**
+     * Render all the latest gauges in OpenMetrics text format
+     */
+    std::string Render() const;
+
+    /**
+     * The latest gauges from every source that has published so far, for consumers other than the HTTP endpoint
+     */
+    std::vector<std::shared_ptr<const std::vector<Family>>> Snapshot() const;
+
+    const std::optional<std::shared_ptr<GroupManager>> &groupManager() const
+    {
+        return mGroupManager;
+    }
+
+private:
+    const std::optional<std::shared_ptr<GroupManager>> mGroupManager;
+
+    // Only ever accessed with std::atomic_load/atomic_store
+    std::array<std::shared_ptr<const std::vector<Family>>, static_cast<size_t>(Source::Count)> mSnapshots;
+};
@@ -0,0 +1,206 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "MetricsHttpServer.h"
+#include "Log.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <cerrno>
+#include <string>
+#include <utility>
+
+// Don't let a client that connects and sends nothing (or never reads the response) hold up the next scrape
+static constexpr int kRequestTimeoutMs = 2000;
+static constexpr size_t kMaxRequestSize = 8192;
+
+MetricsHttpServer::MetricsHttpServer(uint16_t port, std::shared_ptr<MetricsExporter> exporter)
+        : mPort(port),
+          mExporter(std::move(exporter)),
+          mListenFd(-1),
+          mStopFd(-1)
+{
+
+}
+
+MetricsHttpServer::~MetricsHttpServer()
+{
+    Stop();
+}
+
+bool MetricsHttpServer::Start()
+{
+    mListenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (mListenFd < 0) {
+        LOG_SYS_ERROR(errno, "Failed to create metrics socket");
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(mListenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    // Only ever listen on localhost
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(mPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(mListenFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 || listen(mListenFd, 4) < 0) {
+        LOG_SYS_ERROR(errno, "Failed to listen on 127.0.0.1:%u", mPort);
+        Stop();
+        return false;
+    }
+
+    mStopFd = eventfd(0, EFD_CLOEXEC);
+    if (mStopFd < 0) {
+        LOG_SYS_ERROR(errno, "Failed to create eventfd");
+        Stop();
+        return false;
+    }
+
+    LOG_INFO("Serving metrics on http://127.0.0.1:%u/metrics", mPort);
+
+    mThread = std::thread(&MetricsHttpServer::Run, this);
+    return true;
+}
+
+void MetricsHttpServer::Stop()
+{
+    if (mStopFd >= 0) {
+        uint64_t value = 1;
+        if (write(mStopFd, &value, sizeof(value)) < 0) {
+            LOG_SYS_WARN(errno, "Failed to signal metrics server thread");
+        }
+    }
+
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+
+    if (mListenFd >= 0) {
+        close(mListenFd);
+        mListenFd = -1;
+    }
+
+    if (mStopFd >= 0) {
+        close(mStopFd);
+        mStopFd = -1;
+    }
+}
+
+void MetricsHttpServer::Run()
+{
+    pthread_setname_np(pthread_self(), "MetricsServer");
+
+    struct pollfd fds[2] = {
+            {mListenFd, POLLIN, 0},
+            {mStopFd,   POLLIN, 0}
+    };
+
+    while (true) {
+        int ret = poll(fds, 2, -1);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_SYS_ERROR(errno, "poll() failed on metrics socket");
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept4(mListenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                LOG_SYS_WARN(errno, "Failed to accept metrics connection");
+                continue;
+            }
+
+            handleConnection(fd);
+            close(fd);
+        }
+    }
+}
+
+void MetricsHttpServer::handleConnection(int fd)
+{
+    // Only need the request line, but wait for the end of the headers so the client doesn't see a reset
+    std::string request;
+    char buffer[1024];
+
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < kMaxRequestSize) {
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, kRequestTimeoutMs) <= 0) {
+            return;
+        }
+
+        ssize_t len = read(fd, buffer, sizeof(buffer));
+        if (len <= 0) {
+            return;
+        }
+        request.append(buffer, len);
+    }
+
+    std::string status = "200 OK";
+    std::string contentType = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+    std::string body;
+
+    auto requestLine = request.substr(0, request.find("\r\n"));
+    if (requestLine.rfind("GET /metrics ", 0) == 0) {
+        body = mExporter->Render();
+    } else if (requestLine.rfind("GET ", 0) == 0) {
+        status = "404 Not Found";
+        contentType = "text/plain";
+        body = "Metrics are served at /metrics\n";
+    } else {
+        status = "405 Method Not Allowed";
+        contentType = "text/plain";
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\n" +
+                           "Content-Type: " + contentType + "\r\n" +
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+                           "Connection: close\r\n\r\n" + body;
+
+    // A client that stops reading would block send() forever, so only send what fits in the socket buffer and give up
+    // if it doesn't drain within the timeout
+    size_t sent = 0;
+    while (sent < response.size()) {
+        struct pollfd pfd = {fd, POLLOUT, 0};
+        if (poll(&pfd, 1, kRequestTimeoutMs) <= 0) {
+            return;
+        }
+
+        ssize_t len = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+                continue;
+            }
+            return;
+        }
+        sent += len;
+    }
+}
@@ -0,0 +1,61 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <memory>
+#include <thread>
+
+#include "MetricsExporter.h"
+
+/**
+ * @brief Minimal HTTP server on localhost that serves the metrics exporter at /metrics
+ *
+ * Handles one connection at a time on its own thread, which is plenty for a local Prometheus scraping every few
+ * seconds
+ */
+class MetricsHttpServer
+{
+public:
+    MetricsHttpServer(uint16_t port, std::shared_ptr<MetricsExporter> exporter);
+
+    ~MetricsHttpServer();
+
+    MetricsHttpServer(const MetricsHttpServer &) = delete;
+
+    MetricsHttpServer &operator=(const MetricsHttpServer &) = delete;
+
+    bool Start();
+
+    void Stop();
+
+private:
+    void Run();
+
+    void handleConnection(int fd);
+
+private:
+    const uint16_t mPort;
+    const std::shared_ptr<MetricsExporter> mExporter;
+
+    int mListenFd;
+    int mStopFd;
+
+    std::thread mThread;
+};
@@ -0,0 +1,235 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "OomForecaster.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include "Log.h"
+
+// How often to repeat the warning while still heading for OOM
+static constexpr std::chrono::minutes kWarningLogInterval(1);
+
+// RAM used per KB of swap if zram is in use but nothing has been swapped yet, so the ratio can't be measured. zram
+// typically compresses to between a quarter and a half, so assume the worse end
+static constexpr double kDefaultZramRatio = 0.5;
+
+OomForecaster::OomForecaster(std::chrono::seconds warningHorizon, std::function<void(const Forecast &)> onWarning)
+        : mWarningHorizon(warningHorizon),
+          mOnWarning(std::move(onWarning)),
+          mLowWatermarkKb(readLowWatermarkKb()),
+          mSamples(0),
+          mZramRatio(0),
+          mWarnings(0)
+{
+    // We assume zram devices appear in sequence under /sys/block, same as Procrank
+    constexpr uint32_t maxZramDevices = 256;
+    for (uint32_t i = 0; i < maxZramDevices; i++) {
+        std::filesystem::path device("/sys/block/zram" + std::to_string(i));
+        if (!std::filesystem::exists(device)) {
+            break;
+        }
+        mZramStats.emplace_back(device / "mm_stat");
+    }
+
+    if (!mZramStats.empty()) {
+        mZramRatio = kDefaultZramRatio;
+    }
+
+    LOG_INFO("Forecasting time to OOM against a low watermark of %ld KB", mLowWatermarkKb);
+}
+
+void OomForecaster::AddSample(std::chrono::steady_clock::time_point time, long availableKb, long swapTotalKb,
+                              long swapFreeKb)
+{
+    double zramKb = readZramKb();
+
+    auto swapUsedKb = swapTotalKb - swapFreeKb;
+    if (!mZramStats.empty() && swapUsedKb > 0 && zramKb > 0) {
+        mZramRatio = std::clamp(zramKb / swapUsedKb, 0.0, 1.0);
+    }
+
+    double headroomKb = (double) (availableKb - mLowWatermarkKb) + swapFreeKb * (1 - mZramRatio);
+
+    double elapsed = 0;
+    if (mSamples == 0) {
+        mFirstSample = time;
+    } else {
+        elapsed = std::chrono::duration<double>(time - mLastSample).count();
+    }
+    mLastSample = time;
+    mSamples++;
+
+    double decay = std::exp(-elapsed / (double) kTimeConstant.count());
+    mAvailable.AddSample(elapsed, decay, (double) availableKb);
+    mSwapFree.AddSample(elapsed, decay, (double) swapFreeKb);
+    mZram.AddSample(elapsed, decay, zramKb);
+    mHeadroom.AddSample(elapsed, decay, headroomKb);
+
+    Forecast forecast;
+    forecast.AvailableKb = (double) availableKb;
+    forecast.SwapFreeKb = (double) swapFreeKb;
+    forecast.ZramKb = zramKb;
+    forecast.HeadroomKb = headroomKb;
+    forecast.AvailableKbPerMinute = mAvailable.Slope() * 60;
+    forecast.SwapFreeKbPerMinute = mSwapFree.Slope() * 60;
+    forecast.ZramKbPerMinute = mZram.Slope() * 60;
+    forecast.HeadroomKbPerMinute = mHeadroom.Slope() * 60;
+
+    if (mSamples >= kMinimumSamples && time - mFirstSample >= kMinimumSpan) {
+        // Forecast from the fitted level rather than the latest sample so a single noisy sample doesn't raise a warning
+        double level = mHeadroom.Level();
+        double slope = mHeadroom.Slope();
+
+        if (level <= 0) {
+            forecast.SecondsToOom = 0;
+        } else if (slope < 0) {
+            forecast.SecondsToOom = level / -slope;
+        }
+    }
+
+    if (forecast.SecondsToOom.has_value()) {
+        forecast.Warning = forecast.SecondsToOom.value() < (double) mWarningHorizon.count();
+
+        if (!mMinSecondsToOom.has_value() || forecast.SecondsToOom.value() < mMinSecondsToOom.value()) {
+            mMinSecondsToOom = forecast.SecondsToOom;
+        }
+    }
+
+    bool newWarning = forecast.Warning && !mForecast.Warning;
+    mForecast = forecast;
+
+    if (!forecast.Warning) {
+        return;
+    }
+
+    if (newWarning || time - mLastWarningLog >= kWarningLogInterval) {
+        LOG_WARN("Forecast to run out of memory in %.0f seconds - headroom %.0f KB falling by %.0f KB/min "
+                 "(MemAvailable %.0f KB/min, SwapFree %.0f KB/min, zram %.0f KB/min)",
+                 forecast.SecondsToOom.value(), forecast.HeadroomKb, -forecast.HeadroomKbPerMinute,
+                 forecast.AvailableKbPerMinute, forecast.SwapFreeKbPerMinute, forecast.ZramKbPerMinute);
+        mLastWarningLog = time;
+    }
+
+    if (newWarning) {
+        mWarnings++;
+
+        if (mOnWarning && (!mLastCallback.has_value() || time - mLastCallback.value() >= kCallbackCooldown)) {
+            mLastCallback = time;
+            mOnWarning(forecast);
+        }
+    }
+}
+
+void OomForecaster::decayingRegression::AddSample(double secondsSinceLast, double decay, double value)
+{
+    // Move the origin to the new sample, so existing samples are now at -secondsSinceLast relative to it
+    double dt = secondsSinceLast;
+    mSumTT = mSumTT - 2 * dt * mSumT + dt * dt * mWeight;
+    mSumT -= dt * mWeight;
+    mSumTY -= dt * mSumY;
+
+    mWeight = mWeight * decay + 1;
+    mSumT *= decay;
+    mSumTT *= decay;
+    mSumY = mSumY * decay + value;
+    mSumTY *= decay;
+}
+
+double OomForecaster::decayingRegression::Slope() const
+{
+    double denominator = mWeight * mSumTT - mSumT * mSumT;
+    if (denominator <= 1e-9) {
+        return 0;
+    }
+
+    return (mWeight * mSumTY - mSumT * mSumY) / denominator;
+}
+
+double OomForecaster::decayingRegression::Level() const
+{
+    if (mWeight <= 0) {
+        return 0;
+    }
+
+    return (mSumY - Slope() * mSumT) / mWeight;
+}
+
+/**
+ * Sum of the low watermark of every zone. Once free memory drops below this kswapd starts reclaiming, and an
+ * allocation that can't be satisfied after reclaim ends up in the OOM killer
+ */
+long OomForecaster::readLowWatermarkKb()
+{
+    long pageSizeKb = sysconf(_SC_PAGESIZE) / 1024;
+    long lowPages = 0;
+
+    std::ifstream zoneinfo("/proc/zoneinfo");
+    std::string line;
+    while (std::getline(zoneinfo, line)) {
+        std::istringstream stream(line);
+        std::string key;
+        long value;
+        if (stream >> key >> value && key == "low") {
+            lowPages += value;
+        }
+    }
+
+    if (lowPages > 0) {
+        return lowPages * pageSizeKb;
+    }
+
+    // The low watermark defaults to 5/4 of the min watermark
+    std::ifstream minFree("/proc/sys/vm/min_free_kbytes");
+    long minFreeKb = 0;
+    if (minFree >> minFreeKb) {
+        return minFreeKb * 5 / 4;
+    }
+
+    LOG_WARN("Could not read the low watermark - forecasting time until MemAvailable reaches 0");
+    return 0;
+}
+
+/**
+ * RAM used by all zram devices, including the allocator's overhead
+ */
+long OomForecaster::readZramKb() const
+{
+    uint64_t totalBytes = 0;
+
+    for (const auto &mmstat: mZramStats) {
+        std::ifstream mmstatFile(mmstat);
+        std::string line;
+        if (!std::getline(mmstatFile, line)) {
+            continue;
+        }
+
+        uint64_t memUsedTotal = 0;
+        if (sscanf(line.c_str(), "%*u %*u %" SCNu64, &memUsedTotal) == 1) {
+            totalBytes += memUsedTotal;
+        }
+    }
+
+    return (long) (totalBytes / 1024);
+}
@@ -0,0 +1,151 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Forecasts how long is left until the system runs out of memory, from the trend in MemAvailable and swap
+ *
+ * The headroom is how far MemAvailable is above the kernel's low watermark, plus the RAM that could still be freed by
+ * swapping out. For zram, swapping out a page only frees the part of it that compresses away, so free swap is scaled by
+ * the current compression ratio.
+ *
+ * Each value is fitted with an exponentially weighted least-squares line, so recent samples count the most and every
+ * sample is O(1) to add. When the headroom is falling fast enough to run out within the warning horizon, a warning is
+ * logged and the callback is invoked (at most once per kCallbackCooldown)
+ */
+class OomForecaster
+{
+public:
+    struct Forecast
+    {
+        // Latest values
+        double AvailableKb = 0;
+        double SwapFreeKb = 0;
+        double ZramKb = 0;
+        double HeadroomKb = 0;
+
+        // Fitted trends, negative when falling
+        double AvailableKbPerMinute = 0;
+        double SwapFreeKbPerMinute = 0;
+        double ZramKbPerMinute = 0;
+        double HeadroomKbPerMinute = 0;
+
+        // Empty if there isn't enough data yet or the headroom isn't falling
+        std::optional<double> SecondsToOom;
+
+        bool Warning = false;
+    };
+
+    // How quickly older samples are forgotten. Short, as we want to catch a device heading for OOM in the next few
+    // minutes rather than a slow drift over the whole capture
+    static constexpr std::chrono::seconds kTimeConstant{120};
+
+    // Don't forecast until the trend covers at least this long
+    static constexpr std::chrono::seconds kMinimumSpan{30};
+    static constexpr uint64_t kMinimumSamples = 5;
+
+    static constexpr std::chrono::minutes kCallbackCooldown{5};
+
+    OomForecaster(std::chrono::seconds warningHorizon, std::function<void(const Forecast &)> onWarning);
+
+    void AddSample(std::chrono::steady_clock::time_point time, long availableKb, long swapTotalKb, long swapFreeKb);
+
+    Forecast Get() const
+    {
+        return mForecast;
+    }
+
+    long LowWatermarkKb() const
+    {
+        return mLowWatermarkKb;
+    }
+
+    // Shortest time to OOM forecast across the capture, and how many times a warning was raised
+    std::optional<double> MinSecondsToOom() const
+    {
+        return mMinSecondsToOom;
+    }
+
+    int Warnings() const
+    {
+        return mWarnings;
+    }
+
+private:
+    /**
+     * Least-squares fit where each sample's weight decays exponentially with age. Times are kept relative to the
+     * latest sample so the sums stay small however long the capture runs
+     */
+    class decayingRegression
+    {
+    public:
+        void AddSample(double secondsSinceLast, double decay, double value);
+
+        // Slope per second, and the fitted value at the latest sample
+        double Slope() const;
+
+        double Level() const;
+
+    private:
+        double mWeight = 0;
+        double mSumT = 0;
+        double mSumTT = 0;
+        double mSumY = 0;
+        double mSumTY = 0;
+    };
+
+    static long readLowWatermarkKb();
+
+    long readZramKb() const;
+
+private:
+    const std::chrono::seconds mWarningHorizon;
+    const std::function<void(const Forecast &)> mOnWarning;
+    const long mLowWatermarkKb;
+
+    // mm_stat file of each zram device, found once at startup
+    std::vector<std::filesystem::path> mZramStats;
+
+    decayingRegression mAvailable;
+    decayingRegression mSwapFree;
+    decayingRegression mZram;
+    decayingRegression mHeadroom;
+
+    uint64_t mSamples;
+    std::chrono::steady_clock::time_point mFirstSample;
+    std::chrono::steady_clock::time_point mLastSample;
+
+    // Last known RAM used per KB of swap, so free swap can be converted into reclaimable RAM
+    double mZramRatio;
+
+    Forecast mForecast;
+    std::optional<double> mMinSecondsToOom;
+    int mWarnings;
+
+    std::chrono::steady_clock::time_point mLastWarningLog;
+    std::optional<std::chrono::steady_clock::time_point> mLastCallback;
+};
@@ -0,0 +1,170 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "AmlogicPlatform.h"
+#include "Log.h"
+
+#include <unistd.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+AmlogicPlatform::AmlogicPlatform(bool is950D4)
+        : mIs950D4(is950D4),
+          mPageSize(sysconf(_SC_PAGESIZE)),
+          mGpuMemorySupported(std::filesystem::exists("/sys/kernel/debug/mali0/gpu_memory")),
+          mMemoryBandwidthSupported(false)
+{
+    // Amlogic should allow reporting memory bandwidth once the DDR monitor is enabled
+    if (std::filesystem::exists("/sys/class/aml_ddr/mode")) {
+        mMemoryBandwidthSupported = true;
+        std::ofstream ddrMode("/sys/class/aml_ddr/mode", std::ios::binary);
+        ddrMode << "1";
+    }
+}
+
+AmlogicPlatform::~AmlogicPlatform()
+{
+    // Disable the DDR monitor again if we enabled it
+    if (mMemoryBandwidthSupported) {
+        std::ofstream ddrMode("/sys/class/aml_ddr/mode", std::ios::binary);
+        ddrMode << "0";
+    }
+}
+
+bool AmlogicPlatform::Detect(const std::vector<std::string> &compatible)
+{
+    for (const auto &entry: compatible) {
+        if (entry.rfind("amlogic,", 0) == 0) {
+            return true;
+        }
+    }
+
+    return std::filesystem::exists("/sys/class/aml_ddr");
+}
+
+/**
+ * The 950D4 kernel names its CMA regions after the DTS node rather than numbering them
+ */
+bool AmlogicPlatform::Is950D4()
+{
+    return std::filesystem::exists("/sys/kernel/debug/cma/cma-linux,codec");
+}
+
+std::string AmlogicPlatform::Name() const
+{
+    return mIs950D4 ? "AMLOGIC_950D4" : "AMLOGIC";
+}
+
+// *** This will likely need updating for your particular device ***
+std::map<std::string, std::string> AmlogicPlatform::CmaNames() const
+{
+    if (mIs950D4) {
+        return {
+                std::make_pair("cma-linux,secmo", "secmon_reserved"),
+                std::make_pair("cma-reserved", "reserved"),
+                std::make_pair("cma-linux,codec", "codec_mm_cma"),
+                std::make_pair("cma-linux,ion-d", "ion_cma_reserved"),
+                std::make_pair("cma-linux,vdin1", "vdin1_cma_reserved"),
+                std::make_pair("cma-linux,meson", "kernel_reserved")
+        };
+    }
+
+    return {
+            std::make_pair("cma-0", "secmon_reserved"),
+            std::make_pair("cma-1", "logo_reserved"),
+            std::make_pair("cma-2", "codec_mm_cma"),
+            std::make_pair("cma-3", "ion_cma_reserved"),
+            std::make_pair("cma-4", "vdin1_cma_reserved"),
+            std::make_pair("cma-5", "demod_cma_reserved"),
+            std::make_pair("cma-6", "kernel_reserved"),
+    };
+}
+
+size_t AmlogicPlatform::BuddyInfoColumns() const
+{
+    return 15;
+}
+
+bool AmlogicPlatform::GpuMemorySupported() const
+{
+    return mGpuMemorySupported;
+}
+
+/* Amlogic GPU memory allocations
+ *
+ * Sizes are in pages, so convert to bytes
+ *
+ * root@sky-llama-panel:~# cat /sys/kernel/debug/mali0/gpu_memory
+    mali0            total used_pages      25939
+    ----------------------------------------------------
+    kctx             pid              used_pages
+    ----------------------------------------------------
+    f1dbf000      14880       4558
+    f1c19000      14438        135
+    f1bb1000      14292      16359
+    f18c0000      10899       4887
+*/
+void AmlogicPlatform::GetGpuMemoryUsage(std::map<pid_t, long double> &usageKb)
+{
+    std::ifstream gpuMem("/sys/kernel/debug/mali0/gpu_memory");
+
+    if (!gpuMem) {
+        LOG_WARN("Could not open gpu_memory file");
+        return;
+    }
+
+    std::string line;
+    long gpuPages;
+    pid_t pid;
+
+    while (std::getline(gpuMem, line)) {
+        if (sscanf(line.c_str(), "%*x %d %ld", &pid, &gpuPages) != 0) {
+            unsigned long gpuBytes = gpuPages * mPageSize;
+
+            usageKb[pid] += gpuBytes / (long double) 1024.0;
+        }
+    }
+}
+
+bool AmlogicPlatform::MemoryBandwidthSupported() const
+{
+    return mMemoryBandwidthSupported;
+}
+
+bool AmlogicPlatform::GetMemoryBandwidthKbps(int *kbps)
+{
+    std::ifstream memBandwidthFile("/sys/class/aml_ddr/bandwidth");
+
+    if (!memBandwidthFile) {
+        LOG_WARN("Cannot get DDR usage");
+        return false;
+    }
+
+    std::string line;
+    double percent = 0;
+
+    while (std::getline(memBandwidthFile, line)) {
+        if (sscanf(line.c_str(), "Total bandwidth: %8d KB/s, usage:  %lf%%", kbps, &percent) >= 1) {
+            return true;
+        }
+    }
+
+    return false;
+}
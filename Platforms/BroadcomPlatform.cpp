@@ -0,0 +1,239 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "BroadcomPlatform.h"
+#include "Log.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+BroadcomPlatform::BroadcomPlatform()
+        : mGpuMemorySupported(std::filesystem::exists("/sys/kernel/debug/dri/0")),
+          mTgidCache{}
+{
+}
+
+bool BroadcomPlatform::Detect(const std::vector<std::string> &compatible)
+{
+    for (const auto &entry: compatible) {
+        if (entry.rfind("brcm,", 0) == 0) {
+            return true;
+        }
+    }
+
+    return std::filesystem::exists("/proc/brcm");
+}
+
+std::string BroadcomPlatform::Name() const
+{
+    return "BROADCOM";
+}
+
+// *** This will likely need updating for your particular device ***
+std::map<std::string, std::string> BroadcomPlatform::CmaNames() const
+{
+    return {
+            std::make_pair("cma-WiFi@4C0000", "cma-WiFi@4C0000"),
+            std::make_pair("cma-reserved", "cma-reserved")
+    };
+}
+
+size_t BroadcomPlatform::BuddyInfoColumns() const
+{
+    return 15;
+}
+
+bool BroadcomPlatform::GpuMemorySupported() const
+{
+    return mGpuMemorySupported;
+}
+
+/**
+ * Broadcom GPU memory allocations.
+ * Available from a series of directories under /sys/kernel/debug/dri/0/.
+ * Each directory has a 'client' file which needs to be parsed.
+ *
+ * Example paths:
+ *
+ * root@xione-sercomm:~# find /sys/kernel/debug/dri/0/ -name client
+ * /sys/kernel/debug/dri/0/13449-00000000f601794d/client
+ * /sys/kernel/debug/dri/0/13030-00000000cf255c5d/client
+ * /sys/kernel/debug/dri/0/12326-00000000426cbc26/client
+ * /sys/kernel/debug/dri/0/12298-00000000954ee8cf/client
+ * /sys/kernel/debug/dri/0/8804-000000004fe3dec5/client
+ * /sys/kernel/debug/dri/0/8632-0000000055df6881/client
+ * /sys/kernel/debug/dri/0/7566-000000003bfb5b6e/client
+ * root@xione-sercomm:~#
+ *
+ * Each directory under /sys/kernel/debug/dri/0/ is of the form '<tid>-<64bit hex>'.
+ *
+ * tid is the thread id of the thread that allocated the gpu mem, the allocation being detailed in the 'client' file under that directory.
+ * Not sure what the 64 bit hex is. An address?
+ *
+ * Example content of a 'client' file:
+ *
+ * root@xione-sercomm:~# cat /sys/kernel/debug/dri/0/13449-00000000f601794d/client
+ *             command objects    Virtual  SHM pages Huge Pages
+ *     SkyBrowserLaunc       2     4096KB        0KB        4MB
+ * root@xione-sercomm:~#
+ *
+ * Need to correlate this TID to the main PID of the process to make analysis easier
+ *
+ * Note that the process name does not include full path so this is instead retrieved from Procrank using the pid extracted from the directory name.
+*/
+void BroadcomPlatform::GetGpuMemoryUsage(std::map<pid_t, long double> &usageKb)
+{
+    std::string line;
+    pid_t tid;
+    std::set<pid_t> clientTids;
+
+    for (const auto &entry: std::filesystem::directory_iterator("/sys/kernel/debug/dri/0/")) {
+        const auto entryStr = entry.path().filename().string();
+        if (entry.is_directory()) {
+            // Scan as far as we need to.
+            if (sscanf(entryStr.c_str(), "%d-", &tid) != 1) {
+                // Not interested in this directory.
+                continue;
+            }
+            clientTids.insert(tid);
+
+            std::string pathStr = std::string("/sys/kernel/debug/dri/0/") + entryStr + "/client";
+            std::ifstream gpuMem(pathStr.c_str());
+            if (!gpuMem) {
+                LOG_WARN("Could not open gpu_memory file %s", pathStr.c_str());
+                continue;
+            }
+
+            while (std::getline(gpuMem, line)) {
+                char processName[32];
+                unsigned int objectsNum;
+                unsigned long virtualMemNum;
+                char virtualMemNumUnit[3];
+                unsigned long virtualMemNumBytes;
+
+                // Scan as far as we need to.
+                if (sscanf(line.c_str(), " %s %d %ld%2c", processName, &objectsNum, &virtualMemNum,
+                           virtualMemNumUnit) == 4) {
+
+                    virtualMemNumUnit[2] = 0;
+
+                    std::string virtualMemNumUnitStr(virtualMemNumUnit);
+
+                    if (virtualMemNumUnitStr == "KB") {
+                        virtualMemNumBytes = virtualMemNum * 1024;
+                    } else if (virtualMemNumUnitStr == "MB") {
+                        virtualMemNumBytes = virtualMemNum * 1024 * 1024;
+                    } else if (virtualMemNumUnitStr == "GB") {
+                        virtualMemNumBytes = virtualMemNum * 1024 * 1024 * 1024;
+                    } else {
+                        LOG_WARN("Could not parse this line: \'%s\'", line.c_str());
+                        continue;
+                    }
+
+                    // Convert TID to parent PID (TGID) to make things easier to correlate later on
+                    pid_t pid = tidToParentPid(tid);
+
+                    usageKb[pid] += virtualMemNumBytes / (long double) 1024.0;
+                }
+            }
+        }
+    }
+
+    // Only keep the TGID of clients that still exist, in case the TID is re-used by another process
+    for (auto itr = mTgidCache.begin(); itr != mTgidCache.end();) {
+        if (clientTids.find(itr->first) == clientTids.end()) {
+            itr = mTgidCache.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
+
+std::string BroadcomPlatform::ExtraMemoryName() const
+{
+    return "BMEM";
+}
+
+/**
+ * Broadcom reserves BMEM regions for the video decoders and graphics, reported in /proc/brcm/core
+ */
+void BroadcomPlatform::GetExtraMemoryUsage(std::map<std::string, long double> &usageKb)
+{
+    // LOG_INFO("Getting BMEM Usage");
+
+    std::ifstream broadcomCoreInfo("/proc/brcm/core");
+
+    if (!broadcomCoreInfo) {
+        LOG_WARN("Could not open /proc/brcm/core");
+        return;
+    }
+
+    std::string line;
+
+    char regionName[128];
+    int regionSize;
+    int regionUsage;
+    while (std::getline(broadcomCoreInfo, line)) {
+        if (sscanf(line.c_str(), "%*d  %*s %*d %*s   %d %*s %d%% %*d%% %s", &regionSize, &regionUsage,
+                   regionName) == 3) {
+            // Calculate how many MB we're using since Bcom in their infinite wisdom only give us a percentage
+            // Use KB for consistency with everything else
+            double regionUsageKb = (regionSize * (regionUsage / 100.0)) * 1024;
+
+            usageKb[regionName] = regionUsageKb;
+        }
+    }
+}
+
+/**
+ * Given a thread ID, return the main PID (TGID) the thread belongs to. Results are cached as this is called for every
+ * GPU client on every sample
+ * @return PID
+ */
+pid_t BroadcomPlatform::tidToParentPid(pid_t tid)
+{
+    auto cached = mTgidCache.find(tid);
+    if (cached != mTgidCache.end()) {
+        return cached->second;
+    }
+
+    std::string statusFilePath = "/proc/" + std::to_string(tid) + "/status";
+
+    std::ifstream statusFile(statusFilePath);
+
+    if (!statusFile) {
+        LOG_WARN("Failed to open file %s", statusFilePath.c_str());
+        return -1;
+    }
+
+    std::string line;
+    pid_t pid;
+
+    while (std::getline(statusFile, line)) {
+        if (sscanf(line.c_str(), "Tgid:\t%d", &pid) == 1) {
+            mTgidCache[tid] = pid;
+            return pid;
+        }
+    }
+
+    // Failed to find Tgid in file, weird?
+    return -1;
+}
@@ -19,11 +19,19 @@
 
 #pragma once
 
-enum class Platform
+#include "IPlatform.h"
+
+/**
+ * @brief Fallback for SoCs without a dedicated backend
+ *
+ * Only platform independent statistics are captured. GPU memory will still be captured through DRM fdinfo if the GPU
+ * driver supports it
+ */
+class GenericPlatform : public IPlatform
 {
-    AMLOGIC,
-    AMLOGIC_950D4,
-    REALTEK,
-    REALTEK64,
-    BROADCOM
+public:
+    std::string Name() const override
+    {
+        return "GENERIC";
+    }
 };
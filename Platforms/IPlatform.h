@@ -0,0 +1,93 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <sys/types.h>
+#include <map>
+#include <string>
+
+/**
+ * @brief Platform (SoC) specific memory statistics
+ *
+ * Each supported SoC family implements this to provide the information that can't be read in a platform independent
+ * way - vendor GPU drivers, DDR bandwidth monitors, CMA region names from the kernel DTS and any vendor memory
+ * regions. Anything that requires probing the filesystem should be checked once in the constructor, not on each call.
+ *
+ * See PlatformRegistry for how backends are selected
+ */
+class IPlatform
+{
+public:
+    virtual ~IPlatform() = default;
+
+    // Name used to select the platform on the command line
+    virtual std::string Name() const = 0;
+
+    // Converts the directories in /sys/kernel/debug/cma/ to a human-readable name based on the kernel DTS file
+    virtual std::map<std::string, std::string> CmaNames() const
+    {
+        return {};
+    }
+
+    // Number of columns expected in each /proc/buddyinfo line, or 0 to accept any
+    virtual size_t BuddyInfoColumns() const
+    {
+        return 0;
+    }
+
+    virtual bool GpuMemorySupported() const
+    {
+        return false;
+    }
+
+    /**
+     * Add the GPU memory used by each process (in KB) to usageKb. A process can have multiple GPU contexts, so usage
+     * must be added to any existing value
+     */
+    virtual void GetGpuMemoryUsage([[maybe_unused]] std::map<pid_t, long double> &usageKb)
+    {
+    }
+
+    virtual bool MemoryBandwidthSupported() const
+    {
+        return false;
+    }
+
+    /**
+     * @return False if the bandwidth could not be read
+     */
+    virtual bool GetMemoryBandwidthKbps([[maybe_unused]] int *kbps)
+    {
+        return false;
+    }
+
+    // Name of the table to report vendor specific memory regions in (e.g. Broadcom BMEM), empty if there are none
+    virtual std::string ExtraMemoryName() const
+    {
+        return "";
+    }
+
+    /**
+     * Set the memory used by each vendor specific memory region (in KB)
+     */
+    virtual void GetExtraMemoryUsage([[maybe_unused]] std::map<std::string, long double> &usageKb)
+    {
+    }
+};
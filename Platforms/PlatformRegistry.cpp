@@ -0,0 +1,128 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "PlatformRegistry.h"
+#include "AmlogicPlatform.h"
+#include "RealtekPlatform.h"
+#include "BroadcomPlatform.h"
+#include "GenericPlatform.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iterator>
+
+namespace
+{
+    struct platformEntry
+    {
+        std::string name;
+        std::function<std::unique_ptr<IPlatform>()> create;
+
+        // Checked in order, so variants must come before the more general entry for the same SoC
+        std::function<bool(const std::vector<std::string> &)> detect;
+    };
+
+    const std::vector<platformEntry> &platforms()
+    {
+        static const std::vector<platformEntry> entries{
+                {"AMLOGIC_950D4",
+                        []() { return std::make_unique<AmlogicPlatform>(true); },
+                        [](const std::vector<std::string> &compatible)
+                        {
+                            return AmlogicPlatform::Detect(compatible) && AmlogicPlatform::Is950D4();
+                        }},
+                {"AMLOGIC",
+                        []() { return std::make_unique<AmlogicPlatform>(false); },
+                        AmlogicPlatform::Detect},
+                {"REALTEK64",
+                        []() { return std::make_unique<RealtekPlatform>(true); },
+                        [](const std::vector<std::string> &compatible)
+                        {
+                            return RealtekPlatform::Detect(compatible) && RealtekPlatform::Is64Bit();
+                        }},
+                {"REALTEK",
+                        []() { return std::make_unique<RealtekPlatform>(false); },
+                        RealtekPlatform::Detect},
+                {"BROADCOM",
+                        []() { return std::make_unique<BroadcomPlatform>(); },
+                        BroadcomPlatform::Detect},
+                {"GENERIC",
+                        []() { return std::make_unique<GenericPlatform>(); },
+                        nullptr},
+        };
+
+        return entries;
+    }
+
+    /**
+     * /proc/device-tree/compatible is a list of NUL separated strings, most specific first - e.g.
+     * "amlogic,s4" "amlogic,meson-s4"
+     */
+    std::vector<std::string> readCompatible()
+    {
+        std::vector<std::string> compatible;
+
+        std::ifstream compatibleFile("/proc/device-tree/compatible", std::ios::binary);
+        std::string entry;
+        while (std::getline(compatibleFile, entry, '\0')) {
+            if (!entry.empty()) {
+                compatible.emplace_back(entry);
+            }
+        }
+
+        return compatible;
+    }
+}
+
+std::unique_ptr<IPlatform> PlatformRegistry::Create(const std::string &name)
+{
+    for (const auto &entry: platforms()) {
+        if (entry.name == name) {
+            return entry.create();
+        }
+    }
+
+    return nullptr;
+}
+
+std::unique_ptr<IPlatform> PlatformRegistry::Detect()
+{
+    const auto compatible = readCompatible();
+
+    for (const auto &entry: platforms()) {
+        if (entry.detect && entry.detect(compatible)) {
+            auto platform = entry.create();
+            LOG_INFO("Detected platform %s", platform->Name().c_str());
+            return platform;
+        }
+    }
+
+    LOG_WARN("Could not detect platform - only platform independent statistics will be captured");
+    return std::make_unique<GenericPlatform>();
+}
+
+std::vector<std::string> PlatformRegistry::Names()
+{
+    std::vector<std::string> names;
+    std::transform(platforms().begin(), platforms().end(), std::back_inserter(names),
+                   [](const platformEntry &entry) { return entry.name; });
+    return names;
+}
@@ -0,0 +1,48 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "IPlatform.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Creates the IPlatform backend for the SoC we're running on
+ *
+ * To add a new SoC, implement IPlatform and add an entry to the table in PlatformRegistry.cpp with the name(s) it can
+ * be selected with and how to detect it
+ */
+class PlatformRegistry
+{
+public:
+    /**
+     * @return The backend with the given name, or nullptr if there isn't one
+     */
+    static std::unique_ptr<IPlatform> Create(const std::string &name);
+
+    /**
+     * Detect the platform from the devicetree and vendor specific sysfs entries. Falls back to a generic backend if
+     * the SoC isn't recognised
+     */
+    static std::unique_ptr<IPlatform> Detect();
+
+    static std::vector<std::string> Names();
+};
@@ -0,0 +1,139 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "RealtekPlatform.h"
+#include "Log.h"
+
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+RealtekPlatform::RealtekPlatform(bool is64Bit)
+        : mIs64Bit(is64Bit),
+          mPageSize(sysconf(_SC_PAGESIZE)),
+          mGpuMemorySupported(std::filesystem::exists("/sys/kernel/debug/mali0/gpu_memory"))
+{
+}
+
+bool RealtekPlatform::Detect(const std::vector<std::string> &compatible)
+{
+    for (const auto &entry: compatible) {
+        if (entry.rfind("realtek,", 0) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool RealtekPlatform::Is64Bit()
+{
+    struct utsname name = {};
+    if (uname(&name) != 0) {
+        return false;
+    }
+
+    return strcmp(name.machine, "aarch64") == 0;
+}
+
+std::string RealtekPlatform::Name() const
+{
+    return mIs64Bit ? "REALTEK64" : "REALTEK";
+}
+
+// *** This will likely need updating for your particular device ***
+std::map<std::string, std::string> RealtekPlatform::CmaNames() const
+{
+    if (mIs64Bit) {
+        return {
+                std::make_pair("cma-linux,defau", "default_dma_pool"),
+                std::make_pair("cma-linux,cma_1", "video_output_pool_2"),
+                std::make_pair("cma-linux,cma_3", "audio_pool"),
+                std::make_pair("cma-linux,cma_4", "svp_video_pool"),
+                std::make_pair("cma-linux,cma_5", "audio_output_pool"),
+                std::make_pair("cma-linux,cma_6", "ota_pool"),
+                std::make_pair("cma-linux,cma_7", "audio_fw_pool"),
+                std::make_pair("cma-linux,cma_8", "audio_hifi_pool"),
+                std::make_pair("cma-linux,cma_9", "video_output_pool_1"),
+        };
+    }
+
+    return {
+            std::make_pair("cma-0", "cma-0"),
+            std::make_pair("cma-1", "cma-1"),
+            std::make_pair("cma-2", "cma-2"),
+            std::make_pair("cma-3", "cma-3"),
+            std::make_pair("cma-4", "cma-4"),
+            std::make_pair("cma-5", "cma-5"),
+            std::make_pair("cma-6", "cma-6"),
+            std::make_pair("cma-7", "cma-7"),
+            std::make_pair("cma-8", "cma-8"),
+    };
+}
+
+size_t RealtekPlatform::BuddyInfoColumns() const
+{
+    // ES1 of the 64-bit SoC has 15 columns
+    return mIs64Bit ? 15 : 17;
+}
+
+bool RealtekPlatform::GpuMemorySupported() const
+{
+    return mGpuMemorySupported;
+}
+
+/* Realtek GPU memory allocations
+ *
+ * Uses a similar format to Amlogic but rendered slightly differently
+ *
+ * Sizes are in pages, so convert to bytes
+ * root@skyxione:/sys/kernel/debug/mali0# cat gpu_memory
+ *
+ * mali0                  45605
+ * kctx-0xfa847000      14102      15898
+ * kctx-0xf7953000         42      15833
+ * kctx-0xff0b0000       3316       9134
+ * kctx-0xfec18000      20929       8344
+ * kctx-0xfb9df000        135       6235
+ * kctx-0xfb12e000       7081       4962
+*/
+void RealtekPlatform::GetGpuMemoryUsage(std::map<pid_t, long double> &usageKb)
+{
+    std::ifstream gpuMem("/sys/kernel/debug/mali0/gpu_memory");
+
+    if (!gpuMem) {
+        LOG_WARN("Could not open gpu_memory file");
+        return;
+    }
+
+    std::string line;
+    long gpuPages;
+    pid_t pid;
+
+    while (std::getline(gpuMem, line)) {
+        if (sscanf(line.c_str(), "  kctx-0x%*x %ld %d", &gpuPages, &pid) != 0) {
+            unsigned long gpuBytes = gpuPages * mPageSize;
+
+            usageKb[pid] += gpuBytes / (long double) 1024.0;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "IPlatform.h"
+#include <vector>
+
+class RealtekPlatform : public IPlatform
+{
+public:
+    // 64-bit Realtek SoCs use a different kernel DTS so have different CMA region names
+    explicit RealtekPlatform(bool is64Bit);
+
+    static bool Detect(const std::vector<std::string> &compatible);
+
+    static bool Is64Bit();
+
+    std::string Name() const override;
+
+    std::map<std::string, std::string> CmaNames() const override;
+
+    size_t BuddyInfoColumns() const override;
+
+    bool GpuMemorySupported() const override;
+
+    void GetGpuMemoryUsage(std::map<pid_t, long double> &usageKb) override;
+
+private:
+    const bool mIs64Bit;
+    const size_t mPageSize;
+
+    bool mGpuMemorySupported;
+};
@@ -20,8 +20,15 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
 #include "Process.h"
 #include "Measurement.h"
+#include "RollingWindow.h"
+#include "TrendEstimator.h"
 
 struct processMeasurement
 {
@@ -41,4 +48,33 @@ struct processMeasurement
     Measurement SwapPss = Measurement("SwapPss");
     Measurement SwapZram = Measurement("SwapZram");
 
+    // Memory not accounted for in PSS. Footprint is PSS + GPU + DMA-BUF for the same sample
+    Measurement Gpu = Measurement("Gpu_KB");
+    Measurement DmaBuf = Measurement("DmaBuf_KB");
+    Measurement Footprint = Measurement("Footprint_KB");
+
+    // Rates calculated from /proc/<pid>/stat between consecutive samples
+    Measurement MinorFaults = Measurement("MinorFaults_per_s");
+    Measurement MajorFaults = Measurement("MajorFaults_per_s");
+    Measurement CpuUser = Measurement("CpuUser_ms_per_s");
+    Measurement CpuSystem = Measurement("CpuSystem_ms_per_s");
+
+    // How fast PSS is growing, to spot slow leaks that only show as a high max compared to the average
+    TrendEstimator PssTrend;
+
+    // Resolved when the process is first seen, if groups are loaded
+    std::optional<std::string> Group;
+
+    // Raw values from the previous sample
+    bool HasPreviousStat = false;
+    uint64_t LastMinorFaults = 0;
+    uint64_t LastMajorFaults = 0;
+    uint64_t LastUserTime = 0;
+    uint64_t LastSystemTime = 0;
+    std::chrono::steady_clock::time_point LastSampleTime;
+
+    // Only used when running as a daemon
+    std::chrono::steady_clock::time_point LastSeen;
+    std::shared_ptr<RollingWindow> PssWindow;
+
 };
@@ -19,12 +19,75 @@
 
 #include "ProcessMetric.h"
 #include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <unistd.h>
+#include <pthread.h>
 
+// How long to stay at the burst interval after the last request before decaying back to normal
+static constexpr std::chrono::seconds kBurstHoldTime(5);
 
-ProcessMetric::ProcessMetric(std::shared_ptr<JsonReportGenerator> reportGenerator)
+// Only keep the processes using the most memory in each snapshot to keep the report a sensible size
+static constexpr size_t kSnapshotProcessCount = 20;
+static constexpr size_t kMaxSnapshots = 50;
+// Exporting every process would give Prometheus a new series each time a short-lived process appears
+static constexpr size_t kExportedProcessCount = 20;
+
+
+/**
+ * Update the fault and CPU rates for a process using the difference between this sample and the last
+ */
+static void updateStatRates(processMeasurement &measurement, const Procrank::ProcessMemoryUsage &usage)
+{
+    if (!usage.statValid) {
+        return;
+    }
+
+    static const long double clockTicksPerSecond = sysconf(_SC_CLK_TCK);
+
+    if (measurement.HasPreviousStat) {
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                usage.sampleTime - measurement.LastSampleTime).count();
+
+        if (elapsedMs > 0) {
+            long double elapsedSeconds = elapsedMs / 1000.0L;
+
+            auto delta = [](uint64_t current, uint64_t last)
+            {
+                return current >= last ? current - last : 0;
+            };
+
+            measurement.MinorFaults.AddDataPoint(delta(usage.minflt, measurement.LastMinorFaults) / elapsedSeconds);
+            measurement.MajorFaults.AddDataPoint(delta(usage.majflt, measurement.LastMajorFaults) / elapsedSeconds);
+
+            // Convert clock ticks to ms of CPU time used per second
+            measurement.CpuUser.AddDataPoint(
+                    (delta(usage.utime, measurement.LastUserTime) * 1000.0L / clockTicksPerSecond) / elapsedSeconds);
+            measurement.CpuSystem.AddDataPoint(
+                    (delta(usage.stime, measurement.LastSystemTime) * 1000.0L / clockTicksPerSecond) / elapsedSeconds);
+        }
+    }
+
+    measurement.HasPreviousStat = true;
+    measurement.LastMinorFaults = usage.minflt;
+    measurement.LastMajorFaults = usage.majflt;
+    measurement.LastUserTime = usage.utime;
+    measurement.LastSystemTime = usage.stime;
+    measurement.LastSampleTime = usage.sampleTime;
+}
+
+ProcessMetric::ProcessMetric(std::shared_ptr<JsonReportGenerator> reportGenerator,
+                             std::shared_ptr<GpuMemorySnapshot> gpuSnapshot,
+                             std::shared_ptr<DmaBufSnapshot> dmaBufSnapshot)
         : mQuit(false),
           mCv(),
-          mReportGenerator(std::move(reportGenerator))
+          mBurstRequested(false),
+          mRollingWindows(false),
+          mReportGenerator(std::move(reportGenerator)),
+          mGpuSnapshot(std::move(gpuSnapshot)),
+          mDmaBufSnapshot(std::move(dmaBufSnapshot))
 {
 
 }
@@ -36,10 +99,11 @@ ProcessMetric::~ProcessMetric()
     }
 }
 
-void ProcessMetric::StartCollection(const std::chrono::seconds frequency)
+void ProcessMetric::StartCollection(const std::chrono::milliseconds frequency)
 {
     mQuit = false;
-    mCollectionThread = std::thread(&ProcessMetric::CollectData, this, frequency);
+    mInterval = AdaptiveInterval(frequency);
+    mCollectionThread = std::thread(&ProcessMetric::CollectData, this);
 }
 
 void ProcessMetric::StopCollection()
@@ -55,8 +119,88 @@ void ProcessMetric::StopCollection()
     }
 }
 
+/**
+ * Collect data immediately and take a snapshot of the processes using the most memory, then collect more frequently
+ * for a short period
+ */
+void ProcessMetric::RequestBurst(std::chrono::milliseconds interval)
+{
+    std::lock_guard<std::mutex> locker(mLock);
+    mInterval.Burst(interval, kBurstHoldTime);
+    mBurstRequested = true;
+    mCv.notify_all();
+}
+
+void ProcessMetric::EnableRollingWindows()
+{
+    std::lock_guard<std::mutex> locker(mLock);
+    mRollingWindows = true;
+}
+
+nlohmann::json ProcessMetric::GetTopProcesses(size_t count)
+{
+    std::vector<const processMeasurement *> alive;
+    auto result = nlohmann::json::array();
+
+    std::lock_guard<std::mutex> locker(mLock);
+
+    for (const auto &measurement: mMeasurements) {
+        if (!measurement.ProcessInfo.isDead() && measurement.Pss.GetCount() > 0) {
+            alive.emplace_back(&measurement);
+        }
+    }
+
+    std::sort(alive.begin(), alive.end(), [](const processMeasurement *a, const processMeasurement *b)
+    {
+        return a->Pss.GetLast() > b->Pss.GetLast();
+    });
+
+    if (alive.size() > count) {
+        alive.resize(count);
+    }
+
+    for (const auto *measurement: alive) {
+        result.push_back({
+                                 {"pid",        measurement->ProcessInfo.pid()},
+                                 {"name",       measurement->ProcessInfo.name()},
+                                 {"pssKb",      (long long) measurement->Pss.GetLast()},
+                                 {"rssKb",      (long long) measurement->Rss.GetLast()},
+                                 {"ussKb",      (long long) measurement->Uss.GetLast()},
+                                 {"swapKb",     (long long) measurement->Swap.GetLast()},
+                                 {"pssAverageKb", measurement->Pss.GetAverageRounded()}
+                         });
+    }
+
+    return result;
+}
+
+nlohmann::json ProcessMetric::GetProcesses()
+{
+    auto result = nlohmann::json::array();
+
+    std::lock_guard<std::mutex> locker(mLock);
+
+    for (const auto &measurement: mMeasurements) {
+        result.push_back({
+                                 {"pid",      measurement.ProcessInfo.pid()},
+                                 {"name",     measurement.ProcessInfo.name()},
+                                 {"alive",    !measurement.ProcessInfo.isDead()},
+                                 {"pss",      measurement.Pss.ToJson()},
+                                 {"rss",      measurement.Rss.ToJson()},
+                                 {"uss",      measurement.Uss.ToJson()},
+                                 {"swap",     measurement.Swap.ToJson()},
+                                 {"pssTrend", measurement.PssTrend.ToJson()}
+                         });
+    }
+
+    return result;
+}
+
 void ProcessMetric::SaveResults()
 {
+    // Can be called whilst collection is running when saving a snapshot
+    std::lock_guard<std::mutex> locker(mLock);
+
     DeduplicateData();
     mReportGenerator->addProcesses(mMeasurements);
 
@@ -67,10 +211,130 @@ void ProcessMetric::SaveResults()
         pssSum += p.Pss.GetAverage();
     });
     mReportGenerator->addToAccumulatedMemoryUsage(pssSum);
+
+    // Processes using the most memory at the moment memory pressure was detected
+    std::vector<JsonReportGenerator::dataItems> data{};
+    for (const auto &snapshot: mPressureSnapshots) {
+        int rank = 1;
+        for (const auto &process: snapshot.TopProcesses) {
+            data.emplace_back(JsonReportGenerator::dataItems{
+                    std::make_pair("Time", snapshot.Time),
+                    std::make_pair("Rank", std::to_string(rank++)),
+                    std::make_pair("PID", std::to_string(process.process.pid())),
+                    std::make_pair("Process", process.process.name()),
+                    std::make_pair("PSS_KB", std::to_string(process.pss)),
+                    std::make_pair("USS_KB", std::to_string(process.uss)),
+                    std::make_pair("Swap_KB", std::to_string(process.swap))
+            });
+        }
+    }
+    mReportGenerator->addDataset("Memory Pressure Snapshots", data);
+
+    SaveGrowth();
+
+    if (mRollingWindows) {
+        SaveRollingWindows();
+    }
 }
 
-void ProcessMetric::CollectData(const std::chrono::seconds frequency)
+/**
+ * List the processes and groups whose PSS has grown significantly over the capture, fastest first
+ */
+void ProcessMetric::SaveGrowth()
 {
+    struct growth
+    {
+        std::string Kind;
+        std::string Name;
+        std::string Pid;
+        TrendEstimator::Trend Trend;
+    };
+
+    std::vector<growth> growing;
+
+    for (const auto &measurement: mMeasurements) {
+        auto trend = measurement.PssTrend.Get();
+        if (trend.Significant) {
+            growing.push_back({"Process", measurement.ProcessInfo.name(),
+                               std::to_string(measurement.ProcessInfo.pid()), trend});
+        }
+    }
+
+    for (const auto &group: mGroupTrends) {
+        auto trend = group.second.Get();
+        if (trend.Significant) {
+            growing.push_back({"Group", group.first, "", trend});
+        }
+    }
+
+    std::sort(growing.begin(), growing.end(), [](const growth &a, const growth &b)
+    {
+        return a.Trend.KbPerHour > b.Trend.KbPerHour;
+    });
+
+    auto format = [](double value)
+    {
+        std::stringstream stream;
+        stream << std::fixed << std::setprecision(1) << value;
+        return stream.str();
+    };
+
+    std::vector<JsonReportGenerator::dataItems> data{};
+    for (const auto &item: growing) {
+        LOG_WARN("%s %s is growing by %.0f KB/hour (z = %.1f)", item.Kind.c_str(), item.Name.c_str(),
+                 item.Trend.KbPerHour, item.Trend.ZScore);
+
+        data.emplace_back(JsonReportGenerator::dataItems{
+                std::make_pair("Name", item.Name),
+                std::make_pair("Kind", item.Kind),
+                std::make_pair("PID", item.Pid),
+                std::make_pair("Growth_KB_per_hour", format(item.Trend.KbPerHour)),
+                std::make_pair("Recent_Growth_KB_per_hour", format(item.Trend.RecentKbPerHour)),
+                std::make_pair("Least_Squares_KB_per_hour", format(item.Trend.LeastSquaresKbPerHour)),
+                std::make_pair("Z_Score", format(item.Trend.ZScore)),
+                std::make_pair("Duration_hours", format(item.Trend.DurationHours))
+        });
+    }
+    mReportGenerator->addDataset("Memory Growth", data);
+}
+
+void ProcessMetric::SaveRollingWindows()
+{
+    static const std::vector<std::pair<std::string, std::chrono::seconds>> windows = {
+            {"1 Min",   std::chrono::minutes(1)},
+            {"15 Min",  std::chrono::minutes(15)},
+            {"1 Hour", std::chrono::minutes(60)}
+    };
+
+    // mMeasurements is already sorted by average PSS
+    std::vector<JsonReportGenerator::dataItems> data{};
+    for (const auto &measurement: mMeasurements) {
+        if (!measurement.PssWindow || measurement.ProcessInfo.isDead()) {
+            continue;
+        }
+
+        JsonReportGenerator::dataItems row{
+                std::make_pair("PID", std::to_string(measurement.ProcessInfo.pid())),
+                std::make_pair("Process", measurement.ProcessInfo.name())
+        };
+
+        for (const auto &window: windows) {
+            auto summary = measurement.PssWindow->Get(window.second);
+            row.emplace_back(std::make_pair("PSS " + window.first + " Avg_KB",
+                                            std::to_string((long long) summary.Average)));
+            row.emplace_back(std::make_pair("PSS " + window.first + " Max_KB",
+                                            std::to_string((long long) summary.Max)));
+        }
+
+        data.emplace_back(row);
+    }
+    mReportGenerator->addDataset("Rolling Windows - Processes", data);
+}
+
+void ProcessMetric::CollectData()
+{
+    pthread_setname_np(pthread_self(), "ProcessMetric");
+
     std::unique_lock<std::mutex> lock(mLock);
 
     do {
@@ -79,12 +343,34 @@ void ProcessMetric::CollectData(const std::chrono::seconds frequency)
 
         // Use procrank to get the memory usage for all processes in the system at this moment in time
         // Won't capture every spike in memory usage, but over time should smooth out into a decent average
-        Procrank procrank;
+        auto collectorStats = mReportGenerator->collectorStats();
+        std::optional<CollectorStats::ScopedSample> tickSample(std::in_place, collectorStats.get(), "Process Tick", true);
+
+        Procrank procrank(collectorStats);
 
         // This can take 0.5 - 1 second...
         auto processMemory = procrank.GetMemoryUsage();
 
+        if (mBurstRequested) {
+            TakePressureSnapshot(processMemory);
+            mBurstRequested = false;
+        }
+
+        PublishMetrics(processMemory);
+        StreamChanges(processMemory);
+
+        auto counterTrace = mReportGenerator->counterTrace();
+
         for (const auto &procrankMeasurement: processMemory) {
+            if (counterTrace) {
+                counterTrace->AddProcessCounter(procrankMeasurement.process.pid(), procrankMeasurement.process.name(),
+                                                "Memory (KB)", {
+                                                        {"PSS",  procrankMeasurement.pss},
+                                                        {"RSS",  procrankMeasurement.rss},
+                                                        {"USS",  procrankMeasurement.uss},
+                                                        {"Swap", procrankMeasurement.swap}
+                                                });
+            }
 
             // Check if we've seen this process before
             auto itr = std::find_if(mMeasurements.begin(), mMeasurements.end(), [&](const processMeasurement &p)
@@ -96,6 +382,11 @@ void ProcessMetric::CollectData(const std::chrono::seconds frequency)
                 // This is a new process, add to the list
                 processMeasurement measurement(procrankMeasurement.process);
 
+                const auto &groupManager = mReportGenerator->groupManager();
+                if (groupManager.has_value()) {
+                    measurement.Group = procrankMeasurement.process.group(groupManager.value());
+                }
+
                 measurement.Pss.AddDataPoint(procrankMeasurement.pss);
                 measurement.Rss.AddDataPoint(procrankMeasurement.rss);
                 measurement.Uss.AddDataPoint(procrankMeasurement.uss);
@@ -104,6 +395,10 @@ void ProcessMetric::CollectData(const std::chrono::seconds frequency)
                 measurement.SwapPss.AddDataPoint(procrankMeasurement.swap_pss);
                 measurement.SwapZram.AddDataPoint(procrankMeasurement.swap_zram);
                 measurement.Locked.AddDataPoint(procrankMeasurement.locked);
+                updateStatRates(measurement, procrankMeasurement);
+                UpdateFootprint(measurement, procrankMeasurement);
+                UpdateRollingWindow(measurement, procrankMeasurement);
+                measurement.PssTrend.AddDataPoint(procrankMeasurement.sampleTime, procrankMeasurement.pss);
                 mMeasurements.emplace_back(measurement);
 
             } else {
@@ -118,6 +413,10 @@ void ProcessMetric::CollectData(const std::chrono::seconds frequency)
                 measurement.SwapPss.AddDataPoint(procrankMeasurement.swap_pss);
                 measurement.SwapZram.AddDataPoint(procrankMeasurement.swap_zram);
                 measurement.Locked.AddDataPoint(procrankMeasurement.locked);
+                updateStatRates(measurement, procrankMeasurement);
+                UpdateFootprint(measurement, procrankMeasurement);
+                UpdateRollingWindow(measurement, procrankMeasurement);
+                measurement.PssTrend.AddDataPoint(procrankMeasurement.sampleTime, procrankMeasurement.pss);
             }
         }
 
@@ -126,17 +425,271 @@ void ProcessMetric::CollectData(const std::chrono::seconds frequency)
             process.ProcessInfo.updateAliveStatus();
         }
 
+        UpdateGroupTrends(std::chrono::steady_clock::now());
+
+        if (mRollingWindows) {
+            PruneDeadProcesses();
+        }
+
+        tickSample.reset();
+
         auto end = std::chrono::high_resolution_clock::now();
         LOG_INFO("ProcessMetric completed in %lld ms",
                  (long long) std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
 
-        // Wait for period before doing collection again, or until cancelled
-        mCv.wait_for(lock, frequency);
+        // Wait for period before doing collection again, or until cancelled or a burst is requested
+        mCv.wait_for(lock, mInterval.Next(), [&]
+        {
+            return mQuit || mBurstRequested;
+        });
     } while (!mQuit);
 
     LOG_INFO("Collection thread quit");
 }
 
+/**
+ * Store the processes using the most memory at this moment in time
+ */
+void ProcessMetric::TakePressureSnapshot(const std::vector<Procrank::ProcessMemoryUsage> &processMemory)
+{
+    if (mPressureSnapshots.size() >= kMaxSnapshots) {
+        if (!mRollingWindows) {
+            LOG_WARN("Reached maximum number of memory pressure snapshots");
+            return;
+        }
+
+        // Running indefinitely, so the most recent snapshots are the interesting ones
+        mPressureSnapshots.erase(mPressureSnapshots.begin());
+    }
+
+    pressureSnapshot snapshot;
+
+    std::time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::stringstream timeStream;
+    timeStream << std::put_time(std::localtime(&t), "%T");
+    snapshot.Time = timeStream.str();
+
+    snapshot.TopProcesses = processMemory;
+    std::sort(snapshot.TopProcesses.begin(), snapshot.TopProcesses.end(),
+              [](const Procrank::ProcessMemoryUsage &a, const Procrank::ProcessMemoryUsage &b)
+              {
+                  return a.pss > b.pss;
+              });
+
+    if (snapshot.TopProcesses.size() > kSnapshotProcessCount) {
+        snapshot.TopProcesses.erase(snapshot.TopProcesses.begin() + kSnapshotProcessCount,
+                                    snapshot.TopProcesses.end());
+    }
+
+    LOG_INFO("Took memory pressure snapshot of %zu processes", snapshot.TopProcesses.size());
+    mPressureSnapshots.emplace_back(std::move(snapshot));
+}
+
+/**
+ * Stream the processes whose memory usage has changed since the last sample, along with those that have gone away
+ */
+void ProcessMetric::StreamChanges(const std::vector<Procrank::ProcessMemoryUsage> &processMemory)
+{
+    auto streamWriter = mReportGenerator->streamWriter();
+    if (!streamWriter) {
+        return;
+    }
+
+    nlohmann::json changed = nlohmann::json::array();
+    std::map<pid_t, std::array<uint64_t, 4>> usage;
+
+    for (const auto &process: processMemory) {
+        std::array<uint64_t, 4> current{process.pss, process.rss, process.uss, process.swap};
+        auto pid = process.process.pid();
+
+        auto itr = mStreamedUsage.find(pid);
+        if (itr == mStreamedUsage.end() || itr->second != current) {
+            changed.push_back({
+                                      {"pid",    pid},
+                                      {"name",   process.process.name()},
+                                      {"pssKb",  process.pss},
+                                      {"rssKb",  process.rss},
+                                      {"ussKb",  process.uss},
+                                      {"swapKb", process.swap}
+                              });
+        }
+
+        usage.emplace(pid, current);
+    }
+
+    nlohmann::json exited = nlohmann::json::array();
+    for (const auto &previous: mStreamedUsage) {
+        if (usage.find(previous.first) == usage.end()) {
+            exited.push_back(previous.first);
+        }
+    }
+
+    mStreamedUsage = std::move(usage);
+
+    streamWriter->Write(StreamWriter::Source::Processes,
+                        {{"type", "processes"}, {"changed", changed}, {"exited", exited}});
+}
+
+/**
+ * Publish the top processes along with per-group and per-container totals for this sample to the metrics exporter
+ */
+void ProcessMetric::PublishMetrics(const std::vector<Procrank::ProcessMemoryUsage> &processMemory) const
+{
+    auto metricsExporter = mReportGenerator->metricsExporter();
+    if (!metricsExporter) {
+        return;
+    }
+
+    std::vector<const Procrank::ProcessMemoryUsage *> top;
+    top.reserve(processMemory.size());
+    for (const auto &usage: processMemory) {
+        top.emplace_back(&usage);
+    }
+
+    auto topCount = std::min(kExportedProcessCount, top.size());
+    std::partial_sort(top.begin(), top.begin() + topCount, top.end(),
+                      [](const Procrank::ProcessMemoryUsage *a, const Procrank::ProcessMemoryUsage *b)
+                      {
+                          return a->pss > b->pss;
+                      });
+
+    MetricsExporter::Family pss{"memcapture_process_pss_bytes", "PSS of the processes using the most memory", {}};
+    MetricsExporter::Family rss{"memcapture_process_rss_bytes", "RSS of the processes using the most memory", {}};
+    MetricsExporter::Family swap{"memcapture_process_swap_bytes", "Swap of the processes using the most memory", {}};
+
+    for (size_t i = 0; i < topCount; i++) {
+        const auto &usage = *top[i];
+        std::vector<std::pair<std::string, std::string>> labels{{"pid",  std::to_string(usage.process.pid())},
+                                                                {"name", usage.process.name()}};
+
+        pss.Samples.push_back({labels, (double) usage.pss * 1024});
+        rss.Samples.push_back({labels, (double) usage.rss * 1024});
+        swap.Samples.push_back({labels, (double) usage.swap * 1024});
+    }
+
+    std::map<std::string, long double> containerPssKb;
+    std::map<std::string, long double> groupPssKb;
+    const auto &groupManager = metricsExporter->groupManager();
+
+    for (const auto &usage: processMemory) {
+        auto container = usage.process.container();
+        if (container.has_value()) {
+            containerPssKb[container.value()] += usage.pss;
+        }
+
+        if (groupManager.has_value()) {
+            auto group = usage.process.group(groupManager.value());
+            if (group.has_value()) {
+                groupPssKb[group.value()] += usage.pss;
+            }
+        }
+    }
+
+    MetricsExporter::Family containers{"memcapture_container_pss_bytes", "Total PSS of the processes in each container",
+                                       {}};
+    for (const auto &container: containerPssKb) {
+        containers.Samples.push_back({{{"container", container.first}}, (double) container.second * 1024});
+    }
+
+    std::vector<MetricsExporter::Family> families{std::move(pss), std::move(rss), std::move(swap),
+                                                  std::move(containers)};
+
+    if (groupManager.has_value()) {
+        MetricsExporter::Family groups{"memcapture_group_pss_bytes", "Total PSS of the processes in each group", {}};
+        for (const auto &group: groupPssKb) {
+            groups.Samples.push_back({{{"group", group.first}}, (double) group.second * 1024});
+        }
+        families.emplace_back(std::move(groups));
+    }
+
+    metricsExporter->Publish(MetricsExporter::Source::Processes, std::move(families));
+}
+
+/**
+ * Record the memory a process is using outside of its PSS and the resulting total footprint
+ *
+ * GPU usage comes from the most recent MemoryMetric sample and DMA-BUF usage from the most recent DmaBufMetric sample,
+ * so both may lag this sample by up to one period. DMA-BUF buffers are charged in full to every process that holds
+ * them, so they can be double-counted across processes
+ */
+void ProcessMetric::UpdateFootprint(processMeasurement &measurement, const Procrank::ProcessMemoryUsage &usage) const
+{
+    long double gpuKb = mGpuSnapshot ? mGpuSnapshot->UsageKb(usage.process.pid()) : 0;
+    long double dmaBufKb = mDmaBufSnapshot ? mDmaBufSnapshot->TotalKb(usage.process.pid()) : 0;
+
+    measurement.Gpu.AddDataPoint(gpuKb);
+    measurement.DmaBuf.AddDataPoint(dmaBufKb);
+    measurement.Footprint.AddDataPoint(usage.pss + gpuKb + dmaBufKb);
+}
+
+/**
+ * In daemon mode, add this sample's PSS to the process's rolling window and note when it was last seen so it can be
+ * pruned after it exits
+ */
+void ProcessMetric::UpdateRollingWindow(processMeasurement &measurement,
+                                        const Procrank::ProcessMemoryUsage &usage) const
+{
+    if (!mRollingWindows) {
+        return;
+    }
+
+    if (!measurement.PssWindow) {
+        measurement.PssWindow = std::make_shared<RollingWindow>();
+    }
+
+    measurement.PssWindow->AddDataPoint(usage.pss);
+    measurement.LastSeen = std::chrono::steady_clock::now();
+}
+
+/**
+ * Add this sample's total PSS for each group. Groups with no processes alive count as zero rather than being skipped,
+ * so a group whose processes restart with less memory doesn't look flat
+ */
+void ProcessMetric::UpdateGroupTrends(std::chrono::steady_clock::time_point time)
+{
+    if (!mReportGenerator->groupManager().has_value()) {
+        return;
+    }
+
+    std::map<std::string, long double> groupPssKb;
+    for (const auto &measurement: mMeasurements) {
+        if (measurement.Group.has_value() && !measurement.ProcessInfo.isDead() && measurement.Pss.GetCount() > 0) {
+            groupPssKb[measurement.Group.value()] += measurement.Pss.GetLast();
+        }
+    }
+
+    for (const auto &group: groupPssKb) {
+        mGroupTrends.try_emplace(group.first);
+    }
+
+    for (auto &group: mGroupTrends) {
+        auto pss = groupPssKb.find(group.first);
+        group.second.AddDataPoint(time, pss != groupPssKb.end() ? pss->second : 0);
+    }
+}
+
+/**
+ * Forget about processes that died longer ago than the largest rolling window, otherwise every short-lived process
+ * seen over the lifetime of the daemon would be kept forever
+ */
+void ProcessMetric::PruneDeadProcesses()
+{
+    auto now = std::chrono::steady_clock::now();
+
+    auto removed = mMeasurements.size();
+    mMeasurements.erase(std::remove_if(mMeasurements.begin(), mMeasurements.end(),
+                                       [&](const processMeasurement &m)
+                                       {
+                                           return m.ProcessInfo.isDead() && now - m.LastSeen > RollingWindow::kMaxWindow;
+                                       }), mMeasurements.end());
+    removed -= mMeasurements.size();
+
+    if (removed > 0) {
+        LOG_INFO("Removed %zu processes that exited over %lld minutes ago", removed,
+                 (long long) RollingWindow::kMaxWindow.count());
+    }
+}
+
 /**
  * @brief Analyse the collected data and prevent any duplicate processes
  *
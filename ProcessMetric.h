@@ -19,6 +19,7 @@
 #pragma once
 
 #include "IMetric.h"
+#include <array>
 #include <thread>
 #include <condition_variable>
 #include <map>
@@ -28,27 +29,76 @@
 #include "JsonReportGenerator.h"
 #include "Procrank.h"
 #include "ProcessMeasurement.h"
+#include "AdaptiveInterval.h"
+#include "GpuMemorySnapshot.h"
+#include "DmaBufSnapshot.h"
+#include "TrendEstimator.h"
 
 class ProcessMetric : public IMetric
 {
 public:
-    explicit ProcessMetric(std::shared_ptr<JsonReportGenerator> reportGenerator);
+    explicit ProcessMetric(std::shared_ptr<JsonReportGenerator> reportGenerator,
+                           std::shared_ptr<GpuMemorySnapshot> gpuSnapshot = nullptr,
+                           std::shared_ptr<DmaBufSnapshot> dmaBufSnapshot = nullptr);
 
     ~ProcessMetric() override;
 
-    void StartCollection(std::chrono::seconds frequency) override;
+    void StartCollection(std::chrono::milliseconds frequency) override;
 
     void StopCollection() override;
 
     void SaveResults() override;
 
+    void RequestBurst(std::chrono::milliseconds interval) override;
+
+    /**
+     * Keep 1 minute/15 minute/1 hour windows of each process's PSS, and forget processes that have been dead for
+     * longer than the largest window, so memory usage stays flat when running as a daemon
+     */
+    void EnableRollingWindows();
+
+    /**
+     * Processes using the most memory as of the last sample, taken from the live data so it can be queried whilst
+     * collection is running
+     */
+    nlohmann::json GetTopProcesses(size_t count);
+
+    /**
+     * Min/max/average usage of every process seen so far, taken from the live data without changing it so it can be
+     * queried whilst collection is running
+     */
+    nlohmann::json GetProcesses();
 
 private:
-    void CollectData(std::chrono::seconds frequency);
+    void CollectData();
 
     void DeduplicateData();
 
+    void TakePressureSnapshot(const std::vector<Procrank::ProcessMemoryUsage> &processMemory);
+
+    void PublishMetrics(const std::vector<Procrank::ProcessMemoryUsage> &processMemory) const;
+
+    void StreamChanges(const std::vector<Procrank::ProcessMemoryUsage> &processMemory);
+
+    void UpdateFootprint(processMeasurement &measurement, const Procrank::ProcessMemoryUsage &usage) const;
+
+    void UpdateRollingWindow(processMeasurement &measurement, const Procrank::ProcessMemoryUsage &usage) const;
+
+    void PruneDeadProcesses();
+
+    void UpdateGroupTrends(std::chrono::steady_clock::time_point time);
+
+    void SaveGrowth();
+
+    void SaveRollingWindows();
+
 private:
+    struct pressureSnapshot
+    {
+        std::string Time;
+        std::vector<Procrank::ProcessMemoryUsage> TopProcesses;
+    };
+
     std::thread mCollectionThread;
     bool mQuit;
     std::condition_variable mCv;
@@ -56,5 +106,19 @@ private:
 
     std::vector<processMeasurement> mMeasurements;
 
+    AdaptiveInterval mInterval;
+    bool mBurstRequested;
+    std::vector<pressureSnapshot> mPressureSnapshots;
+
+    bool mRollingWindows;
+
+    // PSS, RSS, USS and swap of each process as of the last streamed record, so only changes are streamed
+    std::map<pid_t, std::array<uint64_t, 4>> mStreamedUsage;
+
+    // Total PSS growth of each group, kept for the whole capture like the per-process trends
+    std::map<std::string, TrendEstimator> mGroupTrends;
+
     const std::shared_ptr<JsonReportGenerator> mReportGenerator;
+    const std::shared_ptr<GpuMemorySnapshot> mGpuSnapshot;
+    const std::shared_ptr<DmaBufSnapshot> mDmaBufSnapshot;
 };
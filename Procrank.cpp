@@ -20,6 +20,7 @@
 #include "Procrank.h"
 #include "FileParsers/MemInfo.h"
 #include "FileParsers/Smaps.h"
+#include "FileParsers/ProcStat.h"
 
 #include <climits>
 #include <fstream>
@@ -31,7 +32,10 @@
 #include <inttypes.h>
 #include <set>
 
-Procrank::Procrank() : mSwapEnabled(swapTotalKb() > 0), mZramCompressionRatio(zramCompressionRatio())
+Procrank::Procrank(std::shared_ptr<CollectorStats> collectorStats)
+        : mSwapEnabled(swapTotalKb() > 0),
+          mZramCompressionRatio(zramCompressionRatio()),
+          mCollectorStats(std::move(collectorStats))
 {
 
 }
@@ -48,7 +52,11 @@ Procrank::~Procrank()
 std::vector<Procrank::ProcessMemoryUsage> Procrank::GetMemoryUsage() const
 {
     // Get running processes
-    std::set<pid_t> pids = getRunningProcesses();
+    std::set<pid_t> pids;
+    {
+        CollectorStats::ScopedSample sample(mCollectorStats.get(), "Process Discovery");
+        pids = getRunningProcesses();
+    }
 
     if (pids.empty()) {
         LOG_WARN("No PIDs found");
@@ -166,15 +174,32 @@ Procrank::ProcessMemoryUsage Procrank::getProcessMemoryUsage(Process &process) c
 {
     ProcessMemoryUsage memoryUsage(process);
 
-    Smaps smapFile(memoryUsage.process.pid());
-    memoryUsage.pss = smapFile.Pss();
-    memoryUsage.rss = smapFile.Rss();
-    memoryUsage.swap = smapFile.Swap();
-    memoryUsage.swap_pss = smapFile.SwapPss();
-    memoryUsage.locked = smapFile.Locked();
-    memoryUsage.vss = smapFile.Vss();
-    memoryUsage.uss = smapFile.Uss();
-    memoryUsage.swap_zram = smapFile.SwapPss() * mZramCompressionRatio;
+    {
+        // Per-process reads aren't worth the extra IO accounting reads, the whole tick is tracked by ProcessMetric
+        CollectorStats::ScopedSample sample(mCollectorStats.get(), "Process Smaps");
+        Smaps smapFile(memoryUsage.process.pid());
+        memoryUsage.pss = smapFile.Pss();
+        memoryUsage.rss = smapFile.Rss();
+        memoryUsage.swap = smapFile.Swap();
+        memoryUsage.swap_pss = smapFile.SwapPss();
+        memoryUsage.locked = smapFile.Locked();
+        memoryUsage.vss = smapFile.Vss();
+        memoryUsage.uss = smapFile.Uss();
+        memoryUsage.swap_zram = smapFile.SwapPss() * mZramCompressionRatio;
+    }
+
+    {
+        CollectorStats::ScopedSample sample(mCollectorStats.get(), "Process Stat");
+        ProcStat stat(memoryUsage.process.pid());
+        memoryUsage.sampleTime = std::chrono::steady_clock::now();
+        if (stat.IsValid()) {
+            memoryUsage.statValid = true;
+            memoryUsage.minflt = stat.MinorFaults();
+            memoryUsage.majflt = stat.MajorFaults();
+            memoryUsage.utime = stat.UserTimeTicks();
+            memoryUsage.stime = stat.SystemTimeTicks();
+        }
+    }
 
     return memoryUsage;
 }
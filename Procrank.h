@@ -21,11 +21,14 @@
 
 #include "Log.h"
 #include "Measurement.h"
+#include <chrono>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <string>
 #include <set>
 #include "Process.h"
+#include "CollectorStats.h"
 
 /**
  * Originally memcapture integrated the Android Procrank library. This is now replaced with a custom implementation of procrank
@@ -52,7 +55,13 @@ public:
                                                  locked(0),
                                                  swap(0),
                                                  swap_pss(0),
-                                                 swap_zram(0)
+                                                 swap_zram(0),
+                                                 minflt(0),
+                                                 majflt(0),
+                                                 utime(0),
+                                                 stime(0),
+                                                 statValid(false),
+                                                 sampleTime()
         {
         }
 
@@ -70,10 +79,21 @@ public:
         // When using zram for a swap partition, swap data will be compressed so the amount of physical
         // memory used will be less than the amount of swap in use
         uint64_t swap_zram;
+
+        // Cumulative fault counts and CPU time (in clock ticks) from /proc/<pid>/stat
+        uint64_t minflt;
+        uint64_t majflt;
+        uint64_t utime;
+        uint64_t stime;
+
+        bool statValid;
+
+        // When the stat values were read, used to calculate rates between samples
+        std::chrono::steady_clock::time_point sampleTime;
     };
 
 public:
-    Procrank();
+    explicit Procrank(std::shared_ptr<CollectorStats> collectorStats = nullptr);
 
     ~Procrank();
 
@@ -111,4 +131,6 @@ private:
 private:
     bool mSwapEnabled;
     double mZramCompressionRatio;
+
+    const std::shared_ptr<CollectorStats> mCollectorStats;
 };
@@ -0,0 +1,275 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "PsiMetric.h"
+#include "Log.h"
+#include "RollingWindow.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <regex>
+#include <unistd.h>
+
+static constexpr const char *kSystemPressureFile = "/proc/pressure/memory";
+
+// Creating/destroying containers is rare, so no need to look for new cgroups on every sample
+static constexpr std::chrono::seconds kCgroupScanInterval(5);
+
+PsiMetric::PsiMetric(std::shared_ptr<JsonReportGenerator> reportGenerator)
+        : mQuit(false),
+          mCv(),
+          mSystemPressure(kSystemPressureFile),
+          mCgroupPressure{},
+          mPrune(false),
+          mSomeAvg10Series("Some avg10 %"),
+          mFullAvg10Series("Full avg10 %"),
+          mSomeStallSeries("Some stall %"),
+          mFullStallSeries("Full stall %"),
+          mLastCgroupScan(),
+          mReportGenerator(std::move(reportGenerator))
+{
+
+}
+
+PsiMetric::~PsiMetric()
+{
+    if (!mQuit) {
+        StopCollection();
+    }
+}
+
+/**
+ * @return True if the kernel exposes memory PSI data
+ */
+bool PsiMetric::IsSupported()
+{
+    return access(kSystemPressureFile, R_OK) == 0;
+}
+
+void PsiMetric::EnablePruning()
+{
+    mPrune = true;
+
+    for (auto *series: {&mSomeAvg10Series, &mFullAvg10Series, &mSomeStallSeries, &mFullStallSeries}) {
+        series->SetRetention(RollingWindow::kMaxWindow);
+    }
+}
+
+void PsiMetric::StartCollection(const std::chrono::milliseconds frequency)
+{
+    mQuit = false;
+    mCollectionThread = std::thread(&PsiMetric::CollectData, this, frequency);
+}
+
+void PsiMetric::StopCollection()
+{
+    std::unique_lock<std::mutex> locker(mLock);
+    mQuit = true;
+    mCv.notify_all();
+    locker.unlock();
+
+    if (mCollectionThread.joinable()) {
+        LOG_INFO("Waiting for PsiMetric collection thread to terminate");
+        mCollectionThread.join();
+    }
+}
+
+void PsiMetric::CollectData(std::chrono::milliseconds frequency)
+{
+    std::unique_lock<std::mutex> lock(mLock);
+
+    if (!mSystemPressure.File.IsOpen()) {
+        LOG_WARN("Could not open %s - PSI not supported", kSystemPressureFile);
+        return;
+    }
+
+    do {
+        auto now = std::chrono::steady_clock::now();
+        if (now - mLastCgroupScan >= kCgroupScanInterval) {
+            FindCgroups();
+            if (mPrune) {
+                PruneCgroups();
+            }
+            mLastCgroupScan = now;
+        }
+
+        if (SamplePressure(mSystemPressure)) {
+            mSomeAvg10Series.AddDataPoint(mSystemPressure.File.SomeAvg10());
+            mFullAvg10Series.AddDataPoint(mSystemPressure.File.FullAvg10());
+
+            // Stall percentages need two samples
+            if (mSystemPressure.SomeStall.GetCount() > 0) {
+                mSomeStallSeries.AddDataPoint(mSystemPressure.SomeStall.GetLast());
+                mFullStallSeries.AddDataPoint(mSystemPressure.FullStall.GetLast());
+            }
+        }
+
+        for (auto &cgroup: mCgroupPressure) {
+            SamplePressure(cgroup.second);
+        }
+
+        // Wait for period before doing collection again, or until cancelled
+        mCv.wait_for(lock, frequency);
+    } while (!mQuit);
+
+    LOG_INFO("Collection thread quit");
+}
+
+/**
+ * Read the latest PSI values for a source and update the measurements
+ *
+ * @return False if the file could not be read
+ */
+bool PsiMetric::SamplePressure(pressureSource &source)
+{
+    auto now = std::chrono::steady_clock::now();
+
+    if (!source.File.Read()) {
+        // A container that's stopped and re-created under the same name leaves us holding the removed cgroup's file,
+        // so re-open it. The new cgroup's totals start from zero, so don't compare against the old ones
+        if (!source.File.Reopen() || !source.File.Read()) {
+            return false;
+        }
+        source.HasPrevious = false;
+    }
+
+    source.SomeAvg10.AddDataPoint(source.File.SomeAvg10());
+    source.FullAvg10.AddDataPoint(source.File.FullAvg10());
+
+    if (source.HasPrevious) {
+        auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(now - source.LastRead).count();
+
+        // Totals are monotonic, but guard against a bad read giving a huge delta
+        uint64_t someDelta = source.File.SomeTotalUs() >= source.LastSomeTotalUs ? source.File.SomeTotalUs() -
+                                                                                   source.LastSomeTotalUs : 0;
+        uint64_t fullDelta = source.File.FullTotalUs() >= source.LastFullTotalUs ? source.File.FullTotalUs() -
+                                                                                   source.LastFullTotalUs : 0;
+
+        source.SomeStallUs += someDelta;
+        source.FullStallUs += fullDelta;
+
+        if (elapsedUs > 0) {
+            source.SomeStall.AddDataPoint(std::min(100.0L, (someDelta * 100.0L) / elapsedUs));
+            source.FullStall.AddDataPoint(std::min(100.0L, (fullDelta * 100.0L) / elapsedUs));
+        }
+    }
+
+    source.HasPrevious = true;
+    source.LastSomeTotalUs = source.File.SomeTotalUs();
+    source.LastFullTotalUs = source.File.FullTotalUs();
+    source.LastRead = now;
+    source.LastSeen = now;
+
+    return true;
+}
+
+/**
+ * Look for any new cgroups with a memory.pressure file (only available with cgroups v2). Uses the same filtering
+ * as the container memory usage in MemoryMetric, so only non-systemd cgroups are monitored
+ */
+void PsiMetric::FindCgroups()
+{
+    // List of systemd-created cgroups which we are not interested in.
+    static const std::regex ignoreRegex = std::regex("(init.scope)|(.*.slice)|(.*.mount)|(.*.scope)");
+
+    // Pure cgroups v2 systems mount at /sys/fs/cgroup, hybrid systems mount the v2 hierarchy under unified/
+    const std::vector<std::filesystem::path> cgroupRoots{"/sys/fs/cgroup", "/sys/fs/cgroup/unified"};
+
+    for (const auto &root: cgroupRoots) {
+        std::error_code ec;
+        for (const auto &dirEntry: std::filesystem::directory_iterator(root, ec)) {
+            // Skip the unified hierarchy mountpoint itself, that's the root cgroup so is covered by the system PSI
+            if (!dirEntry.is_directory(ec) ||
+                std::find(cgroupRoots.begin(), cgroupRoots.end(), dirEntry.path()) != cgroupRoots.end()) {
+                continue;
+            }
+
+            auto cgroupName = dirEntry.path().filename().string();
+            if (std::regex_match(cgroupName, ignoreRegex) || mCgroupPressure.count(cgroupName) != 0) {
+                continue;
+            }
+
+            auto pressureFile = dirEntry.path() / "memory.pressure";
+            if (!std::filesystem::exists(pressureFile, ec)) {
+                continue;
+            }
+
+            pressureSource source(pressureFile.string());
+            if (source.File.IsOpen()) {
+                source.LastSeen = std::chrono::steady_clock::now();
+                LOG_INFO("Monitoring memory pressure for cgroup %s", cgroupName.c_str());
+                mCgroupPressure.emplace(cgroupName, std::move(source));
+            }
+        }
+    }
+}
+
+void PsiMetric::PruneCgroups()
+{
+    auto now = std::chrono::steady_clock::now();
+
+    for (auto itr = mCgroupPressure.begin(); itr != mCgroupPressure.end();) {
+        if (now - itr->second.LastSeen > RollingWindow::kMaxWindow) {
+            LOG_INFO("Stopped monitoring memory pressure for removed cgroup %s", itr->first.c_str());
+            itr = mCgroupPressure.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
+
+void PsiMetric::SaveResults()
+{
+    // Can be called whilst collection is running when saving a snapshot
+    std::lock_guard<std::mutex> locker(mLock);
+
+    if (mSystemPressure.SomeAvg10.GetCount() == 0) {
+        // Never managed to read anything
+        return;
+    }
+
+    std::vector<JsonReportGenerator::dataItems> data{};
+
+    auto addRow = [&](const std::string &name, const pressureSource &source)
+    {
+        data.emplace_back(JsonReportGenerator::dataItems{
+                std::make_pair("Source", name),
+                source.SomeAvg10,
+                source.FullAvg10,
+                source.SomeStall,
+                source.FullStall,
+                std::make_pair("Total_Some_Stall_ms", std::to_string(source.SomeStallUs / 1000)),
+                std::make_pair("Total_Full_Stall_ms", std::to_string(source.FullStallUs / 1000))
+        });
+    };
+
+    addRow("System", mSystemPressure);
+    for (const auto &cgroup: mCgroupPressure) {
+        addRow(cgroup.first, cgroup.second);
+    }
+
+    mReportGenerator->addDataset("Memory Pressure (PSI)", data);
+
+    mReportGenerator->addTimeSeries("Memory Pressure (PSI)", {
+            mSomeAvg10Series,
+            mFullAvg10Series,
+            mSomeStallSeries,
+            mFullStallSeries
+    });
+}
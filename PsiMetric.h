@@ -0,0 +1,122 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "IMetric.h"
+
+#include <thread>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include "JsonReportGenerator.h"
+#include "Measurement.h"
+#include "TimeSeries.h"
+#include "FileParsers/Pressure.h"
+
+/**
+ * @brief Samples memory pressure stall information (PSI) for the system and for each container cgroup
+ *
+ * Reading PSI is cheap (a single small file per source), so this is designed to run at a much higher frequency than
+ * the other metrics to capture short periods of memory pressure. Requires a kernel built with CONFIG_PSI
+ */
+class PsiMetric : public IMetric
+{
+public:
+    explicit PsiMetric(std::shared_ptr<JsonReportGenerator> reportGenerator);
+
+    ~PsiMetric() override;
+
+    static bool IsSupported();
+
+    void StartCollection(std::chrono::milliseconds frequency) override;
+
+    void StopCollection() override;
+
+    void SaveResults() override;
+
+    /**
+     * Forget cgroups that haven't been readable for longer than the largest rolling window, as containers come and go,
+     * and only chart the largest window. Used when running indefinitely. Must be called before collection starts
+     */
+    void EnablePruning();
+
+private:
+    struct pressureSource
+    {
+        explicit pressureSource(const std::string &path)
+                : File(path),
+                  SomeAvg10("Some_Avg10_%"),
+                  FullAvg10("Full_Avg10_%"),
+                  SomeStall("Some_Stall_%"),
+                  FullStall("Full_Stall_%")
+        {
+        }
+
+        Pressure File;
+
+        Measurement SomeAvg10;
+        Measurement FullAvg10;
+
+        // Percentage of wall-clock time spent stalled between each sample, calculated from the total stall times
+        Measurement SomeStall;
+        Measurement FullStall;
+
+        // Sum of all stall time seen during the capture
+        uint64_t SomeStallUs = 0;
+        uint64_t FullStallUs = 0;
+
+        bool HasPrevious = false;
+        uint64_t LastSomeTotalUs = 0;
+        uint64_t LastFullTotalUs = 0;
+        std::chrono::steady_clock::time_point LastRead;
+
+        // Last time the file was read successfully, or when it was found
+        std::chrono::steady_clock::time_point LastSeen;
+    };
+
+private:
+    void CollectData(std::chrono::milliseconds frequency);
+
+    bool SamplePressure(pressureSource &source);
+
+    void FindCgroups();
+
+    void PruneCgroups();
+
+private:
+    std::thread mCollectionThread;
+    bool mQuit;
+    std::condition_variable mCv;
+    std::mutex mLock;
+
+    pressureSource mSystemPressure;
+    std::map<std::string, pressureSource> mCgroupPressure;
+
+    bool mPrune;
+
+    TimeSeries mSomeAvg10Series;
+    TimeSeries mFullAvg10Series;
+    TimeSeries mSomeStallSeries;
+    TimeSeries mFullStallSeries;
+
+    std::chrono::steady_clock::time_point mLastCgroupScan;
+
+    const std::shared_ptr<JsonReportGenerator> mReportGenerator;
+};
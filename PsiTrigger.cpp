@@ -0,0 +1,157 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "PsiTrigger.h"
+#include "Log.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <cerrno>
+#include <cstdint>
+#include <utility>
+
+PsiTrigger::PsiTrigger(std::chrono::microseconds stallThreshold, std::chrono::microseconds window)
+        : mStallThreshold(stallThreshold),
+          mWindow(window),
+          mPsiFd(-1),
+          mStopFd(-1),
+          mTriggerCount(0)
+{
+
+}
+
+PsiTrigger::~PsiTrigger()
+{
+    Stop();
+}
+
+/**
+ * Register the trigger with the kernel and start waiting for events
+ *
+ * @param onTrigger Callback to run (on the trigger thread) each time the threshold is exceeded
+ * @return False if the trigger could not be registered
+ */
+bool PsiTrigger::Start(std::function<void()> onTrigger)
+{
+    mPsiFd = open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (mPsiFd < 0) {
+        LOG_SYS_WARN(errno, "Failed to open /proc/pressure/memory");
+        return false;
+    }
+
+    char trigger[64];
+    int len = snprintf(trigger, sizeof(trigger), "some %lld %lld", (long long) mStallThreshold.count(),
+                       (long long) mWindow.count());
+
+    // Kernel expects the trailing null terminator to be written
+    bool registered = write(mPsiFd, trigger, len + 1) >= 0;
+
+    // Without CAP_SYS_RESOURCE, newer kernels only accept windows that are a multiple of 2s. Fall back to the
+    // nearest allowed window rather than giving up
+    constexpr long long unprivilegedWindowUs = 2000000;
+    if (!registered && errno == EINVAL && mWindow.count() % unprivilegedWindowUs != 0) {
+        long long window = ((mWindow.count() / unprivilegedWindowUs) + 1) * unprivilegedWindowUs;
+        LOG_WARN("Failed to register PSI trigger '%s', retrying with a %lld us window", trigger, window);
+
+        len = snprintf(trigger, sizeof(trigger), "some %lld %lld", (long long) mStallThreshold.count(), window);
+        registered = write(mPsiFd, trigger, len + 1) >= 0;
+    }
+
+    if (!registered) {
+        LOG_SYS_WARN(errno, "Failed to register PSI trigger '%s'", trigger);
+        close(mPsiFd);
+        mPsiFd = -1;
+        return false;
+    }
+
+    mStopFd = eventfd(0, EFD_CLOEXEC);
+    if (mStopFd < 0) {
+        LOG_SYS_WARN(errno, "Failed to create eventfd");
+        close(mPsiFd);
+        mPsiFd = -1;
+        return false;
+    }
+
+    LOG_INFO("Registered PSI trigger '%s'", trigger);
+
+    mOnTrigger = std::move(onTrigger);
+    mThread = std::thread(&PsiTrigger::WaitForEvents, this);
+    return true;
+}
+
+void PsiTrigger::Stop()
+{
+    if (mStopFd >= 0) {
+        uint64_t value = 1;
+        if (write(mStopFd, &value, sizeof(value)) < 0) {
+            LOG_SYS_WARN(errno, "Failed to signal PSI trigger thread");
+        }
+    }
+
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+
+    // Closing the file removes the trigger
+    if (mPsiFd >= 0) {
+        close(mPsiFd);
+        mPsiFd = -1;
+    }
+
+    if (mStopFd >= 0) {
+        close(mStopFd);
+        mStopFd = -1;
+    }
+}
+
+void PsiTrigger::WaitForEvents()
+{
+    struct pollfd fds[2] = {
+            {mPsiFd,  POLLPRI, 0},
+            {mStopFd, POLLIN,  0}
+    };
+
+    while (true) {
+        int ret = poll(fds, 2, -1);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_SYS_ERROR(errno, "poll() failed waiting for PSI events");
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+
+        if (fds[0].revents & POLLERR) {
+            LOG_WARN("PSI trigger event source is gone");
+            break;
+        }
+
+        if (fds[0].revents & POLLPRI) {
+            int count = ++mTriggerCount;
+            LOG_INFO("Memory pressure threshold exceeded (event %d)", count);
+            mOnTrigger();
+        }
+    }
+}
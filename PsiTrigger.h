@@ -0,0 +1,63 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+/**
+ * @brief Registers a kernel PSI trigger on /proc/pressure/memory and invokes a callback each time it fires
+ *
+ * The kernel will notify at most once per window while the stall threshold is exceeded, so the callback does not
+ * need to do its own rate limiting. See https://docs.kernel.org/accounting/psi.html#monitoring-for-pressure-thresholds
+ */
+class PsiTrigger
+{
+public:
+    PsiTrigger(std::chrono::microseconds stallThreshold, std::chrono::microseconds window);
+
+    ~PsiTrigger();
+
+    bool Start(std::function<void()> onTrigger);
+
+    void Stop();
+
+    int TriggerCount() const
+    {
+        return mTriggerCount;
+    }
+
+private:
+    void WaitForEvents();
+
+private:
+    const std::chrono::microseconds mStallThreshold;
+    const std::chrono::microseconds mWindow;
+
+    int mPsiFd;
+    int mStopFd;
+
+    std::thread mThread;
+    std::function<void()> mOnTrigger;
+
+    std::atomic<int> mTriggerCount;
+};
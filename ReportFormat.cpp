@@ -0,0 +1,163 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "ReportFormat.h"
+#include "Log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::optional<ReportFormat> ParseReportFormat(const std::string &name)
+{
+    if (name == "json") {
+        return ReportFormat::Json;
+    } else if (name == "json-compact") {
+        return ReportFormat::JsonCompact;
+    } else if (name == "cbor") {
+        return ReportFormat::Cbor;
+    } else if (name == "msgpack") {
+        return ReportFormat::MsgPack;
+    }
+
+    return std::nullopt;
+}
+
+std::string ReportExtension(ReportFormat format)
+{
+    switch (format) {
+        case ReportFormat::Cbor:
+            return ".cbor";
+        case ReportFormat::MsgPack:
+            return ".msgpack";
+        case ReportFormat::Json:
+        case ReportFormat::JsonCompact:
+        default:
+            return ".json";
+    }
+}
+
+bool WriteReport(const nlohmann::json &report, ReportFormat format, const std::filesystem::path &path)
+{
+    std::ofstream output(path, std::ios::trunc | std::ios::binary);
+    if (!output) {
+        LOG_ERROR("Failed to open %s", path.string().c_str());
+        return false;
+    }
+
+    switch (format) {
+        case ReportFormat::Json:
+            output << report.dump(4);
+            break;
+        case ReportFormat::JsonCompact:
+            output << report.dump();
+            break;
+        case ReportFormat::Cbor:
+            nlohmann::json::to_cbor(report, output);
+            break;
+        case ReportFormat::MsgPack:
+            nlohmann::json::to_msgpack(report, output);
+            break;
+    }
+
+    return output.good();
+}
+
+namespace
+{
+/**
+ * Read-only mapping of a whole file. Parsing straight from the mapping saves copying large reports into a buffer first
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::filesystem::path &path)
+    {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open " + path.string() + ": " + strerror(errno));
+        }
+
+        struct stat st = {};
+        if (fstat(fd, &st) < 0) {
+            close(fd);
+            throw std::runtime_error("Failed to stat " + path.string() + ": " + strerror(errno));
+        }
+
+        mSize = static_cast<size_t>(st.st_size);
+        if (mSize > 0) {
+            mData = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+
+        if (mData == MAP_FAILED) {
+            throw std::runtime_error("Failed to map " + path.string() + ": " + strerror(errno));
+        }
+
+        if (mData) {
+            madvise(mData, mSize, MADV_SEQUENTIAL);
+        }
+    }
+
+    ~MappedFile()
+    {
+        if (mData && mData != MAP_FAILED) {
+            munmap(mData, mSize);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *begin() const
+    {
+        return static_cast<const uint8_t *>(mData);
+    }
+
+    const uint8_t *end() const
+    {
+        return begin() + mSize;
+    }
+
+private:
+    void *mData = nullptr;
+    size_t mSize = 0;
+};
+}
+
+nlohmann::json ReadReport(const std::filesystem::path &path)
+{
+    MappedFile file(path);
+
+    auto extension = path.extension().string();
+    if (extension == ReportExtension(ReportFormat::Cbor)) {
+        return nlohmann::json::from_cbor(file.begin(), file.end());
+    } else if (extension == ReportExtension(ReportFormat::MsgPack)) {
+        return nlohmann::json::from_msgpack(file.begin(), file.end());
+    }
+
+    return nlohmann::json::parse(file.begin(), file.end());
+}
@@ -0,0 +1,61 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief Encodings the data report can be saved in
+ *
+ * JSON is the most readable, the binary formats are smaller and quicker to produce and parse when reports are being
+ * collected from a lot of devices
+ */
+enum class ReportFormat
+{
+    Json,
+    JsonCompact,
+    Cbor,
+    MsgPack
+};
+
+/**
+ * @param name As given on the command line - json, json-compact, cbor or msgpack
+ */
+std::optional<ReportFormat> ParseReportFormat(const std::string &name);
+
+/**
+ * File extension (including the '.') for a data report in this format
+ */
+std::string ReportExtension(ReportFormat format);
+
+/**
+ * Write the data report in the given format
+ * @return False if the file couldn't be written
+ */
+bool WriteReport(const nlohmann::json &report, ReportFormat format, const std::filesystem::path &path);
+
+/**
+ * Read a data report written in any format, detected from the file extension. Throws on failure
+ */
+nlohmann::json ReadReport(const std::filesystem::path &path);
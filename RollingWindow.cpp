@@ -0,0 +1,95 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "RollingWindow.h"
+
+#include <algorithm>
+
+RollingWindow::RollingWindow() : mFineBuckets(), mCoarseBuckets()
+{
+}
+
+template<size_t N>
+void RollingWindow::add(std::array<Bucket, N> &buckets, int64_t index, double value)
+{
+    auto &bucket = buckets[index % N];
+
+    if (bucket.Index != index) {
+        // Bucket last held data from a previous time round the ring, start again
+        bucket = Bucket();
+        bucket.Index = index;
+        bucket.Min = value;
+        bucket.Max = value;
+    }
+
+    bucket.Min = std::min(bucket.Min, value);
+    bucket.Max = std::max(bucket.Max, value);
+    bucket.Sum += value;
+    bucket.Count++;
+}
+
+template<size_t N>
+RollingWindow::Summary RollingWindow::summarise(const std::array<Bucket, N> &buckets, int64_t newest, int64_t count)
+{
+    Summary summary;
+    long double sum = 0;
+
+    for (const auto &bucket: buckets) {
+        if (bucket.Count == 0 || bucket.Index > newest || bucket.Index <= newest - count) {
+            continue;
+        }
+
+        if (summary.Count == 0) {
+            summary.Min = bucket.Min;
+            summary.Max = bucket.Max;
+        } else {
+            summary.Min = std::min<long double>(summary.Min, bucket.Min);
+            summary.Max = std::max<long double>(summary.Max, bucket.Max);
+        }
+
+        sum += bucket.Sum;
+        summary.Count += bucket.Count;
+    }
+
+    if (summary.Count > 0) {
+        summary.Average = sum / summary.Count;
+    }
+
+    return summary;
+}
+
+void RollingWindow::AddDataPoint(long double value)
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+
+    add(mFineBuckets, now / kFineBucketWidth, static_cast<double>(value));
+    add(mCoarseBuckets, now / kCoarseBucketWidth, static_cast<double>(value));
+}
+
+RollingWindow::Summary RollingWindow::Get(std::chrono::seconds window) const
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    window = std::min<std::chrono::seconds>(window, kMaxWindow);
+
+    if (window <= kFineBucketWidth * mFineBuckets.size()) {
+        return summarise(mFineBuckets, now / kFineBucketWidth, window / kFineBucketWidth);
+    }
+
+    return summarise(mCoarseBuckets, now / kCoarseBucketWidth, window / kCoarseBucketWidth);
+}
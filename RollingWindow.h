@@ -0,0 +1,77 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Min/max/average of a value over the last 1 minute, 15 minutes and 1 hour using a fixed amount of memory
+ *
+ * Data points are summarised into time buckets - 10 second buckets for the last minute and 1 minute buckets for
+ * anything longer - so a window's values are accurate to within one bucket. Used when running as a daemon where
+ * keeping every data point isn't an option
+ */
+class RollingWindow
+{
+public:
+    struct Summary
+    {
+        long double Min = 0;
+        long double Max = 0;
+        long double Average = 0;
+        uint32_t Count = 0;
+    };
+
+    static constexpr std::chrono::minutes kMaxWindow{60};
+
+    RollingWindow();
+
+    void AddDataPoint(long double value);
+
+    /**
+     * @param window How far back to look, up to kMaxWindow
+     */
+    Summary Get(std::chrono::seconds window) const;
+
+private:
+    struct Bucket
+    {
+        int64_t Index = -1;
+        double Min = 0;
+        double Max = 0;
+        double Sum = 0;
+        uint32_t Count = 0;
+    };
+
+    static constexpr std::chrono::seconds kFineBucketWidth{10};
+    static constexpr std::chrono::seconds kCoarseBucketWidth{60};
+
+    template<size_t N>
+    static void add(std::array<Bucket, N> &buckets, int64_t index, double value);
+
+    template<size_t N>
+    static Summary summarise(const std::array<Bucket, N> &buckets, int64_t newest, int64_t count);
+
+private:
+    std::array<Bucket, 6> mFineBuckets;
+    std::array<Bucket, 60> mCoarseBuckets;
+};
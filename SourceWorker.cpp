@@ -0,0 +1,174 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SourceWorker.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <pthread.h>
+
+// Cap how long a misbehaving source is skipped for so it's picked up again if it recovers
+static constexpr unsigned int kMaxBackoff = 16;
+
+SourceWorker::SourceWorker(std::string name, std::chrono::milliseconds deadline, std::function<void()> source,
+                           std::shared_ptr<CollectorStats> collectorStats)
+        : mName(std::move(name)),
+          mDeadline(deadline),
+          mSource(std::move(source)),
+          mCollectorStats(std::move(collectorStats)),
+          mQuit(false),
+          mRunRequested(false),
+          mRunning(false),
+          mWaiting(false),
+          mBackoff(0),
+          mSkipRemaining(0),
+          mDuration("Duration_ms"),
+          mTimeouts(0),
+          mSkipped(0),
+          mStale(0)
+{
+    mThread = std::thread(&SourceWorker::Run, this);
+}
+
+SourceWorker::~SourceWorker()
+{
+    Stop();
+}
+
+std::chrono::steady_clock::time_point SourceWorker::Trigger()
+{
+    std::lock_guard<std::mutex> locker(mLock);
+    auto now = std::chrono::steady_clock::now();
+
+    if (mRunning || mRunRequested) {
+        // Still stuck from a previous timeout
+        mSkipped++;
+        mWaiting = false;
+        return now;
+    }
+
+    if (mSkipRemaining > 0) {
+        mSkipRemaining--;
+        mSkipped++;
+        mWaiting = false;
+        return now;
+    }
+
+    mRunRequested = true;
+    mWaiting = true;
+    mCv.notify_all();
+
+    return now + mDeadline;
+}
+
+void SourceWorker::Wait(std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> locker(mLock);
+
+    if (!mWaiting) {
+        return;
+    }
+    mWaiting = false;
+
+    bool finished = mCv.wait_until(locker, deadline, [&]
+    {
+        return !mRunRequested && !mRunning;
+    });
+
+    if (finished) {
+        mBackoff = 0;
+        return;
+    }
+
+    mTimeouts++;
+    mBackoff = std::min(std::max(mBackoff * 2, 1u), kMaxBackoff);
+    mSkipRemaining = mBackoff;
+
+    LOG_WARN("%s did not complete within %lld ms - skipping for %u samples", mName.c_str(),
+             (long long) mDeadline.count(), mBackoff);
+}
+
+bool SourceWorker::WaitIdle(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> locker(mLock);
+
+    bool idle = mCv.wait_for(locker, timeout, [&]
+    {
+        return !mRunRequested && !mRunning;
+    });
+
+    if (!idle) {
+        mStale++;
+        LOG_WARN("%s still hasn't completed after %lld ms - leaving its results out", mName.c_str(),
+                 (long long) timeout.count());
+    }
+
+    return idle;
+}
+
+void SourceWorker::Stop()
+{
+    std::unique_lock<std::mutex> locker(mLock);
+    mQuit = true;
+    mCv.notify_all();
+
+    if (mRunning) {
+        LOG_WARN("Waiting for %s to finish", mName.c_str());
+    }
+    locker.unlock();
+
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+void SourceWorker::Run()
+{
+    // Makes the worker easy to find in top and traces. Thread names are limited to 15 characters
+    pthread_setname_np(pthread_self(), mName.substr(0, 15).c_str());
+
+    std::unique_lock<std::mutex> locker(mLock);
+
+    while (true) {
+        mCv.wait(locker, [&]
+        {
+            return mQuit || mRunRequested;
+        });
+
+        if (mQuit) {
+            break;
+        }
+
+        mRunRequested = false;
+        mRunning = true;
+        locker.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            CollectorStats::ScopedSample sample(mCollectorStats.get(), mName, true);
+            mSource();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        locker.lock();
+        mRunning = false;
+        mDuration.AddDataPoint(std::chrono::duration<long double, std::milli>(end - start).count());
+        mCv.notify_all();
+    }
+}
@@ -0,0 +1,132 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "Measurement.h"
+#include "CollectorStats.h"
+
+/**
+ * @brief Runs a single data source on its own thread so it can be given a deadline
+ *
+ * Some sources (mostly debugfs files) take driver locks and can block for seconds at a time. Running each source on
+ * a worker means the caller can stop waiting once the deadline passes and carry on with the other sources. A source
+ * that overruns is left to finish in the background and is skipped for an increasing number of samples afterwards so
+ * it doesn't keep delaying the capture.
+ *
+ * The source function is only ever run on the worker thread and never concurrently with itself, so anything it
+ * writes to must not be touched by anyone else until the worker has been stopped
+ */
+class SourceWorker
+{
+public:
+    SourceWorker(std::string name, std::chrono::milliseconds deadline, std::function<void()> source,
+                 std::shared_ptr<CollectorStats> collectorStats = nullptr);
+
+    ~SourceWorker();
+
+    SourceWorker(const SourceWorker &) = delete;
+
+    SourceWorker &operator=(const SourceWorker &) = delete;
+
+    /**
+     * Start running the source, unless the previous run hasn't finished yet or the source is backing off
+     * @return The time the caller should wait until for this run to complete
+     */
+    std::chrono::steady_clock::time_point Trigger();
+
+    /**
+     * Wait for the current run to finish, up to the deadline. Records a timeout if it doesn't finish in time
+     */
+    void Wait(std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * Wait for any in-progress run to finish, up to the timeout. Used before reading the source's results whilst
+     * collection is still running
+     *
+     * @return False if the source is still running, in which case its results must not be read yet. Counted as stale
+     */
+    bool WaitIdle(std::chrono::milliseconds timeout);
+
+    /**
+     * Wait for any in-progress run to finish and stop the worker thread. The source may still be using whatever it
+     * writes to, so this always joins the thread however long the source takes
+     */
+    void Stop();
+
+    const std::string &Name() const
+    {
+        return mName;
+    }
+
+    Measurement Duration() const
+    {
+        std::lock_guard<std::mutex> locker(mLock);
+        return mDuration;
+    }
+
+    unsigned int Timeouts() const
+    {
+        return mTimeouts;
+    }
+
+    unsigned int Skipped() const
+    {
+        return mSkipped;
+    }
+
+    unsigned int Stale() const
+    {
+        return mStale;
+    }
+
+private:
+    void Run();
+
+private:
+    const std::string mName;
+    const std::chrono::milliseconds mDeadline;
+    const std::function<void()> mSource;
+    const std::shared_ptr<CollectorStats> mCollectorStats;
+
+    std::thread mThread;
+    mutable std::mutex mLock;
+    std::condition_variable mCv;
+
+    bool mQuit;
+    bool mRunRequested;
+    bool mRunning;
+    bool mWaiting;
+
+    // Number of samples to skip after a timeout, doubles on each consecutive timeout
+    unsigned int mBackoff;
+    unsigned int mSkipRemaining;
+
+    Measurement mDuration;
+    unsigned int mTimeouts;
+    unsigned int mSkipped;
+    unsigned int mStale;
+};
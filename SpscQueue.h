@@ -0,0 +1,87 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+/**
+ * @brief Fixed-size lock-free queue for exactly one producer thread and one consumer thread
+ *
+ * Push() and Pop() never block or allocate (beyond moving the item), so the producer is never held up by the
+ * consumer. When the queue is full Push() fails and it's up to the producer what to do with the item.
+ *
+ * Capacity must be a power of two
+ */
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : mHead(0), mTail(0)
+    {
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    /**
+     * Producer only
+     * @return False if the queue is full
+     */
+    bool Push(T item)
+    {
+        auto tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+
+        mItems[tail & (Capacity - 1)] = std::move(item);
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer only
+     */
+    std::optional<T> Pop()
+    {
+        auto head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+
+        std::optional<T> item(std::move(mItems[head & (Capacity - 1)]));
+        mHead.store(head + 1, std::memory_order_release);
+        return item;
+    }
+
+private:
+    std::array<T, Capacity> mItems;
+
+    // Kept on separate cache lines so the producer and consumer don't keep invalidating each other
+    alignas(64) std::atomic<size_t> mHead;
+    alignas(64) std::atomic<size_t> mTail;
+};
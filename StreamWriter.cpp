@@ -0,0 +1,141 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "StreamWriter.h"
+#include "Log.h"
+
+#include <cerrno>
+#include <chrono>
+#include <pthread.h>
+
+// How long the writer sleeps when there's nothing queued. Collection ticks are seconds apart so this only adds a
+// little latency, and saves the collectors from having to signal the writer
+static constexpr std::chrono::milliseconds kWriterPollInterval(20);
+
+StreamWriter::StreamWriter(const std::filesystem::path &path)
+        : mOutput(nullptr),
+          mOwnsOutput(false),
+          mFailed(false),
+          mDropped(0),
+          mQuit(false)
+{
+    if (path == "-") {
+        mOutput = stdout;
+    } else {
+        mOutput = fopen(path.c_str(), "we");
+        mOwnsOutput = true;
+
+        if (!mOutput) {
+            LOG_SYS_ERROR(errno, "Failed to open stream output %s", path.string().c_str());
+            return;
+        }
+    }
+
+    mThread = std::thread(&StreamWriter::Run, this);
+}
+
+StreamWriter::~StreamWriter()
+{
+    Close();
+}
+
+void StreamWriter::Write(Source source, nlohmann::json record)
+{
+    if (!mOutput) {
+        return;
+    }
+
+    record["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+    if (!mQueues[static_cast<size_t>(source)].Push(record.dump())) {
+        mDropped++;
+    }
+}
+
+void StreamWriter::Close()
+{
+    if (!mOutput) {
+        return;
+    }
+
+    mQuit = true;
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+
+    if (mDropped > 0) {
+        LOG_WARN("Dropped %u stream records because the output couldn't keep up", mDropped.load());
+    }
+
+    if (mOwnsOutput) {
+        fclose(mOutput);
+    } else {
+        fflush(mOutput);
+    }
+    mOutput = nullptr;
+}
+
+void StreamWriter::Run()
+{
+    pthread_setname_np(pthread_self(), "StreamWriter");
+
+    while (!mQuit) {
+        if (!drain()) {
+            std::this_thread::sleep_for(kWriterPollInterval);
+        }
+    }
+
+    // Producers have stopped, pick up anything pushed before they did
+    drain();
+}
+
+/**
+ * Write everything currently queued
+ * @return True if anything was written
+ */
+bool StreamWriter::drain()
+{
+    bool written = false;
+
+    for (auto &queue: mQueues) {
+        while (auto line = queue.Pop()) {
+            written = true;
+
+            // Keep draining if the reader has gone away so the producers don't start dropping, just discard the data
+            if (mFailed) {
+                continue;
+            }
+
+            line->push_back('\n');
+            if (fwrite(line->data(), 1, line->size(), mOutput) != line->size()) {
+                LOG_SYS_WARN(errno, "Failed to write to stream output, no more records will be written");
+                mFailed = true;
+            }
+        }
+    }
+
+    // Flush per batch so a reader on a pipe sees each tick as soon as it's written
+    if (written && !mFailed && fflush(mOutput) != 0) {
+        LOG_SYS_WARN(errno, "Failed to write to stream output, no more records will be written");
+        mFailed = true;
+    }
+
+    return written;
+}
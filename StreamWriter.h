@@ -0,0 +1,95 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+#include "SpscQueue.h"
+
+/**
+ * @brief Writes newline-delimited JSON records to a file or stdout as they're collected
+ *
+ * Each collection thread gets its own single-producer queue, and a writer thread drains them all to the output. The
+ * collectors only ever serialise the record and push it, so a slow reader on the other end of a pipe can't hold up
+ * collection. If a queue fills up because the writer can't keep up, the record is dropped and counted instead.
+ */
+class StreamWriter
+{
+public:
+    // One per producer thread, since each queue only supports a single producer
+    enum class Source
+    {
+        System,
+        Processes,
+        Count
+    };
+
+    /**
+     * @param path File to write to, or "-" for stdout
+     */
+    explicit StreamWriter(const std::filesystem::path &path);
+
+    ~StreamWriter();
+
+    StreamWriter(const StreamWriter &) = delete;
+
+    StreamWriter &operator=(const StreamWriter &) = delete;
+
+    bool IsOpen() const
+    {
+        return mOutput != nullptr;
+    }
+
+    /**
+     * Queue a record to be written, stamped with the current wall-clock time. Must only be called from the thread that
+     * owns the source
+     */
+    void Write(Source source, nlohmann::json record);
+
+    /**
+     * Write out anything still queued and close the output. Collection must have stopped first
+     */
+    void Close();
+
+private:
+    void Run();
+
+    bool drain();
+
+private:
+    static constexpr size_t kQueueSize = 256;
+
+    FILE *mOutput;
+    bool mOwnsOutput;
+    bool mFailed;
+
+    std::array<SpscQueue<std::string, kQueueSize>, static_cast<size_t>(Source::Count)> mQueues;
+    std::atomic<unsigned int> mDropped;
+
+    std::atomic<bool> mQuit;
+    std::thread mThread;
+};
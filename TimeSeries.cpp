@@ -0,0 +1,112 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "TimeSeries.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+TimeSeries::TimeSeries(std::string name)
+        : mName(std::move(name)),
+          mRetention(0),
+          mDataPoints()
+{
+
+}
+
+/**
+ * @brief Add a new data point, timestamped with the current time
+ * @param value Data point to add
+ */
+void TimeSeries::AddDataPoint(long double value)
+{
+    auto now = std::chrono::steady_clock::now();
+    mDataPoints.emplace_back(now, value);
+
+    if (mRetention.count() > 0) {
+        while (now - mDataPoints.front().first > mRetention) {
+            mDataPoints.pop_front();
+        }
+    }
+}
+
+void TimeSeries::SetRetention(std::chrono::seconds retention)
+{
+    mRetention = retention;
+}
+
+std::string TimeSeries::GetName() const
+{
+    return mName;
+}
+
+size_t TimeSeries::GetCount() const
+{
+    return mDataPoints.size();
+}
+
+/**
+ * @brief Convert the series to an array of [seconds, value] pairs
+ *
+ * @param start Time the capture started - timestamps are reported as seconds relative to this
+ */
+nlohmann::json TimeSeries::ToJson(std::chrono::steady_clock::time_point start, size_t maxPoints) const
+{
+    nlohmann::json data = nlohmann::json::array();
+
+    auto addPoint = [&](const std::pair<std::chrono::steady_clock::time_point, long double> &point)
+    {
+        auto offsetMs = std::chrono::duration_cast<std::chrono::milliseconds>(point.first - start).count();
+
+        // Keep two decimal places - plenty for plotting and keeps the report size down
+        data.push_back({offsetMs / 1000.0, std::round(point.second * 100) / 100.0});
+    };
+
+    if (maxPoints < 2 || mDataPoints.size() <= maxPoints) {
+        for (const auto &point: mDataPoints) {
+            addPoint(point);
+        }
+        return data;
+    }
+
+    // Two points (the min and max, in time order) are kept from each bucket
+    size_t bucketSize = (mDataPoints.size() + maxPoints / 2 - 1) / (maxPoints / 2);
+
+    for (size_t bucketStart = 0; bucketStart < mDataPoints.size(); bucketStart += bucketSize) {
+        size_t bucketEnd = std::min(bucketStart + bucketSize, mDataPoints.size());
+
+        size_t min = bucketStart;
+        size_t max = bucketStart;
+        for (size_t i = bucketStart + 1; i < bucketEnd; i++) {
+            if (mDataPoints[i].second < mDataPoints[min].second) {
+                min = i;
+            }
+            if (mDataPoints[i].second > mDataPoints[max].second) {
+                max = i;
+            }
+        }
+
+        addPoint(mDataPoints[std::min(min, max)]);
+        if (min != max) {
+            addPoint(mDataPoints[std::max(min, max)]);
+        }
+    }
+
+    return data;
+}
@@ -0,0 +1,62 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief Container for a series of timestamped data points, used to plot how a value changed over the capture
+ *
+ * Where a Measurement only keeps the running min/max/average, a TimeSeries keeps every data point so should only be
+ * used for a small number of system-wide values
+ */
+class TimeSeries
+{
+public:
+    explicit TimeSeries(std::string name);
+
+public:
+    void AddDataPoint(long double value);
+
+    std::string GetName() const;
+
+    size_t GetCount() const;
+
+    /**
+     * @param maxPoints If there are more data points than this, each run of points is reduced to its lowest and
+     * highest values so the chart keeps its shape (and any spikes) without every point. Zero keeps every point
+     */
+    nlohmann::json ToJson(std::chrono::steady_clock::time_point start, size_t maxPoints = 0) const;
+
+    /**
+     * Only keep data points newer than this, so memory usage stays flat when running as a daemon. Zero (the default)
+     * keeps everything
+     */
+    void SetRetention(std::chrono::seconds retention);
+
+private:
+    std::string mName;
+    std::chrono::seconds mRetention;
+
+    std::deque<std::pair<std::chrono::steady_clock::time_point, long double>> mDataPoints;
+};
@@ -0,0 +1,145 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "TraceRecorder.h"
+#include "Log.h"
+
+#include <cinttypes>
+#include <cstring>
+#include <fstream>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "nlohmann/json.hpp"
+
+static std::atomic<uint64_t> gNextRecorderId{1};
+
+static thread_local uint64_t tRecorderId = 0;
+static thread_local void *tBuffer = nullptr;
+
+TraceRecorder::TraceRecorder() : mId(gNextRecorderId++)
+{
+}
+
+TraceRecorder::~TraceRecorder() = default;
+
+TraceRecorder::ThreadBuffer *TraceRecorder::threadBuffer()
+{
+    if (tRecorderId == mId) {
+        return static_cast<ThreadBuffer *>(tBuffer);
+    }
+
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->Tid = static_cast<pid_t>(syscall(SYS_gettid));
+
+    char name[16] = {};
+    if (pthread_getname_np(pthread_self(), name, sizeof(name)) == 0) {
+        buffer->ThreadName = name;
+    }
+
+    std::lock_guard<std::mutex> locker(mLock);
+    mBuffers.emplace_back(std::move(buffer));
+
+    tRecorderId = mId;
+    tBuffer = mBuffers.back().get();
+
+    return mBuffers.back().get();
+}
+
+void TraceRecorder::AddSpan(const std::string &name, std::chrono::steady_clock::time_point start,
+                            std::chrono::steady_clock::time_point end)
+{
+    auto *buffer = threadBuffer();
+
+    uint64_t count = buffer->Count.load(std::memory_order_relaxed);
+    auto &span = buffer->Spans[count % kSpansPerThread];
+
+    strncpy(span.Name, name.c_str(), sizeof(span.Name) - 1);
+    span.Name[sizeof(span.Name) - 1] = '\0';
+    span.StartUs = std::chrono::duration_cast<std::chrono::microseconds>(start.time_since_epoch()).count();
+    span.DurationUs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+    buffer->Count.store(count + 1, std::memory_order_release);
+}
+
+bool TraceRecorder::Write(const std::filesystem::path &path) const
+{
+    const pid_t pid = getpid();
+
+    nlohmann::json trace;
+    trace["displayTimeUnit"] = "ms";
+    trace["traceEvents"] = nlohmann::json::array();
+
+    auto &events = trace["traceEvents"];
+
+    events.push_back({
+                             {"name", "process_name"},
+                             {"ph",   "M"},
+                             {"pid",  pid},
+                             {"args", {{"name", "MemCapture"}}}
+                     });
+
+    uint64_t dropped = 0;
+
+    std::lock_guard<std::mutex> locker(mLock);
+    for (const auto &buffer: mBuffers) {
+        if (!buffer->ThreadName.empty()) {
+            events.push_back({
+                                     {"name", "thread_name"},
+                                     {"ph",   "M"},
+                                     {"pid",  pid},
+                                     {"tid",  buffer->Tid},
+                                     {"args", {{"name", buffer->ThreadName}}}
+                             });
+        }
+
+        uint64_t count = buffer->Count.load(std::memory_order_acquire);
+        uint64_t first = count > kSpansPerThread ? count - kSpansPerThread : 0;
+        dropped += first;
+
+        for (uint64_t i = first; i < count; i++) {
+            const auto &span = buffer->Spans[i % kSpansPerThread];
+
+            events.push_back({
+                                     {"name", span.Name},
+                                     {"cat",  "memcapture"},
+                                     {"ph",   "X"},
+                                     {"ts",   span.StartUs},
+                                     {"dur",  span.DurationUs},
+                                     {"pid",  pid},
+                                     {"tid",  buffer->Tid}
+                             });
+        }
+    }
+
+    if (dropped > 0) {
+        LOG_WARN("Trace ring buffers overflowed - oldest %" PRIu64 " spans were dropped", dropped);
+    }
+
+    std::ofstream output(path, std::ios::trunc | std::ios::binary);
+    if (!output) {
+        LOG_ERROR("Failed to open %s to write trace", path.string().c_str());
+        return false;
+    }
+
+    output << trace.dump();
+
+    LOG_INFO("Saved collector trace to %s", path.string().c_str());
+    return true;
+}
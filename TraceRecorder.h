@@ -0,0 +1,88 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * @brief Records collector spans and writes them out as Chrome trace-event JSON
+ *
+ * Each thread writes to its own fixed size ring buffer, so recording a span never takes a lock or allocates (apart
+ * from the first span on a new thread). If a thread records more spans than fit, the oldest are overwritten. The
+ * buffers are only read when the trace is written, which must happen after all collection has stopped.
+ *
+ * Timestamps are CLOCK_MONOTONIC (steady_clock) in microseconds so the trace can be lined up with a system trace in
+ * Perfetto
+ */
+class TraceRecorder
+{
+public:
+    TraceRecorder();
+
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder &) = delete;
+
+    TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+    void AddSpan(const std::string &name, std::chrono::steady_clock::time_point start,
+                 std::chrono::steady_clock::time_point end);
+
+    bool Write(const std::filesystem::path &path) const;
+
+private:
+    struct Span
+    {
+        // Fixed size so recording doesn't allocate, source names are all much shorter than this
+        char Name[48];
+        int64_t StartUs;
+        int64_t DurationUs;
+    };
+
+    static constexpr size_t kSpansPerThread = 8192;
+
+    struct ThreadBuffer
+    {
+        pid_t Tid;
+        std::string ThreadName;
+
+        std::array<Span, kSpansPerThread> Spans;
+
+        // Only written by the owning thread
+        std::atomic<uint64_t> Count{0};
+    };
+
+    ThreadBuffer *threadBuffer();
+
+private:
+    // Identifies this recorder so thread local buffer pointers from a previous recorder are never reused
+    const uint64_t mId;
+
+    mutable std::mutex mLock;
+    std::vector<std::unique_ptr<ThreadBuffer>> mBuffers;
+};
@@ -0,0 +1,197 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "TrendEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+TrendEstimator::TrendEstimator()
+        : mStart(),
+          mLastTime(0),
+          mCount(0),
+          mMeanTime(0),
+          mMeanValue(0),
+          mTimeM2(0),
+          mCoMoment(0),
+          mReservoir(),
+          mReservoirCount(0),
+          mStride(1),
+          mSkipped(0)
+{
+}
+
+void TrendEstimator::AddDataPoint(std::chrono::steady_clock::time_point time, long double valueKb)
+{
+    if (mCount == 0) {
+        mStart = time;
+    }
+
+    double hours = std::chrono::duration<double, std::ratio<3600>>(time - mStart).count();
+    auto value = static_cast<double>(valueKb);
+    mLastTime = hours;
+
+    // Welford-style update of the means, time variance and time/value covariance
+    mCount++;
+    double timeDelta = hours - mMeanTime;
+    mMeanTime += timeDelta / (double) mCount;
+    mMeanValue += (value - mMeanValue) / (double) mCount;
+    mTimeM2 += timeDelta * (hours - mMeanTime);
+    mCoMoment += timeDelta * (value - mMeanValue);
+
+    if (mSkipped != 0) {
+        mSkipped = (mSkipped + 1) % mStride;
+        return;
+    }
+
+    if (mReservoirCount == kReservoirSize) {
+        // Halve the resolution so the reservoir keeps covering the whole capture
+        for (size_t i = 0; i < kReservoirSize / 2; i++) {
+            mReservoir[i] = mReservoir[i * 2];
+        }
+        mReservoirCount = kReservoirSize / 2;
+        mStride *= 2;
+    }
+
+    mReservoir[mReservoirCount++] = {hours, value};
+    mSkipped = 1 % mStride;
+}
+
+/**
+ * Median of the slopes between every pair of points
+ */
+double TrendEstimator::theilSen(const point *points, size_t count)
+{
+    std::vector<double> slopes;
+    slopes.reserve(count * (count - 1) / 2);
+
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = i + 1; j < count; j++) {
+            double timeDelta = points[j].Hours - points[i].Hours;
+            if (timeDelta > 0) {
+                slopes.emplace_back((points[j].ValueKb - points[i].ValueKb) / timeDelta);
+            }
+        }
+    }
+
+    if (slopes.empty()) {
+        return 0;
+    }
+
+    auto middle = slopes.begin() + (long) slopes.size() / 2;
+    std::nth_element(slopes.begin(), middle, slopes.end());
+    return *middle;
+}
+
+/**
+ * Mann-Kendall trend test, with the variance corrected for tied values since memory usage often doesn't change between
+ * samples
+ *
+ * @return Z score, positive if the values are increasing
+ */
+double TrendEstimator::mannKendall(const point *points, size_t count)
+{
+    long long s = 0;
+    for (size_t i = 0; i < count; i++) {
+        for (size_t j = i + 1; j < count; j++) {
+            if (points[j].ValueKb > points[i].ValueKb) {
+                s++;
+            } else if (points[j].ValueKb < points[i].ValueKb) {
+                s--;
+            }
+        }
+    }
+
+    auto n = (double) count;
+    double variance = n * (n - 1) * (2 * n + 5);
+
+    std::vector<double> values;
+    values.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        values.emplace_back(points[i].ValueKb);
+    }
+    std::sort(values.begin(), values.end());
+
+    for (size_t i = 0; i < values.size();) {
+        size_t j = i;
+        while (j < values.size() && values[j] == values[i]) {
+            j++;
+        }
+
+        auto ties = (double) (j - i);
+        variance -= ties * (ties - 1) * (2 * ties + 5);
+        i = j;
+    }
+    variance /= 18;
+
+    if (variance <= 0 || s == 0) {
+        return 0;
+    }
+
+    // Continuity correction
+    return ((double) s - (s > 0 ? 1 : -1)) / std::sqrt(variance);
+}
+
+TrendEstimator::Trend TrendEstimator::Get() const
+{
+    Trend trend;
+    trend.Samples = mCount;
+    trend.DurationHours = mLastTime;
+
+    if (mCount >= 2 && mTimeM2 > 0) {
+        trend.LeastSquaresKbPerHour = mCoMoment / mTimeM2;
+    }
+
+    if (mReservoirCount < kMinimumPoints) {
+        return trend;
+    }
+
+    auto half = mReservoirCount / 2;
+    trend.KbPerHour = theilSen(mReservoir.data(), mReservoirCount);
+    trend.RecentKbPerHour = theilSen(mReservoir.data() + half, mReservoirCount - half);
+    trend.ZScore = mannKendall(mReservoir.data(), mReservoirCount);
+
+    trend.Significant = trend.DurationHours >= kMinimumDurationHours &&
+                        trend.ZScore >= kMinimumZScore &&
+                        trend.KbPerHour * trend.DurationHours >= kMinimumGrowthKb &&
+                        trend.RecentKbPerHour > 0;
+
+    return trend;
+}
+
+nlohmann::json TrendEstimator::ToJson() const
+{
+    auto trend = Get();
+
+    auto round = [](double value)
+    {
+        return std::round(value * 10) / 10;
+    };
+
+    return {
+            {"kbPerHour",             round(trend.KbPerHour)},
+            {"recentKbPerHour",       round(trend.RecentKbPerHour)},
+            {"leastSquaresKbPerHour", round(trend.LeastSquaresKbPerHour)},
+            {"zScore",                std::round(trend.ZScore * 100) / 100},
+            {"samples",               trend.Samples},
+            {"durationHours",         std::round(trend.DurationHours * 1000) / 1000},
+            {"significant",           trend.Significant}
+    };
+}
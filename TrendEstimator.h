@@ -0,0 +1,106 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief Online estimate of how fast a value (e.g. a process's PSS) is growing, using a fixed amount of memory
+ *
+ * Two estimates are kept:
+ *  - A least-squares slope over every data point, updated incrementally
+ *  - A Theil-Sen slope (median of the slopes between pairs of points) over a reservoir of up to kReservoirSize points
+ *    spread evenly across the capture. When the reservoir fills, every other point is dropped and only every other
+ *    data point is kept from then on, so it always covers the whole capture however long it runs
+ *
+ * Growth is significant if a Mann-Kendall test on the reservoir says the values are trending upwards, the Theil-Sen
+ * slope adds up to at least kMinimumGrowthKb over the capture, and the later half of the reservoir is still growing.
+ * The last condition stops a one-off increase, such as a cache filling at startup, from looking like a leak.
+ * Consecutive samples aren't independent, so treat this as a strong hint rather than proof
+ */
+class TrendEstimator
+{
+public:
+    struct Trend
+    {
+        // Theil-Sen slope over the whole capture and over the later half of the reservoir
+        double KbPerHour = 0;
+        double RecentKbPerHour = 0;
+
+        double LeastSquaresKbPerHour = 0;
+
+        // Mann-Kendall test statistic, positive for an upwards trend
+        double ZScore = 0;
+
+        uint64_t Samples = 0;
+        double DurationHours = 0;
+
+        bool Significant = false;
+    };
+
+    static constexpr size_t kReservoirSize = 128;
+
+    // Thresholds for growth to count as significant
+    static constexpr size_t kMinimumPoints = 16;
+    static constexpr double kMinimumDurationHours = 0.25;
+    static constexpr double kMinimumZScore = 3.0;
+    static constexpr double kMinimumGrowthKb = 256;
+
+    TrendEstimator();
+
+    void AddDataPoint(std::chrono::steady_clock::time_point time, long double valueKb);
+
+    Trend Get() const;
+
+    nlohmann::json ToJson() const;
+
+private:
+    struct point
+    {
+        double Hours;
+        double ValueKb;
+    };
+
+    static double theilSen(const point *points, size_t count);
+
+    static double mannKendall(const point *points, size_t count);
+
+private:
+    std::chrono::steady_clock::time_point mStart;
+    double mLastTime;
+
+    // Running means and co-moments for the least-squares slope, time in hours
+    uint64_t mCount;
+    double mMeanTime;
+    double mMeanValue;
+    double mTimeM2;
+    double mCoMoment;
+
+    std::array<point, kReservoirSize> mReservoir;
+    size_t mReservoirCount;
+
+    // Only every mStride'th data point goes in the reservoir
+    uint64_t mStride;
+    uint64_t mSkipped;
+};
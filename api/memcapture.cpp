@@ -0,0 +1,267 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "memcapture.h"
+
+#include "Log.h"
+#include "JsonReportGenerator.h"
+#include "Metadata.h"
+#include "GpuMemorySnapshot.h"
+#include "ProcessMetric.h"
+#include "MemoryMetric.h"
+#include "Platforms/PlatformRegistry.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+static constexpr std::chrono::milliseconds kDefaultInterval(3000);
+
+struct memcapture_session
+{
+    memcapture_session(std::shared_ptr<IPlatform> platform, std::optional<std::shared_ptr<GroupManager>> groupManager,
+                       std::chrono::milliseconds interval)
+            : interval(interval),
+              metadata(std::make_shared<Metadata>()),
+              reportGenerator(std::make_shared<JsonReportGenerator>(metadata, std::move(groupManager))),
+              gpuSnapshot(std::make_shared<GpuMemorySnapshot>()),
+              processMetric(reportGenerator, gpuSnapshot),
+              memoryMetric(std::move(platform), reportGenerator, gpuSnapshot),
+              capturing(false)
+    {
+    }
+
+    const std::chrono::milliseconds interval;
+
+    const std::shared_ptr<Metadata> metadata;
+    const std::shared_ptr<JsonReportGenerator> reportGenerator;
+    const std::shared_ptr<GpuMemorySnapshot> gpuSnapshot;
+
+    ProcessMetric processMetric;
+    MemoryMetric memoryMetric;
+
+    // Held whilst starting/stopping collection and whilst writing into the report generator
+    std::mutex lock;
+    bool capturing;
+    std::chrono::steady_clock::time_point start;
+};
+
+int memcapture_api_version(void)
+{
+    return MEMCAPTURE_API_VERSION;
+}
+
+memcapture_session_t *memcapture_session_create(const memcapture_config_t *config)
+{
+    try {
+        auto interval = kDefaultInterval;
+        if (config && config->interval_ms > 0) {
+            interval = std::chrono::milliseconds(config->interval_ms);
+        }
+
+        std::shared_ptr<IPlatform> platform = (config && config->platform) ? PlatformRegistry::Create(config->platform)
+                                                                           : PlatformRegistry::Detect();
+        if (!platform) {
+            LOG_ERROR("Unsupported platform %s", config->platform);
+            return nullptr;
+        }
+
+        std::optional<std::shared_ptr<GroupManager>> groupManager = std::nullopt;
+        if (config && config->groups_file) {
+            std::ifstream groupsFile(config->groups_file);
+            if (!groupsFile) {
+                LOG_ERROR("Invalid groups file %s", config->groups_file);
+                return nullptr;
+            }
+            groupManager = std::make_shared<GroupManager>(nlohmann::json::parse(groupsFile));
+        }
+
+        auto session = new memcapture_session(platform, groupManager, interval);
+
+        if (config && config->rolling_windows) {
+            session->processMetric.EnableRollingWindows();
+            session->memoryMetric.EnableRollingWindows();
+        }
+
+        return session;
+    } catch (std::exception &e) {
+        LOG_ERROR("Failed to create session with error %s", e.what());
+        return nullptr;
+    }
+}
+
+void memcapture_session_destroy(memcapture_session_t *session)
+{
+    if (!session) {
+        return;
+    }
+
+    memcapture_session_stop(session);
+    delete session;
+}
+
+int memcapture_session_start(memcapture_session_t *session)
+{
+    if (!session) {
+        return -EINVAL;
+    }
+
+    std::lock_guard<std::mutex> locker(session->lock);
+    if (session->capturing) {
+        return 0;
+    }
+
+    session->processMetric.StartCollection(session->interval);
+    session->memoryMetric.StartCollection(session->interval);
+    session->start = std::chrono::steady_clock::now();
+    session->capturing = true;
+
+    return 0;
+}
+
+int memcapture_session_stop(memcapture_session_t *session)
+{
+    if (!session) {
+        return -EINVAL;
+    }
+
+    std::lock_guard<std::mutex> locker(session->lock);
+    if (!session->capturing) {
+        return 0;
+    }
+
+    session->processMetric.StopCollection();
+    session->memoryMetric.StopCollection();
+    session->capturing = false;
+
+    return 0;
+}
+
+int memcapture_session_system(memcapture_session_t *session, memcapture_system_t *system)
+{
+    if (!session || !system) {
+        return -EINVAL;
+    }
+
+    try {
+        auto memory = session->memoryMetric.GetLinuxMemory();
+        if (memory.at("Total").GetCount() == 0) {
+            return -EAGAIN;
+        }
+
+        system->total_kb = (uint64_t) memory.at("Total").GetLast();
+        system->used_kb = (uint64_t) memory.at("Used").GetLast();
+        system->free_kb = (uint64_t) memory.at("Free").GetLast();
+        system->available_kb = (uint64_t) memory.at("Available").GetLast();
+        system->cached_kb = (uint64_t) memory.at("Cached").GetLast();
+        system->buffered_kb = (uint64_t) memory.at("Buffered").GetLast();
+        system->slab_kb = (uint64_t) memory.at("Slab Total").GetLast();
+        system->swap_used_kb = (uint64_t) memory.at("Swap Used").GetLast();
+
+        return 0;
+    } catch (std::exception &e) {
+        LOG_ERROR("Failed to get system memory with error %s", e.what());
+        return -EIO;
+    }
+}
+
+ssize_t memcapture_session_processes(memcapture_session_t *session, memcapture_process_t *processes, size_t max)
+{
+    if (!session || (!processes && max > 0)) {
+        return -EINVAL;
+    }
+
+    try {
+        auto top = session->processMetric.GetTopProcesses(std::numeric_limits<size_t>::max());
+
+        for (size_t i = 0; i < top.size() && i < max; i++) {
+            const auto &process = top.at(i);
+            auto &out = processes[i];
+
+            out.pid = process["pid"].get<pid_t>();
+            snprintf(out.name, sizeof(out.name), "%s", process["name"].get<std::string>().c_str());
+            out.pss_kb = process["pssKb"].get<uint64_t>();
+            out.rss_kb = process["rssKb"].get<uint64_t>();
+            out.uss_kb = process["ussKb"].get<uint64_t>();
+            out.swap_kb = process["swapKb"].get<uint64_t>();
+            out.pss_average_kb = process["pssAverageKb"].get<uint64_t>();
+        }
+
+        return (ssize_t) top.size();
+    } catch (std::exception &e) {
+        LOG_ERROR("Failed to get processes with error %s", e.what());
+        return -EIO;
+    }
+}
+
+int memcapture_session_system_aggregate(memcapture_session_t *session, const char *name,
+                                        memcapture_aggregate_t *aggregate)
+{
+    if (!session || !name || !aggregate) {
+        return -EINVAL;
+    }
+
+    auto memory = session->memoryMetric.GetLinuxMemory();
+    auto itr = memory.find(name);
+    if (itr == memory.end()) {
+        return -ENOENT;
+    }
+
+    const auto &measurement = itr->second;
+    aggregate->samples = measurement.GetCount();
+    aggregate->min = aggregate->samples > 0 ? (double) measurement.GetMin() : 0;
+    aggregate->max = aggregate->samples > 0 ? (double) measurement.GetMax() : 0;
+    aggregate->average = aggregate->samples > 0 ? (double) measurement.GetAverage() : 0;
+
+    return 0;
+}
+
+char *memcapture_session_report_json(memcapture_session_t *session)
+{
+    if (!session) {
+        return nullptr;
+    }
+
+    try {
+        std::lock_guard<std::mutex> locker(session->lock);
+
+        if (session->capturing) {
+            session->metadata->SetDuration(std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::steady_clock::now() - session->start).count());
+        }
+
+        session->reportGenerator->reset();
+        session->processMetric.SaveResults();
+        session->memoryMetric.SaveResults();
+
+        return strdup(session->reportGenerator->getJson().dump().c_str());
+    } catch (std::exception &e) {
+        LOG_ERROR("Failed to generate report with error %s", e.what());
+        return nullptr;
+    }
+}
+
+void memcapture_free(void *ptr)
+{
+    free(ptr);
+}
@@ -0,0 +1,149 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef MEMCAPTURE_API_H
+#define MEMCAPTURE_API_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined(__GNUC__)
+#define MEMCAPTURE_EXPORT __attribute__((visibility("default")))
+#else
+#define MEMCAPTURE_EXPORT
+#endif
+
+/*
+ * C API for embedding the MemCapture collectors in another process.
+ *
+ * A session runs the process and system memory collectors on their own threads at the given interval. The caller can
+ * poll the latest snapshot at any time without disturbing collection, read min/max/average aggregates for the session
+ * so far, or get the full report JSON (the same as MemCapture --json writes).
+ *
+ * Functions returning int return 0 on success or a negative errno value on failure. A session may be used from
+ * multiple threads, but must not be destroyed whilst another thread is using it.
+ *
+ * Structs are only ever extended by adding fields to the end, and MEMCAPTURE_API_VERSION is bumped when that happens
+ */
+#define MEMCAPTURE_API_VERSION 1
+
+#define MEMCAPTURE_NAME_MAX 64
+
+typedef struct memcapture_session memcapture_session_t;
+
+typedef struct
+{
+    /* How often to collect, 0 for the default of 3000ms */
+    unsigned int interval_ms;
+
+    /* Platform name as accepted by MemCapture --platform, NULL to detect */
+    const char *platform;
+
+    /* Path to a groups JSON file, NULL for no grouping */
+    const char *groups_file;
+
+    /* Non-zero to keep memory usage flat for sessions that run indefinitely (see MemCapture --daemon) */
+    int rolling_windows;
+} memcapture_config_t;
+
+typedef struct
+{
+    uint64_t total_kb;
+    uint64_t used_kb;
+    uint64_t free_kb;
+    uint64_t available_kb;
+    uint64_t cached_kb;
+    uint64_t buffered_kb;
+    uint64_t slab_kb;
+    uint64_t swap_used_kb;
+} memcapture_system_t;
+
+typedef struct
+{
+    pid_t pid;
+    char name[MEMCAPTURE_NAME_MAX];
+    uint64_t pss_kb;
+    uint64_t rss_kb;
+    uint64_t uss_kb;
+    uint64_t swap_kb;
+    uint64_t pss_average_kb;
+} memcapture_process_t;
+
+typedef struct
+{
+    double min;
+    double max;
+    double average;
+    uint64_t samples;
+} memcapture_aggregate_t;
+
+/* @return MEMCAPTURE_API_VERSION of the library, which may be newer than the header the caller was built with */
+MEMCAPTURE_EXPORT int memcapture_api_version(void);
+
+/* @param config Can be NULL for the defaults. @return NULL on failure */
+MEMCAPTURE_EXPORT memcapture_session_t *memcapture_session_create(const memcapture_config_t *config);
+
+/* Stops collection if it's running and frees the session */
+MEMCAPTURE_EXPORT void memcapture_session_destroy(memcapture_session_t *session);
+
+MEMCAPTURE_EXPORT int memcapture_session_start(memcapture_session_t *session);
+
+MEMCAPTURE_EXPORT int memcapture_session_stop(memcapture_session_t *session);
+
+/* Latest /proc/meminfo sample. @return -EAGAIN if nothing has been collected yet */
+MEMCAPTURE_EXPORT int memcapture_session_system(memcapture_session_t *session, memcapture_system_t *system);
+
+/*
+ * Latest sample of the processes currently alive, highest PSS first
+ *
+ * @param processes Array of at least max entries, can be NULL if max is 0
+ * @return Number of processes alive (which may be larger than max) or a negative errno value
+ */
+MEMCAPTURE_EXPORT ssize_t memcapture_session_processes(memcapture_session_t *session, memcapture_process_t *processes,
+                                                       size_t max);
+
+/*
+ * Aggregate of a /proc/meminfo value over the session, in KB
+ *
+ * @param name As shown in the "Linux Memory" table of the report, e.g. "Used" or "Swap Used"
+ * @return -ENOENT if there's no such value
+ */
+MEMCAPTURE_EXPORT int memcapture_session_system_aggregate(memcapture_session_t *session, const char *name,
+                                                          memcapture_aggregate_t *aggregate);
+
+/*
+ * Full report of the session so far as JSON. Can be called whilst collection is running
+ *
+ * @return Must be freed with memcapture_free(), NULL on failure
+ */
+MEMCAPTURE_EXPORT char *memcapture_session_report_json(memcapture_session_t *session);
+
+MEMCAPTURE_EXPORT void memcapture_free(void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //MEMCAPTURE_API_H
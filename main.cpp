@@ -23,14 +23,24 @@
 #include <fstream>
 #include <optional>
 #include <filesystem>
+#include <algorithm>
+#include <atomic>
 
-#include "Platform.h"
+#include "Platforms/PlatformRegistry.h"
 #include "Log.h"
 #include "ProcessMetric.h"
 #include "MemoryMetric.h"
+#include "PsiMetric.h"
+#include "PsiTrigger.h"
+#include "KernelThreadMetric.h"
+#include "DmaBufMetric.h"
+#include "CounterMetric.h"
 #include "Metadata.h"
 #include "GroupManager.h"
 #include "ConditionVariable.h"
+#include "ControlServer.h"
+#include "MetricsHttpServer.h"
+#include "ReportFormat.h"
 
 #ifdef ENABLE_CPU_IDLE_METRICS
 #include "CpuIdleMetric.h"
@@ -52,32 +62,108 @@
 INCBIN(templateHtml, "./templates/template.html");
 
 static int gDuration = 30;
-static Platform gPlatform = Platform::AMLOGIC;
+
+// Detected automatically if not specified
+static std::string gPlatformName;
 
 // Default to save in current directory if not specified
 static std::filesystem::path gOutputDirectory = std::filesystem::current_path() / "MemCaptureReport";
 
 static bool gJson = false;
+static ReportFormat gReportFormat = ReportFormat::Json;
+
+// Re-render the HTML report from a previously saved data report instead of capturing
+static std::filesystem::path gRenderFile;
 static bool gCpuIdle = false;
 
+// PSI is cheap to read so can be sampled more often than everything else. Can be lowered to 100ms to catch short
+// stalls, at the cost of a larger time series. 0 disables
+static std::chrono::milliseconds gPsiInterval = std::chrono::seconds(1);
+
+// When enabled, temporarily collect data more frequently when the kernel reports memory pressure (>150ms stalled in
+// any 1s window)
+static bool gPsiTrigger = false;
+static const std::chrono::microseconds gPsiTriggerThreshold = std::chrono::milliseconds(150);
+static const std::chrono::microseconds gPsiTriggerWindow = std::chrono::seconds(1);
+static const std::chrono::milliseconds gBurstInterval = std::chrono::milliseconds(500);
+
+// Warn when the system is forecast to run out of memory within this long. 0 disables
+static std::chrono::seconds gOomWarningHorizon = std::chrono::minutes(10);
+
+// When enabled, collect data more frequently and save a report when an OOM warning is raised
+static bool gOomSnapshot = false;
+static const std::chrono::seconds gOomSnapshotDelay = std::chrono::seconds(5);
+std::atomic<bool> gOomSnapshotRequested(false);
+
+static bool gKernelThreads = false;
+
 bool gEnableGroups = false;
 static std::filesystem::path gGroupsFile;
 
+static std::filesystem::path gCountersFile;
+
+static std::filesystem::path gTraceFile;
+
+static std::filesystem::path gTimelineFile;
+
+// Run until stopped, saving a report on SIGUSR1 or every gSnapshotInterval (0 = only on SIGUSR1)
+static bool gDaemon = false;
+static std::chrono::seconds gSnapshotInterval(0);
+static constexpr int kReportsToKeep = 5;
+std::atomic<bool> gSnapshotRequested(false);
+
+static std::filesystem::path gControlSocket;
+
+// Serve live gauges for Prometheus on localhost. 0 disables
+static uint16_t gMetricsPort = 0;
+
+// Write each sample as newline-delimited JSON as it's taken, "-" for stdout
+static std::filesystem::path gStreamFile;
+
+// Default collection interval for the process, memory, kernel thread and DMA-BUF metrics. Can be changed at runtime
+// through the control socket
+static std::chrono::milliseconds gCollectionInterval = std::chrono::seconds(3);
+static constexpr std::chrono::milliseconds kMinimumCollectionInterval(250);
+
+// New collection interval requested through the control socket, applied by the main thread. 0 if none is pending
+std::atomic<long long> gRequestedIntervalMs(0);
+
 ConditionVariable gStop;
 std::mutex gLock;
 bool gEarlyTermination = false;
 
 static void displayUsage()
 {
+    std::string supportedPlatforms;
+    for (const auto &name: PlatformRegistry::Names()) {
+        supportedPlatforms += (supportedPlatforms.empty() ? "'" : ", '") + name + "'";
+    }
+
     printf("Usage: MemCapture <option(s)>\n");
     printf("    Utility to capture memory statistics\n\n");
     printf("    -h, --help          Print this help and exit\n");
     printf("    -o, --output-dir    Directory to save results in\n");
     printf("    -j, --json          Save data as JSON in addition to HTML report\n");
+    printf("    -f, --format        Format of the data report: json, json-compact, cbor or msgpack. Default json, implies --json\n");
+    printf("    -R, --render        Render the HTML report from a saved data report (any format) into the output directory and exit\n");
     printf("    -d, --duration      Amount of time (in seconds) to capture data for. Default 30 seconds\n");
-    printf("    -p, --platform      Platform we're running on. Supported options = ['AMLOGIC', 'AMLOGIC_950D4', 'REALTEK', 'REALTEK64', 'BROADCOM']. Defaults to Amlogic\n");
+    printf("    -p, --platform      Platform we're running on. Supported options = [%s]. Detected automatically if not set\n",
+           supportedPlatforms.c_str());
     printf("    -g, --groups        Path to JSON file containing the group mappings (optional)\n");
     printf("    -c, --cpuidle       Enable CPU Idle metrics (default to false, requires kernel support)\n");
+    printf("    -i, --psi-interval  How often (in milliseconds) to sample memory pressure (PSI). Default 1000ms, 0 to disable\n");
+    printf("    -t, --psi-trigger   Capture data more frequently when under memory pressure (requires kernel PSI support)\n");
+    printf("    -w, --oom-warning   Warn when the system is forecast to run out of memory within N seconds. Default 600, 0 to disable\n");
+    printf("    -O, --oom-snapshot  Capture data more frequently and save a report when an OOM warning is raised\n");
+    printf("    -k, --kthreads      Capture CPU usage of kernel threads (kswapd, kcompactd etc)\n");
+    printf("    -x, --counters      Path to JSON file describing extra sysfs/procfs counters to capture (optional)\n");
+    printf("    -r, --trace-out     Write a Chrome/Perfetto trace of MemCapture's own collection activity to this file (optional)\n");
+    printf("    -l, --timeline-out  Stream every collected memory counter to this file as a Chrome/Perfetto trace (optional)\n");
+    printf("    -D, --daemon        Run until stopped, keeping rolling 1 min/15 min/1 hour windows. Send SIGUSR1 to save a report\n");
+    printf("    -s, --snapshot-interval  In daemon mode, also save a report every N seconds. Default 0 (only on SIGUSR1)\n");
+    printf("    -u, --control-socket     Path to create a Unix socket that accepts commands to control the capture (optional)\n");
+    printf("    -m, --metrics-port  Serve live metrics for Prometheus at http://127.0.0.1:<port>/metrics (optional)\n");
+    printf("    -n, --stream-out    Write each sample as newline-delimited JSON to this file, or - for stdout (optional)\n");
 }
 
 static void parseArgs(const int argc, char **argv)
@@ -88,8 +174,23 @@ static void parseArgs(const int argc, char **argv)
             {"platform",   required_argument, nullptr, (int) 'p'},
             {"output-dir", required_argument, nullptr, (int) 'o'},
             {"json",       no_argument,       nullptr, (int) 'j'},
+            {"format",     required_argument, nullptr, (int) 'f'},
+            {"render",     required_argument, nullptr, (int) 'R'},
             {"groups",     required_argument, nullptr, (int) 'g'},
             {"cpuidle",     no_argument, nullptr, (int) 'c'},
+            {"psi-interval", required_argument, nullptr, (int) 'i'},
+            {"psi-trigger", no_argument, nullptr, (int) 't'},
+            {"oom-warning", required_argument, nullptr, (int) 'w'},
+            {"oom-snapshot", no_argument, nullptr, (int) 'O'},
+            {"kthreads", no_argument, nullptr, (int) 'k'},
+            {"counters", required_argument, nullptr, (int) 'x'},
+            {"trace-out", required_argument, nullptr, (int) 'r'},
+            {"timeline-out", required_argument, nullptr, (int) 'l'},
+            {"daemon", no_argument, nullptr, (int) 'D'},
+            {"snapshot-interval", required_argument, nullptr, (int) 's'},
+            {"control-socket", required_argument, nullptr, (int) 'u'},
+            {"metrics-port", required_argument, nullptr, (int) 'm'},
+            {"stream-out", required_argument, nullptr, (int) 'n'},
             {nullptr, 0,                      nullptr, 0}
     };
 
@@ -98,7 +199,7 @@ static void parseArgs(const int argc, char **argv)
     int option;
     int longindex;
 
-    while ((option = getopt_long(argc, argv, "hd:p:o:jg:c", longopts, &longindex)) != -1) {
+    while ((option = getopt_long(argc, argv, "hd:p:o:jf:R:g:ci:tw:Okx:r:l:Ds:u:m:n:", longopts, &longindex)) != -1) {
         switch (option) {
             case 'h':
                 displayUsage();
@@ -114,20 +215,12 @@ static void parseArgs(const int argc, char **argv)
             case 'p': {
                 std::string platform(optarg);
 
-                if (platform == "AMLOGIC") {
-                    gPlatform = Platform::AMLOGIC;
-                } else if (platform == "AMLOGIC_950D4") {
-                    gPlatform = Platform::AMLOGIC_950D4;
-                } else if (platform == "REALTEK") {
-                    gPlatform = Platform::REALTEK;
-                } else if (platform == "REALTEK64") {
-                    gPlatform = Platform::REALTEK64;
-                } else if (platform == "BROADCOM") {
-                    gPlatform = Platform::BROADCOM;
-                } else {
+                auto names = PlatformRegistry::Names();
+                if (std::find(names.begin(), names.end(), platform) == names.end()) {
                     fprintf(stderr, "Warning: Unsupported platform %s\n", platform.c_str());
                     exit(EXIT_FAILURE);
                 }
+                gPlatformName = platform;
                 break;
             }
             case 'o': {
@@ -138,6 +231,20 @@ static void parseArgs(const int argc, char **argv)
                 gJson = true;
                 break;
             }
+            case 'f': {
+                auto format = ParseReportFormat(optarg);
+                if (!format.has_value()) {
+                    fprintf(stderr, "Error: Unsupported report format %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                gReportFormat = format.value();
+                gJson = true;
+                break;
+            }
+            case 'R': {
+                gRenderFile = std::filesystem::path(optarg);
+                break;
+            }
             case 'g': {
                 gEnableGroups = true;
                 gGroupsFile = std::filesystem::path(optarg);
@@ -147,6 +254,78 @@ static void parseArgs(const int argc, char **argv)
                 gCpuIdle = true;
                 break;
             }
+            case 'i': {
+                int interval = std::atoi(optarg);
+                if (interval < 0) {
+                    fprintf(stderr, "Error: PSI interval (ms) must be >= 0\n");
+                    exit(EXIT_FAILURE);
+                }
+                gPsiInterval = std::chrono::milliseconds(interval);
+                break;
+            }
+            case 't': {
+                gPsiTrigger = true;
+                break;
+            }
+            case 'w': {
+                int horizon = std::atoi(optarg);
+                if (horizon < 0) {
+                    fprintf(stderr, "Error: OOM warning horizon (s) must be >= 0\n");
+                    exit(EXIT_FAILURE);
+                }
+                gOomWarningHorizon = std::chrono::seconds(horizon);
+                break;
+            }
+            case 'O': {
+                gOomSnapshot = true;
+                break;
+            }
+            case 'k': {
+                gKernelThreads = true;
+                break;
+            }
+            case 'x': {
+                gCountersFile = std::filesystem::path(optarg);
+                break;
+            }
+            case 'r': {
+                gTraceFile = std::filesystem::path(optarg);
+                break;
+            }
+            case 'l': {
+                gTimelineFile = std::filesystem::path(optarg);
+                break;
+            }
+            case 'D': {
+                gDaemon = true;
+                break;
+            }
+            case 's': {
+                int interval = std::atoi(optarg);
+                if (interval < 0) {
+                    fprintf(stderr, "Error: snapshot interval (s) must be >= 0\n");
+                    exit(EXIT_FAILURE);
+                }
+                gSnapshotInterval = std::chrono::seconds(interval);
+                break;
+            }
+            case 'u': {
+                gControlSocket = std::filesystem::path(optarg);
+                break;
+            }
+            case 'm': {
+                int port = std::atoi(optarg);
+                if (port <= 0 || port > 65535) {
+                    fprintf(stderr, "Error: metrics port must be between 1 and 65535\n");
+                    exit(EXIT_FAILURE);
+                }
+                gMetricsPort = static_cast<uint16_t>(port);
+                break;
+            }
+            case 'n': {
+                gStreamFile = std::filesystem::path(optarg);
+                break;
+            }
             case '?':
                 if (optopt == 'c')
                     fprintf(stderr, "Warning: Option -%c requires an argument.\n", optopt);
@@ -173,11 +352,131 @@ void signalHandler(int signal)
     LOG_INFO("Waiting for in-progress data collection to complete");
 }
 
+void snapshotSignalHandler(int)
+{
+    gSnapshotRequested = true;
+    gStop.notify_all();
+}
+
+/**
+ * Shift the previous reports along (report.html -> report.1.html etc), dropping the oldest, so a daemon doesn't
+ * fill up the disk
+ */
+static void rotateReports()
+{
+    for (const std::string &extension: {std::string(".html"), ReportExtension(gReportFormat)}) {
+        for (int i = kReportsToKeep - 1; i > 0; i--) {
+            auto from = gOutputDirectory / ("report" + (i > 1 ? "." + std::to_string(i - 1) : "") + extension);
+            auto to = gOutputDirectory / ("report." + std::to_string(i) + extension);
+
+            std::error_code ec;
+            if (std::filesystem::exists(from, ec)) {
+                std::filesystem::rename(from, to, ec);
+                if (ec) {
+                    LOG_WARN("Failed to rotate %s: %s", from.string().c_str(), ec.message().c_str());
+                }
+            }
+        }
+    }
+}
+
+static void renderHtml(const nlohmann::json &report, CollectorStats *collectorStats)
+{
+    inja::Environment env;
+    // Make the output a bit tidier
+    env.set_trim_blocks(true);
+    env.set_lstrip_blocks(true);
+
+    // Convert the values in an object into an array that we can loop over (used for generating rows)
+    // Order the values using the _columnOrder data given in the second argument
+    env.add_callback("objectToArray", 2, [](inja::Arguments &args)
+    {
+        std::vector<nlohmann::json> values;
+
+        assert(args.at(0)->is_object());
+        assert(args.at(1)->is_array());
+
+        std::map<std::string, nlohmann::json> flattenedData;
+
+        // Flatten the data (one level deep only)
+        for (const auto &element: args.at(0)->items()) {
+            if (element.value().is_object()) {
+                // This is a very janky way to handle min/max/average & column ordering. The key name corresponds to "<Measurement Name> (Min/Max/Average)"
+                // which matches the _columnOrder values set in JsonReportGenerator
+                for (const auto &child: element.value().items()) {
+                    std::string keyName = element.key() + " (" + child.key() + ")";
+                    flattenedData.emplace(keyName, child.value());
+                }
+            } else {
+                values.emplace_back(element.value());
+                flattenedData.emplace(element.key(), element.value());
+            }
+        }
+
+        // Put the data into the order specified by _columnOrder
+        std::vector<nlohmann::json> ordered;
+        for (const auto &column: args.at(1)->items()) {
+            auto item = flattenedData.at(column.value());
+            ordered.emplace_back(item);
+        }
+
+        return ordered;
+    });
+
+    try {
+        auto htmlTemplateString = std::string(g_templateHtml_data, g_templateHtml_data + g_templateHtml_size);
+
+        std::string result;
+        {
+            CollectorStats::ScopedSample sample(collectorStats, "Report Render");
+            result = env.render(htmlTemplateString, report);
+        }
+
+        std::filesystem::path htmlFilepath = gOutputDirectory / "report.html";
+        std::ofstream outputHtml(htmlFilepath, std::ios::trunc | std::ios::binary);
+        outputHtml << result;
+
+        LOG_INFO("Saved report to %s", htmlFilepath.string().c_str());
+    } catch (const std::exception &e) {
+        LOG_ERROR("Failed to save HTML report with exception %s", e.what());
+        throw;
+    }
+}
+
+static void writeReport(const std::shared_ptr<JsonReportGenerator> &reportGenerator)
+{
+    std::filesystem::path dataFilepath = gOutputDirectory / ("report" + ReportExtension(gReportFormat));
+
+    // Write the data first - this is safer and is the report automation need, so if we crash
+    // after this point we'll still get some data
+    if (gJson && WriteReport(reportGenerator->getJson(), gReportFormat, dataFilepath)) {
+        LOG_INFO("Saved data to %s", dataFilepath.string().c_str());
+    }
+
+    renderHtml(reportGenerator->getJson(), reportGenerator->collectorStats().get());
+
+    // The data was written before the render time was known, so update it now the HTML is safely saved
+    if (gJson) {
+        WriteReport(reportGenerator->getJson(), gReportFormat, dataFilepath);
+    }
+}
+
 
 int main(int argc, char *argv[])
 {
     parseArgs(argc, argv);
 
+    if (!gRenderFile.empty()) {
+        try {
+            std::filesystem::create_directories(gOutputDirectory);
+            renderHtml(ReadReport(gRenderFile), nullptr);
+        } catch (std::exception &e) {
+            LOG_ERROR("Failed to render %s with error %s", gRenderFile.string().c_str(), e.what());
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     // Get start time
     auto start = std::chrono::steady_clock::now();
 
@@ -190,6 +489,9 @@ int main(int argc, char *argv[])
 
     std::signal(SIGTERM, signalHandler);
     std::signal(SIGINT, signalHandler);
+    if (gDaemon) {
+        std::signal(SIGUSR1, snapshotSignalHandler);
+    }
 
     // Lower our priority to avoid getting in the way
     if (nice(10) < 0) {
@@ -204,7 +506,11 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
-    LOG_INFO("** About to start memory capture for %d seconds **", gDuration);
+    if (gDaemon) {
+        LOG_INFO("** About to start memory capture in daemon mode - send SIGUSR1 to save a report **");
+    } else {
+        LOG_INFO("** About to start memory capture for %d seconds **", gDuration);
+    }
     LOG_INFO("Will save report to %s", gOutputDirectory.string().c_str());
 
     // Load groups JSON if provided
@@ -226,20 +532,197 @@ int main(int argc, char *argv[])
         }
     }
 
+    // Load custom counters JSON if provided
+    std::optional<nlohmann::json> countersJson = std::nullopt;
+    if (!gCountersFile.empty()) {
+        LOG_INFO("Loading counters from %s", std::filesystem::absolute(gCountersFile).string().c_str());
+        std::ifstream countersFile(gCountersFile);
+        if (!countersFile) {
+            LOG_ERROR("Invalid counters file %s", gCountersFile.string().c_str());
+            return EXIT_FAILURE;
+        } else {
+            try {
+                countersJson = nlohmann::json::parse(countersFile);
+            } catch (nlohmann::json::exception &e) {
+                LOG_ERROR("Failed to parse counters JSON with error %s", e.what());
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
     auto metadata = std::make_shared<Metadata>();
     auto reportGenerator = std::make_shared<JsonReportGenerator>(metadata, groupManager);
 
+    std::shared_ptr<TraceRecorder> traceRecorder;
+    if (!gTraceFile.empty()) {
+        traceRecorder = std::make_shared<TraceRecorder>();
+        reportGenerator->collectorStats()->SetTraceRecorder(traceRecorder);
+    }
+
+    if (!gTimelineFile.empty()) {
+        auto counterTrace = std::make_shared<CounterTraceWriter>(gTimelineFile);
+        if (!counterTrace->IsOpen()) {
+            return EXIT_FAILURE;
+        }
+        reportGenerator->setCounterTrace(counterTrace);
+    }
+
+    if (!gStreamFile.empty()) {
+        // The reader on the other end of a pipe going away shouldn't kill the capture
+        std::signal(SIGPIPE, SIG_IGN);
+
+        auto streamWriter = std::make_shared<StreamWriter>(gStreamFile);
+        if (!streamWriter->IsOpen()) {
+            return EXIT_FAILURE;
+        }
+        reportGenerator->setStreamWriter(streamWriter);
+    }
+
+    std::unique_ptr<MetricsHttpServer> metricsServer;
+    if (gMetricsPort != 0) {
+        auto metricsExporter = std::make_shared<MetricsExporter>(groupManager);
+        reportGenerator->setMetricsExporter(metricsExporter);
+
+        metricsServer = std::make_unique<MetricsHttpServer>(gMetricsPort, metricsExporter);
+        if (!metricsServer->Start()) {
+            LOG_WARN("Metrics endpoint not available");
+            metricsServer.reset();
+        }
+    }
+
     // Create all our metrics
-    ProcessMetric processMetric(reportGenerator);
-    MemoryMetric memoryMetric(gPlatform, reportGenerator);
+    // GPU and DMA-BUF usage are read by MemoryMetric and DmaBufMetric but also needed for the per-process footprint
+    auto gpuSnapshot = std::make_shared<GpuMemorySnapshot>();
+    auto dmaBufSnapshot = std::make_shared<DmaBufSnapshot>();
+
+    ProcessMetric processMetric(reportGenerator, gpuSnapshot, dmaBufSnapshot);
+    std::shared_ptr<IPlatform> platform = gPlatformName.empty() ? PlatformRegistry::Detect()
+                                                                : PlatformRegistry::Create(gPlatformName);
+    MemoryMetric memoryMetric(platform, reportGenerator, gpuSnapshot);
+    PsiMetric psiMetric(reportGenerator);
+    KernelThreadMetric kernelThreadMetric(reportGenerator);
+    DmaBufMetric dmaBufMetric(reportGenerator, dmaBufSnapshot);
+
+    std::unique_ptr<CounterMetric> counterMetric;
+    if (countersJson.has_value()) {
+        counterMetric = std::make_unique<CounterMetric>(reportGenerator, countersJson.value());
+    }
+
+    bool psiEnabled = gPsiInterval.count() > 0;
+    if (psiEnabled && !PsiMetric::IsSupported()) {
+        LOG_WARN("Kernel does not support PSI - memory pressure will not be captured");
+        psiEnabled = false;
+    }
+
+    bool dmaBufEnabled = DmaBufMetric::IsSupported();
+    if (!dmaBufEnabled) {
+        LOG_WARN("Kernel does not expose DMA-BUF buffers - DMA-BUF exporters and per-process DMA-BUF usage will not be captured");
+    }
 
 #ifdef ENABLE_CPU_IDLE_METRICS
     CpuIdleMetric cpuIdleMetric(reportGenerator);
 #endif
 
+    if (gDaemon) {
+        // Keep memory usage flat - only hang on to the last hour of data
+        processMetric.EnableRollingWindows();
+        memoryMetric.EnableRollingWindows();
+        psiMetric.EnablePruning();
+        kernelThreadMetric.EnablePruning();
+        dmaBufMetric.EnablePruning();
+        if (counterMetric) {
+            counterMetric->EnablePruning();
+        }
+    }
+
+    if (gOomWarningHorizon.count() > 0) {
+        std::function<void()> onWarning;
+        if (gOomSnapshot) {
+            // Called on the memory collection thread, so leave the main thread to request the burst and save the report
+            onWarning = []()
+            {
+                gOomSnapshotRequested = true;
+                gStop.notify_all();
+            };
+        }
+        memoryMetric.EnableOomForecast(gOomWarningHorizon, onWarning);
+    } else if (gOomSnapshot) {
+        LOG_WARN("OOM forecasting is disabled - will not save a report when running out of memory");
+    }
+
+    // Starting and stopping can also be requested through the control socket, which keeps the metrics (and their
+    // caches) around rather than restarting MemCapture. Held whilst saving a snapshot too, so a restart doesn't happen
+    // whilst the metrics' results are being read
+    std::mutex captureLock;
+    bool capturing = false;
+
+    auto startCapture = [&]()
+    {
+        if (capturing) {
+            return;
+        }
+
+        processMetric.StartCollection(gCollectionInterval);
+        memoryMetric.StartCollection(gCollectionInterval);
+
+        if (psiEnabled) {
+            psiMetric.StartCollection(gPsiInterval);
+        }
+
+        if (gKernelThreads) {
+            kernelThreadMetric.StartCollection(gCollectionInterval);
+        }
+
+        if (dmaBufEnabled) {
+            dmaBufMetric.StartCollection(gCollectionInterval);
+        }
+
+        if (counterMetric) {
+            // Counters can set their own interval, this is only the default
+            counterMetric->StartCollection(gCollectionInterval);
+        }
+
+        capturing = true;
+    };
+
+    auto stopCapture = [&]()
+    {
+        if (!capturing) {
+            return;
+        }
+
+        processMetric.StopCollection();
+        memoryMetric.StopCollection();
+        if (psiEnabled) {
+            psiMetric.StopCollection();
+        }
+        if (gKernelThreads) {
+            kernelThreadMetric.StopCollection();
+        }
+        if (dmaBufEnabled) {
+            dmaBufMetric.StopCollection();
+        }
+        if (counterMetric) {
+            counterMetric->StopCollection();
+        }
+
+        capturing = false;
+    };
+
     // Start data collection
-    processMetric.StartCollection(std::chrono::seconds(3));
-    memoryMetric.StartCollection(std::chrono::seconds(3));
+    startCapture();
+
+    PsiTrigger psiTrigger(gPsiTriggerThreshold, gPsiTriggerWindow);
+    if (gPsiTrigger) {
+        bool started = psiTrigger.Start([&]()
+                                        {
+                                            processMetric.RequestBurst(gBurstInterval);
+                                            memoryMetric.RequestBurst(gBurstInterval);
+                                        });
+        if (!started) {
+            LOG_WARN("Failed to register PSI trigger - will not capture extra data under memory pressure");
+        }
+    }
 
     if (gCpuIdle) {
 #ifdef ENABLE_CPU_IDLE_METRICS
@@ -250,100 +733,225 @@ int main(int argc, char *argv[])
 #endif
     }
 
-    // Block main thread for the collection duration or until SIGTERM
-    std::unique_lock<std::mutex> locker(gLock);
-    gStop.wait_for(locker, std::chrono::seconds(gDuration));
-
-    if (!gEarlyTermination) {
-        LOG_INFO("Stopping after %d seconds - completed full capture", gDuration);
-    }
-
-    auto end = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
-    metadata->SetDuration(duration);
+    // Save the results of every running metric into the report generator. Safe to call whilst collection is running
+    auto saveResults = [&]()
+    {
+        CollectorStats::ScopedSample sample(reportGenerator->collectorStats().get(), "Save Results");
+        reportGenerator->reset();
 
-    // Done! Stop data collection
-    processMetric.StopCollection();
-    memoryMetric.StopCollection();
+        processMetric.SaveResults();
+        memoryMetric.SaveResults();
+        if (psiEnabled) {
+            psiMetric.SaveResults();
+        }
+        if (gKernelThreads) {
+            kernelThreadMetric.SaveResults();
+        }
+        if (dmaBufEnabled) {
+            dmaBufMetric.SaveResults();
+        }
+        if (counterMetric) {
+            counterMetric->SaveResults();
+        }
 #ifdef ENABLE_CPU_IDLE_METRICS
-    if (gCpuIdle) {
-        cpuIdleMetric.StopCollection();
-    }
+        if (gCpuIdle) {
+            cpuIdleMetric.SaveResults();
+        }
 #endif
+    };
 
-    // Save results
-    processMetric.SaveResults();
-    memoryMetric.SaveResults();
-#ifdef ENABLE_CPU_IDLE_METRICS
-    if (gCpuIdle) {
-        cpuIdleMetric.SaveResults();
-    }
-#endif
+    auto handleCommand = [&](const std::string &command, const std::string &argument) -> nlohmann::json
+    {
+        if (command == "ping") {
+            return {{"ok", true}};
+        } else if (command == "status") {
+            std::lock_guard<std::mutex> captureLocker(captureLock);
+            return {
+                    {"ok",         true},
+                    {"capturing",  capturing},
+                    {"intervalMs", gCollectionInterval.count()},
+                    {"uptime",     std::chrono::duration_cast<std::chrono::seconds>(
+                            std::chrono::steady_clock::now() - start).count()}
+            };
+        } else if (command == "start" || command == "stop") {
+            std::lock_guard<std::mutex> captureLocker(captureLock);
+            command == "start" ? startCapture() : stopCapture();
+            return {{"ok", true}, {"capturing", capturing}};
+        } else if (command == "mark") {
+            if (argument.empty()) {
+                return {{"ok", false}, {"error", "mark requires a phase name"}};
+            }
+            reportGenerator->addPhase(argument);
+            if (auto counterTrace = reportGenerator->counterTrace()) {
+                counterTrace->AddMarker(argument);
+            }
+            LOG_INFO("Marked phase '%s'", argument.c_str());
+            return {{"ok", true}};
+        } else if (command == "interval") {
+            int interval = std::atoi(argument.c_str());
+            if (interval < kMinimumCollectionInterval.count()) {
+                return {{"ok",    false},
+                        {"error", "interval must be at least " + std::to_string(kMinimumCollectionInterval.count()) + "ms"}};
+            }
 
-    // Build report
-    inja::Environment env;
-    // Make the output a bit tidier
-    env.set_trim_blocks(true);
-    env.set_lstrip_blocks(true);
+            // Collection has to be restarted to pick up the new interval, which waits for every collector to finish its
+            // current sample. Leave that to the main thread rather than holding up every other control client
+            gRequestedIntervalMs = interval;
+            gStop.notify_all();
+            return {{"ok", true}, {"intervalMs", interval}};
+        } else if (command == "top") {
+            int count = argument.empty() ? 10 : std::atoi(argument.c_str());
+            if (count <= 0) {
+                return {{"ok", false}, {"error", "top requires a positive number of processes"}};
+            }
+            return {{"ok", true}, {"processes", processMetric.GetTopProcesses(count)}};
+        } else if (command == "dump") {
+            // Built from copies of the live data rather than saveResults(), which would tidy up (and so change) the
+            // metrics' data and wait on every memory source
+            nlohmann::json linuxMemory = nlohmann::json::object();
+            for (const auto &measurement: memoryMetric.GetLinuxMemory()) {
+                linuxMemory[measurement.first] = measurement.second.ToJson();
+            }
 
-    // Convert the values in an object into an array that we can loop over (used for generating rows)
-    // Order the values using the _columnOrder data given in the second argument
-    env.add_callback("objectToArray", 2, [](inja::Arguments &args)
-    {
-        std::vector<nlohmann::json> values;
+            return {
+                    {"ok",          true},
+                    {"uptime",      std::chrono::duration_cast<std::chrono::seconds>(
+                            std::chrono::steady_clock::now() - start).count()},
+                    {"linuxMemory", linuxMemory},
+                    {"processes",   processMetric.GetProcesses()}
+            };
+        } else if (command == "snapshot") {
+            gSnapshotRequested = true;
+            gStop.notify_all();
+            return {{"ok", true}};
+        } else if (command == "quit") {
+            gEarlyTermination = true;
+            gStop.notify_all();
+            return {{"ok", true}};
+        }
 
-        assert(args.at(0)->is_object());
-        assert(args.at(1)->is_array());
+        return {{"ok", false}, {"error", "unknown command '" + command + "'"}};
+    };
 
-        std::map<std::string, nlohmann::json> flattenedData;
+    std::unique_ptr<ControlServer> controlServer;
+    if (!gControlSocket.empty()) {
+        controlServer = std::make_unique<ControlServer>(gControlSocket, handleCommand);
+        if (!controlServer->Start()) {
+            LOG_WARN("Control socket not available");
+            controlServer.reset();
+        }
+    }
 
-        // Flatten the data (one level deep only)
-        for (const auto &element: args.at(0)->items()) {
-            if (element.value().is_object()) {
-                // This is a very janky way to handle min/max/average & column ordering. The key name corresponds to "<Measurement Name> (Min/Max/Average)"
-                // which matches the _columnOrder values set in JsonReportGenerator
-                for (const auto &child: element.value().items()) {
-                    std::string keyName = element.key() + " (" + child.key() + ")";
-                    flattenedData.emplace(keyName, child.value());
-                }
+    // Block main thread until the capture duration is up (or forever as a daemon) or SIGTERM, saving a report
+    // whenever one is requested along the way
+    auto deadline = start + std::chrono::seconds(gDuration);
+    auto wakeUp = [&]
+    {
+        return gEarlyTermination || gSnapshotRequested || gOomSnapshotRequested || gRequestedIntervalMs != 0;
+    };
+
+    // Keep earlier reports if we've been saving them during the capture
+    bool rotate = gDaemon;
+
+    std::unique_lock<std::mutex> locker(gLock);
+    while (!gEarlyTermination) {
+        if (gDaemon) {
+            if (gSnapshotInterval.count() > 0) {
+                gStop.wait_for(locker, gSnapshotInterval, wakeUp);
             } else {
-                values.emplace_back(element.value());
-                flattenedData.emplace(element.key(), element.value());
+                gStop.wait(locker, wakeUp);
             }
+        } else if (!gStop.wait_until(locker, deadline, wakeUp)) {
+            LOG_INFO("Stopping after %d seconds - completed full capture", gDuration);
+            break;
         }
 
-        // Put the data into the order specified by _columnOrder
-        std::vector<nlohmann::json> ordered;
-        for (const auto &column: args.at(1)->items()) {
-            auto item = flattenedData.at(column.value());
-            ordered.emplace_back(item);
+        if (gEarlyTermination) {
+            break;
         }
 
-        return ordered;
-    });
+        if (auto interval = gRequestedIntervalMs.exchange(0); interval > 0) {
+            locker.unlock();
+            {
+                std::lock_guard<std::mutex> captureLocker(captureLock);
+                bool wasCapturing = capturing;
+                stopCapture();
+                gCollectionInterval = std::chrono::milliseconds(interval);
+                if (wasCapturing) {
+                    startCapture();
+                }
+            }
+            LOG_INFO("Collection interval changed to %lld ms", interval);
+            locker.lock();
 
-    // Write the JSON first - this is safer and is the report automation need, so if we crash
-    // after this point we'll still get some data
-    if (gJson) {
-        std::filesystem::path jsonFilepath = gOutputDirectory / "report.json";
-        std::ofstream outputJson(jsonFilepath, std::ios::trunc | std::ios::binary);
-        outputJson << reportGenerator->getJson().dump(4);
+            if (!gSnapshotRequested && !gOomSnapshotRequested) {
+                continue;
+            }
+        }
+
+        if (gOomSnapshotRequested.exchange(false)) {
+            LOG_WARN("Running out of memory - capturing more data before saving a report");
+            processMetric.RequestBurst(gBurstInterval);
+            memoryMetric.RequestBurst(gBurstInterval);
 
-        LOG_INFO("Saved JSON data to %s", jsonFilepath.string().c_str());
+            // Give the burst time to collect some samples so they're in the report
+            if (gStop.wait_for(locker, gOomSnapshotDelay, [&] { return gEarlyTermination; })) {
+                break;
+            }
+        }
+        gSnapshotRequested = false;
+
+        LOG_INFO("Saving report snapshot");
+        metadata->SetDuration(
+                std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count());
+
+        locker.unlock();
+        {
+            // The control socket can restart the metrics, which mustn't happen whilst their results are being saved
+            std::lock_guard<std::mutex> captureLocker(captureLock);
+            saveResults();
+            rotateReports();
+            writeReport(reportGenerator);
+        }
+        locker.lock();
+        rotate = true;
     }
 
-    try {
-        auto htmlTemplateString = std::string(g_templateHtml_data, g_templateHtml_data + g_templateHtml_size);
-        std::string result = env.render(htmlTemplateString, reportGenerator->getJson());
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::seconds>(end - start).count();
+    metadata->SetDuration(duration);
 
-        std::filesystem::path htmlFilepath = gOutputDirectory / "report.html";
-        std::ofstream outputHtml(htmlFilepath, std::ios::trunc | std::ios::binary);
-        outputHtml << result;
+    // Done! Stop data collection
+    if (controlServer) {
+        controlServer->Stop();
+    }
+    if (metricsServer) {
+        metricsServer->Stop();
+    }
+    psiTrigger.Stop();
+    stopCapture();
+    if (auto counterTrace = reportGenerator->counterTrace()) {
+        counterTrace->Close();
+    }
+    if (auto streamWriter = reportGenerator->streamWriter()) {
+        streamWriter->Close();
+    }
+#ifdef ENABLE_CPU_IDLE_METRICS
+    if (gCpuIdle) {
+        cpuIdleMetric.StopCollection();
+    }
+#endif
 
-        LOG_INFO("Saved report to %s", htmlFilepath.string().c_str());
-    } catch (const std::exception &e) {
-        LOG_ERROR("Failed to save HTML report with exception %s", e.what());
-        throw;
+    // Save results
+    saveResults();
+
+    if (rotate) {
+        rotateReports();
+    }
+    writeReport(reportGenerator);
+
+    if (traceRecorder) {
+        traceRecorder->Write(gTraceFile);
     }
 
     return EXIT_SUCCESS;
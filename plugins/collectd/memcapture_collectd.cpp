@@ -0,0 +1,243 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/*
+ * collectd read plugin that runs the MemCapture collectors inside collectd, so devices that already run collectd
+ * don't need a second process scanning /proc
+ *
+ * <LoadPlugin memcapture>
+ *     Interval 30
+ * </LoadPlugin>
+ * <Plugin memcapture>
+ *     Groups "/etc/memcapture/groups.json"
+ *     Platform "AMLOGIC"
+ * </Plugin>
+ *
+ * Dispatches per-group PSS (only if Groups is set), CMA, per-process-name GPU usage and fragmentation
+ */
+
+extern "C" {
+#include "collectd.h"
+#include "plugin.h"
+}
+
+#include "JsonReportGenerator.h"
+#include "Metadata.h"
+#include "GpuMemorySnapshot.h"
+#include "ProcessMetric.h"
+#include "MemoryMetric.h"
+#include "Platforms/PlatformRegistry.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+
+static const char *const kPluginName = "memcapture";
+
+static const char *gConfigKeys[] = {
+        "Groups",
+        "Platform"
+};
+
+static std::string gGroupsFile;
+static std::string gPlatformName;
+
+// How each exported family is dispatched to collectd
+struct dispatchRule
+{
+    std::string PluginInstance;
+    std::string Type;
+    // Labels that make up the type instance, joined with '-'
+    std::vector<std::string> Labels;
+    double Scale;
+};
+
+static const std::map<std::string, dispatchRule> kDispatchRules = {
+        {"memcapture_group_pss_bytes",            {"group",         "bytes",   {"group"},          1}},
+        {"memcapture_cma_memory_bytes",           {"cma",           "bytes",   {"region", "type"}, 1}},
+        {"memcapture_cma_total_bytes",            {"cma",           "bytes",   {"type"},           1}},
+        {"memcapture_gpu_memory_bytes",           {"gpu",           "bytes",   {"name"},           1}},
+        {"memcapture_memory_fragmentation_ratio", {"fragmentation", "percent", {"zone", "order"},  100}},
+};
+
+struct pluginState
+{
+    pluginState(std::shared_ptr<IPlatform> platform, std::optional<std::shared_ptr<GroupManager>> groupManager)
+            : reportGenerator(std::make_shared<JsonReportGenerator>(std::make_shared<Metadata>(), groupManager)),
+              metricsExporter(std::make_shared<MetricsExporter>(groupManager)),
+              gpuSnapshot(std::make_shared<GpuMemorySnapshot>()),
+              processMetric(reportGenerator, gpuSnapshot),
+              memoryMetric(std::move(platform), reportGenerator, gpuSnapshot)
+    {
+        reportGenerator->setMetricsExporter(metricsExporter);
+    }
+
+    const std::shared_ptr<JsonReportGenerator> reportGenerator;
+    const std::shared_ptr<MetricsExporter> metricsExporter;
+    const std::shared_ptr<GpuMemorySnapshot> gpuSnapshot;
+
+    ProcessMetric processMetric;
+    MemoryMetric memoryMetric;
+};
+
+static std::unique_ptr<pluginState> gState;
+
+/**
+ * collectd identifiers end up as file names with most writers
+ */
+static std::string sanitise(const std::string &name)
+{
+    std::string result = name;
+    for (auto &c: result) {
+        if (c == '/' || c == ' ' || c == '-') {
+            c = '_';
+        }
+    }
+
+    // Strip the leading path separator from process names
+    auto start = result.find_first_not_of('_');
+    return start == std::string::npos ? result : result.substr(start);
+}
+
+static int memcaptureConfig(const char *key, const char *value)
+{
+    if (strcasecmp(key, "Groups") == 0) {
+        gGroupsFile = value;
+    } else if (strcasecmp(key, "Platform") == 0) {
+        gPlatformName = value;
+    } else {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int memcaptureInit()
+{
+    try {
+        std::shared_ptr<IPlatform> platform = gPlatformName.empty() ? PlatformRegistry::Detect()
+                                                                    : PlatformRegistry::Create(gPlatformName);
+        if (!platform) {
+            ERROR("%s: unsupported platform %s", kPluginName, gPlatformName.c_str());
+            return -1;
+        }
+
+        std::optional<std::shared_ptr<GroupManager>> groupManager = std::nullopt;
+        if (!gGroupsFile.empty()) {
+            std::ifstream groupsFile(gGroupsFile);
+            if (!groupsFile) {
+                ERROR("%s: invalid groups file %s", kPluginName, gGroupsFile.c_str());
+                return -1;
+            }
+            groupManager = std::make_shared<GroupManager>(nlohmann::json::parse(groupsFile));
+        } else {
+            WARNING("%s: no Groups file configured, per-group PSS will not be reported", kPluginName);
+        }
+
+        gState = std::make_unique<pluginState>(platform, groupManager);
+
+        // Running for as long as collectd does, so only keep what's needed for the latest values
+        gState->processMetric.EnableRollingWindows();
+        gState->memoryMetric.EnableRollingWindows();
+
+        // The collectors run on their own threads at the plugin's interval, reads just dispatch the latest values
+        auto interval = std::chrono::milliseconds(CDTIME_T_TO_MS(plugin_get_interval()));
+        gState->processMetric.StartCollection(interval);
+        gState->memoryMetric.StartCollection(interval);
+    } catch (std::exception &e) {
+        ERROR("%s: failed to start with error %s", kPluginName, e.what());
+        return -1;
+    }
+
+    return 0;
+}
+
+static void dispatch(const dispatchRule &rule, const std::string &typeInstance, double value)
+{
+    value_t values[1];
+    values[0].gauge = value;
+
+    value_list_t vl = VALUE_LIST_INIT;
+    vl.values = values;
+    vl.values_len = 1;
+    sstrncpy(vl.plugin, kPluginName, sizeof(vl.plugin));
+    sstrncpy(vl.plugin_instance, rule.PluginInstance.c_str(), sizeof(vl.plugin_instance));
+    sstrncpy(vl.type, rule.Type.c_str(), sizeof(vl.type));
+    sstrncpy(vl.type_instance, typeInstance.c_str(), sizeof(vl.type_instance));
+
+    plugin_dispatch_values(&vl);
+}
+
+static int memcaptureRead()
+{
+    if (!gState) {
+        return -1;
+    }
+
+    for (const auto &families: gState->metricsExporter->Snapshot()) {
+        for (const auto &family: *families) {
+            auto rule = kDispatchRules.find(family.Name);
+            if (rule == kDispatchRules.end()) {
+                continue;
+            }
+
+            // Some families (GPU) are per-PID, which would give collectd a new series for every process started. Sum
+            // them by the labels we keep instead
+            std::map<std::string, double> values;
+            for (const auto &sample: family.Samples) {
+                std::string typeInstance;
+                for (const auto &name: rule->second.Labels) {
+                    for (const auto &label: sample.Labels) {
+                        if (label.first == name) {
+                            typeInstance += (typeInstance.empty() ? "" : "-") + sanitise(label.second);
+                        }
+                    }
+                }
+                values[typeInstance] += sample.Value * rule->second.Scale;
+            }
+
+            for (const auto &value: values) {
+                dispatch(rule->second, value.first, value.second);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int memcaptureShutdown()
+{
+    if (gState) {
+        gState->processMetric.StopCollection();
+        gState->memoryMetric.StopCollection();
+        gState.reset();
+    }
+
+    return 0;
+}
+
+extern "C" __attribute__((visibility("default"))) void module_register()
+{
+    plugin_register_config(kPluginName, memcaptureConfig, gConfigKeys, sizeof(gConfigKeys) / sizeof(gConfigKeys[0]));
+    plugin_register_init(kPluginName, memcaptureInit);
+    plugin_register_read(kPluginName, memcaptureRead);
+    plugin_register_shutdown(kPluginName, memcaptureShutdown);
+}
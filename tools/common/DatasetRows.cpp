@@ -0,0 +1,71 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "DatasetRows.h"
+
+std::unordered_map<std::string, DatasetRows::Entry> DatasetRows::Load(const nlohmann::json &report)
+{
+    std::unordered_map<std::string, Entry> entries;
+
+    if (!report.contains("data") || !report["data"].is_array()) {
+        return entries;
+    }
+
+    for (const auto &dataset: report["data"]) {
+        const auto &columns = dataset.value("_columnOrder", nlohmann::json::array());
+        if (columns.empty() || !dataset.contains("data")) {
+            continue;
+        }
+
+        auto name = dataset.value("name", "");
+        auto keyColumn = columns[0].get<std::string>();
+
+        if (keyColumn == "PID") {
+            // PIDs don't match between boots, so use the process or thread name in the next column. Rows without a
+            // name there are skipped below
+            if (columns.size() < 2) {
+                continue;
+            }
+            keyColumn = columns[1].get<std::string>();
+        }
+
+        for (const auto &row: dataset["data"]) {
+            if (!row.contains(keyColumn) || !row[keyColumn].is_string()) {
+                continue;
+            }
+            auto rowName = row[keyColumn].get<std::string>();
+
+            for (const auto &item: row.items()) {
+                if (!item.value().is_object() || !item.value().contains("Average")) {
+                    continue;
+                }
+
+                auto &entry = entries[name + '\n' + rowName + '\n' + item.key()];
+                if (entry.Values.empty()) {
+                    entry.Dataset = name;
+                    entry.Row = rowName;
+                    entry.Measurement = item.key();
+                }
+                entry.Values.emplace_back(&item.value());
+            }
+        }
+    }
+
+    return entries;
+}
@@ -0,0 +1,53 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief Reads every measurement in every dataset of a data report, keyed so the same row can be matched between
+ * reports (e.g. from different builds or different devices)
+ *
+ * The first column of each dataset names the row. Tables keyed by PID (e.g. GPU Memory, Kernel Threads, DMA-BUF
+ * Importers) are named by the process or thread name column after it instead, as the same PID belongs to a different
+ * process on another boot. Rows with the same name (e.g. several instances of a process) are collected together
+ */
+class DatasetRows
+{
+public:
+    struct Entry
+    {
+        std::string Dataset;
+        std::string Row;
+        std::string Measurement;
+
+        // Measurement objects ("Min", "Max", "Average"...) of each row with this name, pointing into the report
+        std::vector<const nlohmann::json *> Values;
+    };
+
+    /**
+     * @return Entries keyed by dataset, row and measurement name. Only valid for as long as the report is
+     */
+    static std::unordered_map<std::string, Entry> Load(const nlohmann::json &report);
+};
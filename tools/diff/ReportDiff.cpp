@@ -0,0 +1,378 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "ReportDiff.h"
+#include "tools/common/DatasetRows.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+// Memory types that make up a process's footprint, each compared separately
+static const std::vector<std::string> kProcessMetrics = {"pss", "swap", "gpu", "dmabuf"};
+
+// Dataset rows that are memory used by something, so an increase is a regression rather than just a change
+static const std::string kContainersDataset = "Containers";
+
+ReportDiff::ReportDiff(Options options)
+        : mOptions(options)
+{
+
+}
+
+void ReportDiff::stats::Add(const nlohmann::json &measurement)
+{
+    // Process measurements use lower case keys, dataset measurements are capitalised for the table headings
+    auto get = [&](const char *lower, const char *upper) -> const nlohmann::json *
+    {
+        if (measurement.contains(lower)) {
+            return &measurement.at(lower);
+        } else if (measurement.contains(upper)) {
+            return &measurement.at(upper);
+        }
+        return nullptr;
+    };
+
+    if (auto average = get("average", "Average")) {
+        Average += average->get<double>();
+    }
+
+    // Consecutive samples are correlated, so use the effective sample size where the report has it. Older reports only
+    // have the raw count, which understates the standard error
+    auto stdDev = get("stdDev", "StdDev");
+    auto samples = get("effectiveSamples", "EffectiveSamples");
+    if (!samples) {
+        samples = get("samples", "Samples");
+    }
+    if (stdDev && samples && samples->get<double>() > 0) {
+        ErrorVariance += std::pow(stdDev->get<double>(), 2) / samples->get<double>();
+    } else {
+        VarianceKnown = false;
+    }
+}
+
+void ReportDiff::stats::Add(const stats &other)
+{
+    Average += other.Average;
+    ErrorVariance += other.ErrorVariance;
+    VarianceKnown = VarianceKnown && other.VarianceKnown;
+}
+
+void ReportDiff::processEntry::Add(const processEntry &other)
+{
+    if (Instances == 0) {
+        Name = other.Name;
+        Cmdline = other.Cmdline;
+        Group = other.Group;
+    }
+
+    Instances += other.Instances;
+    for (const auto &metric: other.Metrics) {
+        Metrics[metric.first].Add(metric.second);
+    }
+}
+
+/**
+ * Load the processes in a report, summing instances with the same name and command line
+ */
+ReportDiff::processMap ReportDiff::loadProcesses(const nlohmann::json &report)
+{
+    processMap processes;
+
+    if (!report.contains("processes") || !report["processes"].is_array()) {
+        return processes;
+    }
+
+    processes.reserve(report["processes"].size());
+
+    for (const auto &process: report["processes"]) {
+        auto name = process.value("name", "");
+        auto cmdline = process.value("cmdline", "");
+
+        auto &entry = processes[name + '\n' + cmdline];
+        if (entry.Instances == 0) {
+            entry.Name = name;
+            entry.Cmdline = cmdline;
+            entry.Group = process.value("group", "");
+        }
+        entry.Instances++;
+
+        for (const auto &metric: kProcessMetrics) {
+            if (process.contains(metric) && process[metric].is_object()) {
+                entry.Metrics[metric].Add(process[metric]);
+            }
+        }
+    }
+
+    return processes;
+}
+
+std::unordered_map<std::string, ReportDiff::stats> ReportDiff::loadGroups(const processMap &processes)
+{
+    std::unordered_map<std::string, stats> groups;
+
+    for (const auto &process: processes) {
+        if (process.second.Group.empty()) {
+            continue;
+        }
+
+        auto pss = process.second.Metrics.find("pss");
+        if (pss != process.second.Metrics.end()) {
+            groups[process.second.Group].Add(pss->second);
+        }
+    }
+
+    return groups;
+}
+
+/**
+ * Load every measurement in every dataset, summing rows with the same name
+ */
+std::unordered_map<std::string, ReportDiff::datasetEntry> ReportDiff::loadDatasets(const nlohmann::json &report)
+{
+    std::unordered_map<std::string, datasetEntry> datasets;
+
+    for (const auto &row: DatasetRows::Load(report)) {
+        auto &entry = datasets[row.first];
+        entry.Dataset = row.second.Dataset;
+        entry.Row = row.second.Row;
+        entry.Measurement = row.second.Measurement;
+        for (const auto *value: row.second.Values) {
+            entry.Value.Add(*value);
+        }
+    }
+
+    return datasets;
+}
+
+/**
+ * @param kb True if the values are sizes in KB, so the minimum change is an absolute size
+ * @param[out] significant Whether the change is large enough to report
+ */
+nlohmann::json ReportDiff::compareStats(const stats &baseline, const stats &candidate, bool kb, bool &significant) const
+{
+    nlohmann::json result;
+
+    double delta = candidate.Average - baseline.Average;
+    result["baseline"] = baseline.Average;
+    result["candidate"] = candidate.Average;
+    result["delta"] = delta;
+
+    std::optional<double> deltaPercent;
+    if (baseline.Average != 0) {
+        deltaPercent = delta / std::fabs(baseline.Average) * 100;
+        result["deltaPercent"] = std::round(deltaPercent.value() * 10) / 10;
+    }
+
+    // With no variance (or no idea of the variance) any change that's big enough counts
+    std::optional<double> zScore;
+    double standardError = std::sqrt(baseline.ErrorVariance + candidate.ErrorVariance);
+    if (baseline.VarianceKnown && candidate.VarianceKnown && standardError > 0) {
+        zScore = delta / standardError;
+        result["zScore"] = std::round(zScore.value() * 10) / 10;
+    }
+
+    bool bigEnough = kb ? std::fabs(delta) >= mOptions.MinimumChangeKb
+                        : (deltaPercent.has_value() ? std::fabs(deltaPercent.value()) >= mOptions.MinimumChangePercent
+                                                    : delta != 0);
+
+    significant = bigEnough && (!zScore.has_value() || std::fabs(zScore.value()) >= mOptions.Threshold);
+    result["significant"] = significant;
+
+    return result;
+}
+
+nlohmann::json ReportDiff::Compare(const nlohmann::json &baseline, const nlohmann::json &candidate) const
+{
+    auto regressions = nlohmann::json::array();
+    auto improvements = nlohmann::json::array();
+    auto datasetChanges = nlohmann::json::array();
+    auto added = nlohmann::json::array();
+    auto removed = nlohmann::json::array();
+
+    auto addChange = [&](nlohmann::json change, bool significant)
+    {
+        if (significant) {
+            (change["delta"].get<double>() > 0 ? regressions : improvements).emplace_back(std::move(change));
+        }
+    };
+
+    auto compareProcess = [&](const processEntry &before, const processEntry &after, const char *matchedBy)
+    {
+        for (const auto &metric: kProcessMetrics) {
+            auto b = before.Metrics.find(metric);
+            auto a = after.Metrics.find(metric);
+            if (b == before.Metrics.end() || a == after.Metrics.end()) {
+                continue;
+            }
+
+            bool significant = false;
+            auto change = compareStats(b->second, a->second, true, significant);
+            change["kind"] = "process";
+            change["name"] = after.Name;
+            change["group"] = after.Group;
+            change["metric"] = metric;
+            change["matchedBy"] = matchedBy;
+            change["instances"] = {{"baseline", before.Instances}, {"candidate", after.Instances}};
+            addChange(std::move(change), significant);
+        }
+    };
+
+    auto processJson = [](const processEntry &process)
+    {
+        auto pss = process.Metrics.find("pss");
+        return nlohmann::json{
+                {"name",      process.Name},
+                {"cmdline",   process.Cmdline},
+                {"group",     process.Group},
+                {"instances", process.Instances},
+                {"pss",       pss != process.Metrics.end() ? pss->second.Average : 0}
+        };
+    };
+
+    // Processes - first join on name and command line
+    auto baselineProcesses = loadProcesses(baseline);
+    auto candidateProcesses = loadProcesses(candidate);
+
+    processMap unmatchedBaseline;
+    processMap unmatchedCandidate;
+
+    for (const auto &after: candidateProcesses) {
+        auto before = baselineProcesses.find(after.first);
+        if (before != baselineProcesses.end()) {
+            compareProcess(before->second, after.second, "cmdline");
+        } else {
+            unmatchedCandidate[after.second.Name].Add(after.second);
+        }
+    }
+
+    for (const auto &before: baselineProcesses) {
+        if (candidateProcesses.find(before.first) == candidateProcesses.end()) {
+            unmatchedBaseline[before.second.Name].Add(before.second);
+        }
+    }
+
+    // Then join whatever's left on name alone, in case the arguments changed
+    for (const auto &after: unmatchedCandidate) {
+        auto before = unmatchedBaseline.find(after.first);
+        if (before != unmatchedBaseline.end()) {
+            compareProcess(before->second, after.second, "name");
+        } else {
+            added.emplace_back(processJson(after.second));
+        }
+    }
+
+    for (const auto &before: unmatchedBaseline) {
+        if (unmatchedCandidate.find(before.first) == unmatchedCandidate.end()) {
+            removed.emplace_back(processJson(before.second));
+        }
+    }
+
+    // Groups
+    auto baselineGroups = loadGroups(baselineProcesses);
+    auto candidateGroups = loadGroups(candidateProcesses);
+
+    for (const auto &after: candidateGroups) {
+        auto before = baselineGroups.find(after.first);
+        if (before == baselineGroups.end()) {
+            continue;
+        }
+
+        bool significant = false;
+        auto change = compareStats(before->second, after.second, true, significant);
+        change["kind"] = "group";
+        change["name"] = after.first;
+        change["metric"] = "pss";
+        addChange(std::move(change), significant);
+    }
+
+    // Datasets, including containers
+    auto baselineDatasets = loadDatasets(baseline);
+    auto candidateDatasets = loadDatasets(candidate);
+
+    for (const auto &after: candidateDatasets) {
+        auto before = baselineDatasets.find(after.first);
+        if (before == baselineDatasets.end()) {
+            continue;
+        }
+
+        const auto &entry = after.second;
+        bool kb = entry.Measurement.size() >= 3 && entry.Measurement.compare(entry.Measurement.size() - 3, 3, "_KB") == 0;
+
+        bool significant = false;
+        auto change = compareStats(before->second.Value, entry.Value, kb, significant);
+        change["metric"] = entry.Measurement;
+
+        if (entry.Dataset == kContainersDataset) {
+            change["kind"] = "container";
+            change["name"] = entry.Row;
+            addChange(std::move(change), significant);
+        } else if (significant) {
+            change["kind"] = "dataset";
+            change["dataset"] = entry.Dataset;
+            change["name"] = entry.Row;
+            change["unit"] = kb ? "KB" : "";
+            datasetChanges.emplace_back(std::move(change));
+        }
+    }
+
+    // Biggest changes first
+    auto byDelta = [](const nlohmann::json &a, const nlohmann::json &b)
+    {
+        return std::fabs(a["delta"].get<double>()) > std::fabs(b["delta"].get<double>());
+    };
+    auto byPss = [](const nlohmann::json &a, const nlohmann::json &b)
+    {
+        return a["pss"].get<double>() > b["pss"].get<double>();
+    };
+
+    std::sort(regressions.begin(), regressions.end(), byDelta);
+    std::sort(improvements.begin(), improvements.end(), byDelta);
+    std::sort(added.begin(), added.end(), byPss);
+    std::sort(removed.begin(), removed.end(), byPss);
+
+    // Datasets mix units, so rank by relative change
+    std::sort(datasetChanges.begin(), datasetChanges.end(), [](const nlohmann::json &a, const nlohmann::json &b)
+    {
+        return std::fabs(a.value("deltaPercent", 0.0)) > std::fabs(b.value("deltaPercent", 0.0));
+    });
+
+    nlohmann::json result;
+    result["baseline"] = baseline.value("metadata", nlohmann::json::object());
+    result["candidate"] = candidate.value("metadata", nlohmann::json::object());
+    result["options"] = {
+            {"threshold",            mOptions.Threshold},
+            {"minimumChangeKb",      mOptions.MinimumChangeKb},
+            {"minimumChangePercent", mOptions.MinimumChangePercent}
+    };
+    result["summary"] = {
+            {"regressions",      regressions.size()},
+            {"improvements",     improvements.size()},
+            {"datasetChanges",   datasetChanges.size()},
+            {"processesAdded",   added.size()},
+            {"processesRemoved", removed.size()}
+    };
+    result["regressions"] = std::move(regressions);
+    result["improvements"] = std::move(improvements);
+    result["datasetChanges"] = std::move(datasetChanges);
+    result["added"] = std::move(added);
+    result["removed"] = std::move(removed);
+
+    return result;
+}
@@ -0,0 +1,107 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief Compares two MemCapture data reports (e.g. from the old and new build of an image) and ranks what changed
+ *
+ * Processes are matched by name and command line, falling back to name alone for processes whose arguments changed
+ * between builds. Instances of the same process are summed. Groups, containers and dataset rows are matched by key,
+ * except that rows of tables keyed by PID are matched by process name (see DatasetRows). All matching is done with hash
+ * joins so large captures compare quickly.
+ *
+ * A change is only reported if it's larger than the minimum change and, when the reports include the standard
+ * deviation of each measurement, larger than the noise seen during the captures - the difference of the averages
+ * divided by its standard error must be at least the threshold. Samples within a capture are not independent, so the
+ * standard error uses the effective sample size recorded for each measurement (from its lag-1 autocorrelation). That
+ * only allows for short-range correlation, so treat this as a guide rather than a statistical test
+ */
+class ReportDiff
+{
+public:
+    struct Options
+    {
+        // Minimum z-score for a change to count as significant
+        double Threshold = 3.0;
+
+        // Ignore changes smaller than this, even if they're significant
+        double MinimumChangeKb = 256;
+        double MinimumChangePercent = 5;
+    };
+
+    explicit ReportDiff(Options options);
+
+    nlohmann::json Compare(const nlohmann::json &baseline, const nlohmann::json &candidate) const;
+
+private:
+    // Average of a measurement, or the sum of averages for several instances of a process
+    struct stats
+    {
+        double Average = 0;
+
+        // Square of the standard error of the average, summed over instances
+        double ErrorVariance = 0;
+
+        // False if any of the inputs came from a report without standard deviations
+        bool VarianceKnown = true;
+
+        void Add(const nlohmann::json &measurement);
+
+        void Add(const stats &other);
+    };
+
+    struct processEntry
+    {
+        std::string Name;
+        std::string Cmdline;
+        std::string Group;
+        int Instances = 0;
+        std::unordered_map<std::string, stats> Metrics;
+
+        void Add(const processEntry &other);
+    };
+
+    struct datasetEntry
+    {
+        std::string Dataset;
+        std::string Row;
+        std::string Measurement;
+        stats Value;
+    };
+
+    using processMap = std::unordered_map<std::string, processEntry>;
+
+    static processMap loadProcesses(const nlohmann::json &report);
+
+    static std::unordered_map<std::string, stats> loadGroups(const processMap &processes);
+
+    static std::unordered_map<std::string, datasetEntry> loadDatasets(const nlohmann::json &report);
+
+    nlohmann::json compareStats(const stats &baseline, const stats &candidate, bool kb, bool &significant) const;
+
+private:
+    const Options mOptions;
+};
@@ -0,0 +1,155 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "ReportDiff.h"
+#include "ReportFormat.h"
+#include "Log.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+
+#include "inja/inja.hpp"
+
+#define INCBIN_STYLE INCBIN_STYLE_SNAKE
+#define INCBIN_PREFIX g_
+
+#include <incbin.h>
+
+INCBIN(diffHtml, "./templates/diff.html");
+
+static std::filesystem::path gOutputDirectory = std::filesystem::current_path();
+static ReportDiff::Options gOptions;
+
+static void displayUsage()
+{
+    printf("Usage: memcapture-diff <option(s)> <baseline report> <candidate report>\n");
+    printf("    Compare two MemCapture data reports (any --format) and rank the regressions\n\n");
+    printf("    -h, --help          Print this help and exit\n");
+    printf("    -o, --output-dir    Directory to save diff.json and diff.html in. Default current directory\n");
+    printf("    -z, --threshold     How many standard errors a change must be to count as significant. Default %.1f\n",
+           gOptions.Threshold);
+    printf("    -m, --min-change    Ignore changes in memory usage smaller than this many KB. Default %.0f\n",
+           gOptions.MinimumChangeKb);
+    printf("    -P, --min-percent   Ignore changes in other values smaller than this percentage. Default %.0f\n",
+           gOptions.MinimumChangePercent);
+}
+
+static void parseArgs(const int argc, char **argv)
+{
+    struct option longopts[] = {
+            {"help",        no_argument,       nullptr, (int) 'h'},
+            {"output-dir",  required_argument, nullptr, (int) 'o'},
+            {"threshold",   required_argument, nullptr, (int) 'z'},
+            {"min-change",  required_argument, nullptr, (int) 'm'},
+            {"min-percent", required_argument, nullptr, (int) 'P'},
+            {nullptr, 0,                       nullptr, 0}
+    };
+
+    opterr = 0;
+
+    int option;
+    int longindex;
+
+    while ((option = getopt_long(argc, argv, "ho:z:m:P:", longopts, &longindex)) != -1) {
+        switch (option) {
+            case 'h':
+                displayUsage();
+                exit(EXIT_SUCCESS);
+            case 'o':
+                gOutputDirectory = std::filesystem::path(optarg);
+                break;
+            case 'z':
+                gOptions.Threshold = std::atof(optarg);
+                break;
+            case 'm':
+                gOptions.MinimumChangeKb = std::atof(optarg);
+                break;
+            case 'P':
+                gOptions.MinimumChangePercent = std::atof(optarg);
+                break;
+            default:
+                displayUsage();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 2) {
+        displayUsage();
+        exit(EXIT_FAILURE);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    parseArgs(argc, argv);
+
+    std::filesystem::path baselinePath(argv[optind]);
+    std::filesystem::path candidatePath(argv[optind + 1]);
+
+    nlohmann::json diff;
+    try {
+        auto start = std::chrono::steady_clock::now();
+
+        auto baseline = ReadReport(baselinePath);
+        auto candidate = ReadReport(candidatePath);
+        diff = ReportDiff(gOptions).Compare(baseline, candidate);
+
+        diff["baseline"]["file"] = baselinePath.string();
+        diff["candidate"]["file"] = candidatePath.string();
+
+        auto end = std::chrono::steady_clock::now();
+        LOG_INFO("Compared reports in %lld ms",
+                 (long long) std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+    } catch (std::exception &e) {
+        LOG_ERROR("Failed to compare reports with error %s", e.what());
+        return EXIT_FAILURE;
+    }
+
+    LOG_INFO("%d regressions, %d improvements, %d processes added, %d removed",
+             diff["summary"]["regressions"].get<int>(), diff["summary"]["improvements"].get<int>(),
+             diff["summary"]["processesAdded"].get<int>(), diff["summary"]["processesRemoved"].get<int>());
+
+    try {
+        std::filesystem::create_directories(gOutputDirectory);
+
+        std::filesystem::path jsonFilepath = gOutputDirectory / "diff.json";
+        if (!WriteReport(diff, ReportFormat::Json, jsonFilepath)) {
+            return EXIT_FAILURE;
+        }
+        LOG_INFO("Saved diff to %s", jsonFilepath.string().c_str());
+
+        inja::Environment env;
+        env.set_trim_blocks(true);
+        env.set_lstrip_blocks(true);
+
+        auto htmlTemplateString = std::string(g_diffHtml_data, g_diffHtml_data + g_diffHtml_size);
+
+        std::filesystem::path htmlFilepath = gOutputDirectory / "diff.html";
+        std::ofstream outputHtml(htmlFilepath, std::ios::trunc | std::ios::binary);
+        outputHtml << env.render(htmlTemplateString, diff);
+        LOG_INFO("Saved diff report to %s", htmlFilepath.string().c_str());
+    } catch (const std::exception &e) {
+        LOG_ERROR("Failed to save diff with exception %s", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
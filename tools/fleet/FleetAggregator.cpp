@@ -0,0 +1,310 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "FleetAggregator.h"
+#include "tools/common/DatasetRows.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <tuple>
+
+// Per-process memory, in KB, summarised across the fleet
+static const std::array<std::string, 5> kProcessMetrics = {"pss", "rss", "swap", "gpu", "dmabuf"};
+
+// Totals from the report's grandTotal, in MB
+static const std::array<std::string, 2> kSystemTotals = {"linuxUsage", "calculatedUsage"};
+
+FleetAggregator::FleetAggregator(double relativeAccuracy)
+        : mAccuracy(relativeAccuracy),
+          mDevices(0)
+{
+
+}
+
+QuantileSketch &FleetAggregator::sketch(std::unordered_map<std::string, QuantileSketch> &sketches,
+                                        const std::string &key)
+{
+    return sketches.try_emplace(key, mAccuracy).first->second;
+}
+
+void FleetAggregator::Add(const nlohmann::json &report)
+{
+    mDevices++;
+
+    const auto &metadata = report.value("metadata", nlohmann::json::object());
+    auto image = metadata.is_object() ? metadata.value("image", "") : "";
+    auto platform = metadata.is_object() ? metadata.value("platform", "") : "";
+    mImages[image.empty() ? "Unknown" : image]++;
+    mPlatforms[platform.empty() ? "Unknown" : platform]++;
+
+    if (report.contains("grandTotal") && report["grandTotal"].is_object()) {
+        for (const auto &total: kSystemTotals) {
+            const auto &value = report["grandTotal"].value(total, nlohmann::json());
+            if (value.is_number()) {
+                sketch(mSystem, total).Add(value.get<double>());
+            }
+        }
+    }
+
+    addProcesses(report);
+    addDatasets(report);
+}
+
+/**
+ * Sum each process's instances on this device, then add one value per device to the fleet distributions. Group PSS
+ * is summed the same way
+ */
+void FleetAggregator::addProcesses(const nlohmann::json &report)
+{
+    if (!report.contains("processes") || !report["processes"].is_array()) {
+        return;
+    }
+
+    struct deviceProcess
+    {
+        std::string Group;
+        uint64_t Instances = 0;
+        std::array<double, kProcessMetrics.size()> Metrics = {};
+    };
+
+    std::unordered_map<std::string, deviceProcess> processes;
+    std::unordered_map<std::string, double> groups;
+
+    processes.reserve(report["processes"].size());
+
+    for (const auto &process: report["processes"]) {
+        auto &entry = processes[process.value("name", "")];
+        entry.Instances++;
+
+        auto group = process.value("group", "");
+        if (entry.Group.empty()) {
+            entry.Group = group;
+        }
+
+        for (size_t i = 0; i < kProcessMetrics.size(); i++) {
+            const auto &metric = process.value(kProcessMetrics[i], nlohmann::json());
+            if (!metric.is_object() || !metric.contains("average")) {
+                continue;
+            }
+
+            auto average = metric["average"].get<double>();
+            entry.Metrics[i] += average;
+
+            // Group totals are PSS only, as in the report's own pssByGroup
+            if (i == 0 && !group.empty()) {
+                groups[group] += average;
+            }
+        }
+    }
+
+    for (const auto &process: processes) {
+        auto &entry = mProcesses[process.first];
+        if (entry.Metrics.empty()) {
+            entry.Metrics.assign(kProcessMetrics.size(), QuantileSketch(mAccuracy));
+        }
+        if (entry.Group.empty()) {
+            entry.Group = process.second.Group;
+        }
+        entry.Instances += process.second.Instances;
+
+        for (size_t i = 0; i < kProcessMetrics.size(); i++) {
+            entry.Metrics[i].Add(process.second.Metrics[i]);
+        }
+    }
+
+    for (const auto &group: groups) {
+        sketch(mGroups, group.first).Add(group.second);
+    }
+}
+
+/**
+ * Add the average of every measurement in every dataset, with rows of the same name on this device summed
+ */
+void FleetAggregator::addDatasets(const nlohmann::json &report)
+{
+    for (const auto &row: DatasetRows::Load(report)) {
+        double total = 0;
+        for (const auto *value: row.second.Values) {
+            total += (*value)["Average"].get<double>();
+        }
+
+        auto itr = mDatasets.find(row.first);
+        if (itr == mDatasets.end()) {
+            itr = mDatasets.emplace(row.first, datasetEntry{row.second.Dataset, row.second.Row, row.second.Measurement,
+                                                            QuantileSketch(mAccuracy)}).first;
+        }
+        itr->second.Value.Add(total);
+    }
+}
+
+void FleetAggregator::Merge(const FleetAggregator &other)
+{
+    mDevices += other.mDevices;
+
+    for (const auto &image: other.mImages) {
+        mImages[image.first] += image.second;
+    }
+    for (const auto &platform: other.mPlatforms) {
+        mPlatforms[platform.first] += platform.second;
+    }
+
+    for (const auto &total: other.mSystem) {
+        sketch(mSystem, total.first).Merge(total.second);
+    }
+
+    for (const auto &process: other.mProcesses) {
+        auto &entry = mProcesses[process.first];
+        if (entry.Metrics.empty()) {
+            entry = process.second;
+            continue;
+        }
+
+        if (entry.Group.empty()) {
+            entry.Group = process.second.Group;
+        }
+        entry.Instances += process.second.Instances;
+
+        for (size_t i = 0; i < entry.Metrics.size(); i++) {
+            entry.Metrics[i].Merge(process.second.Metrics[i]);
+        }
+    }
+
+    for (const auto &group: other.mGroups) {
+        sketch(mGroups, group.first).Merge(group.second);
+    }
+
+    for (const auto &dataset: other.mDatasets) {
+        auto itr = mDatasets.find(dataset.first);
+        if (itr == mDatasets.end()) {
+            mDatasets.emplace(dataset);
+        } else {
+            itr->second.Value.Merge(dataset.second.Value);
+        }
+    }
+}
+
+uint64_t FleetAggregator::Devices() const
+{
+    return mDevices;
+}
+
+nlohmann::json FleetAggregator::ToJson() const
+{
+    nlohmann::json result;
+
+    auto percentOfDevices = [&](uint64_t count)
+    {
+        return mDevices > 0 ? std::round((double) count / (double) mDevices * 1000) / 10 : 0.0;
+    };
+
+    auto counts = [&](const std::map<std::string, uint64_t> &values)
+    {
+        auto list = nlohmann::json::array();
+        for (const auto &value: values) {
+            list.push_back({{"name", value.first}, {"devices", value.second}});
+        }
+        std::stable_sort(list.begin(), list.end(), [](const nlohmann::json &a, const nlohmann::json &b)
+        {
+            return a["devices"].get<uint64_t>() > b["devices"].get<uint64_t>();
+        });
+        return list;
+    };
+
+    result["metadata"] = {
+            {"devices",          mDevices},
+            {"relativeAccuracy", mAccuracy},
+            {"images",           counts(mImages)},
+            {"platforms",        counts(mPlatforms)}
+    };
+
+    result["system"] = nlohmann::json::array();
+    for (const auto &total: kSystemTotals) {
+        auto itr = mSystem.find(total);
+        if (itr != mSystem.end()) {
+            auto tmp = itr->second.ToJson();
+            tmp["name"] = total;
+            result["system"].emplace_back(tmp);
+        }
+    }
+
+    // Sort by median PSS desc, the same order as the processes in a single report
+    std::vector<std::tuple<double, const std::string *, const processEntry *>> processes;
+    processes.reserve(mProcesses.size());
+    for (const auto &process: mProcesses) {
+        processes.emplace_back(process.second.Metrics[0].Quantile(0.5), &process.first, &process.second);
+    }
+    std::sort(processes.begin(), processes.end(), [](const auto &a, const auto &b)
+    {
+        return std::get<0>(a) > std::get<0>(b);
+    });
+
+    result["processes"] = nlohmann::json::array();
+    for (const auto &process: processes) {
+        const auto &entry = *std::get<2>(process);
+        uint64_t devices = entry.Metrics[0].Count();
+
+        nlohmann::json tmp;
+        tmp["name"] = *std::get<1>(process);
+        tmp["group"] = entry.Group;
+        tmp["devices"] = devices;
+        tmp["devicesPercent"] = percentOfDevices(devices);
+        tmp["instances"] = devices > 0 ? std::round((double) entry.Instances / (double) devices * 10) / 10 : 0.0;
+
+        for (size_t i = 0; i < kProcessMetrics.size(); i++) {
+            tmp[kProcessMetrics[i]] = entry.Metrics[i].ToJson();
+        }
+
+        result["processes"].emplace_back(tmp);
+    }
+
+    result["groups"] = nlohmann::json::array();
+    for (const auto &group: mGroups) {
+        auto tmp = group.second.ToJson();
+        tmp["name"] = group.first;
+        tmp["devicesPercent"] = percentOfDevices(group.second.Count());
+        result["groups"].emplace_back(tmp);
+    }
+    std::sort(result["groups"].begin(), result["groups"].end(), [](const nlohmann::json &a, const nlohmann::json &b)
+    {
+        return a["p50"].get<double>() > b["p50"].get<double>();
+    });
+
+    // Keep the datasets in a stable order - by dataset then row - so fleet reports are easy to compare by eye
+    std::vector<const datasetEntry *> datasets;
+    datasets.reserve(mDatasets.size());
+    for (const auto &dataset: mDatasets) {
+        datasets.emplace_back(&dataset.second);
+    }
+    std::sort(datasets.begin(), datasets.end(), [](const datasetEntry *a, const datasetEntry *b)
+    {
+        return std::tie(a->Dataset, a->Row, a->Measurement) < std::tie(b->Dataset, b->Row, b->Measurement);
+    });
+
+    result["datasets"] = nlohmann::json::array();
+    for (const auto *dataset: datasets) {
+        auto tmp = dataset->Value.ToJson();
+        tmp["dataset"] = dataset->Dataset;
+        tmp["name"] = dataset->Row;
+        tmp["metric"] = dataset->Measurement;
+        result["datasets"].emplace_back(tmp);
+    }
+
+    return result;
+}
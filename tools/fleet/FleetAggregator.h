@@ -0,0 +1,92 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include "QuantileSketch.h"
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief Summarises MemCapture data reports from many devices into the distribution of each value across the fleet
+ *
+ * Each report is reduced to one value per device - the average PSS of a process (summed over instances with the same
+ * name), of a group, of each dataset row (by process name for tables keyed by PID, see DatasetRows) - and added to a
+ * QuantileSketch, so memory use depends on the number of distinct processes rather than the number of reports. Aggregators can be merged, so each thread can build one from
+ * its share of the reports.
+ *
+ * A process's distribution only covers the devices it was running on, see "devices" in the output
+ */
+class FleetAggregator
+{
+public:
+    explicit FleetAggregator(double relativeAccuracy = 0.01);
+
+    /**
+     * Add one device's data report
+     */
+    void Add(const nlohmann::json &report);
+
+    void Merge(const FleetAggregator &other);
+
+    uint64_t Devices() const;
+
+    nlohmann::json ToJson() const;
+
+private:
+    struct processEntry
+    {
+        std::string Group;
+        uint64_t Instances = 0;
+
+        // One per kProcessMetrics
+        std::vector<QuantileSketch> Metrics;
+    };
+
+    struct datasetEntry
+    {
+        std::string Dataset;
+        std::string Row;
+        std::string Measurement;
+        QuantileSketch Value;
+    };
+
+    QuantileSketch &sketch(std::unordered_map<std::string, QuantileSketch> &sketches, const std::string &key);
+
+    void addProcesses(const nlohmann::json &report);
+
+    void addDatasets(const nlohmann::json &report);
+
+private:
+    const double mAccuracy;
+
+    uint64_t mDevices;
+    std::map<std::string, uint64_t> mImages;
+    std::map<std::string, uint64_t> mPlatforms;
+
+    std::unordered_map<std::string, QuantileSketch> mSystem;
+    std::unordered_map<std::string, processEntry> mProcesses;
+    std::unordered_map<std::string, QuantileSketch> mGroups;
+    std::unordered_map<std::string, datasetEntry> mDatasets;
+};
@@ -0,0 +1,214 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "QuantileSketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+// Limits memory if values span a huge range. Beyond this, the lowest buckets are combined, so only the lowest
+// quantiles lose accuracy. At 1% accuracy, 2048 buckets covers a range of 10^17
+static constexpr size_t kMaxBuckets = 2048;
+
+QuantileSketch::QuantileSketch(double relativeAccuracy)
+        : mGamma((1 + relativeAccuracy) / (1 - relativeAccuracy)),
+          mLogGamma(std::log(mGamma)),
+          mOffset(0),
+          mZeroCount(0),
+          mCount(0),
+          mMin(std::numeric_limits<double>::max()),
+          mMax(std::numeric_limits<double>::lowest()),
+          mSum(0)
+{
+    if (relativeAccuracy <= 0 || relativeAccuracy >= 1) {
+        throw std::invalid_argument("Relative accuracy must be between 0 and 1");
+    }
+}
+
+int QuantileSketch::bucketIndex(double value) const
+{
+    return static_cast<int>(std::ceil(std::log(value) / mLogGamma));
+}
+
+/**
+ * The value with the same relative error to both ends of the bucket
+ */
+double QuantileSketch::bucketValue(int index) const
+{
+    return 2 * std::pow(mGamma, index) / (mGamma + 1);
+}
+
+void QuantileSketch::collapseLowest()
+{
+    if (mBuckets.size() <= kMaxBuckets) {
+        return;
+    }
+
+    size_t excess = mBuckets.size() - kMaxBuckets;
+    for (size_t i = 0; i < excess; i++) {
+        mBuckets[excess] += mBuckets[i];
+    }
+    mBuckets.erase(mBuckets.begin(), mBuckets.begin() + (long) excess);
+    mOffset += (int) excess;
+}
+
+void QuantileSketch::Add(double value)
+{
+    mCount++;
+    mSum += value;
+    mMin = std::min(mMin, value);
+    mMax = std::max(mMax, value);
+
+    if (value <= 0) {
+        mZeroCount++;
+        return;
+    }
+
+    int index = bucketIndex(value);
+
+    if (mBuckets.empty()) {
+        mOffset = index;
+        mBuckets.push_back(1);
+        return;
+    }
+
+    if (index < mOffset) {
+        mBuckets.insert(mBuckets.begin(), mOffset - index, 0);
+        mOffset = index;
+    } else if (index >= mOffset + (int) mBuckets.size()) {
+        mBuckets.resize(index - mOffset + 1, 0);
+    }
+
+    mBuckets[index - mOffset]++;
+
+    collapseLowest();
+}
+
+void QuantileSketch::Merge(const QuantileSketch &other)
+{
+    if (other.mGamma != mGamma) {
+        throw std::invalid_argument("Can't merge sketches with different accuracies");
+    }
+
+    if (other.mCount == 0) {
+        return;
+    }
+
+    mCount += other.mCount;
+    mZeroCount += other.mZeroCount;
+    mSum += other.mSum;
+    mMin = std::min(mMin, other.mMin);
+    mMax = std::max(mMax, other.mMax);
+
+    if (other.mBuckets.empty()) {
+        return;
+    }
+
+    if (mBuckets.empty()) {
+        mBuckets = other.mBuckets;
+        mOffset = other.mOffset;
+        return;
+    }
+
+    int first = std::min(mOffset, other.mOffset);
+    int last = std::max(mOffset + (int) mBuckets.size(), other.mOffset + (int) other.mBuckets.size());
+
+    if (first < mOffset) {
+        mBuckets.insert(mBuckets.begin(), mOffset - first, 0);
+        mOffset = first;
+    }
+    mBuckets.resize(last - mOffset, 0);
+
+    for (size_t i = 0; i < other.mBuckets.size(); i++) {
+        mBuckets[other.mOffset - mOffset + i] += other.mBuckets[i];
+    }
+
+    collapseLowest();
+}
+
+double QuantileSketch::Quantile(double quantile) const
+{
+    if (mCount == 0) {
+        return 0;
+    }
+
+    // Exact at the ends
+    if (quantile <= 0) {
+        return mMin;
+    } else if (quantile >= 1) {
+        return mMax;
+    }
+
+    auto rank = static_cast<uint64_t>(quantile * (double) (mCount - 1));
+
+    if (rank < mZeroCount) {
+        return std::min(0.0, mMax);
+    }
+
+    uint64_t seen = mZeroCount;
+    for (size_t i = 0; i < mBuckets.size(); i++) {
+        seen += mBuckets[i];
+        if (seen > rank) {
+            return std::clamp(bucketValue(mOffset + (int) i), mMin, mMax);
+        }
+    }
+
+    return mMax;
+}
+
+uint64_t QuantileSketch::Count() const
+{
+    return mCount;
+}
+
+double QuantileSketch::Min() const
+{
+    return mCount > 0 ? mMin : 0;
+}
+
+double QuantileSketch::Max() const
+{
+    return mCount > 0 ? mMax : 0;
+}
+
+double QuantileSketch::Mean() const
+{
+    return mCount > 0 ? mSum / (double) mCount : 0;
+}
+
+nlohmann::json QuantileSketch::ToJson() const
+{
+    auto round = [](double value)
+    {
+        return std::round(value * 100) / 100;
+    };
+
+    return {
+            {"count", mCount},
+            {"min",   round(Min())},
+            {"max",   round(Max())},
+            {"mean",  round(Mean())},
+            {"p50",   round(Quantile(0.5))},
+            {"p90",   round(Quantile(0.9))},
+            {"p95",   round(Quantile(0.95))},
+            {"p99",   round(Quantile(0.99))}
+    };
+}
@@ -0,0 +1,89 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief Mergeable sketch of a distribution, for quantiles over more values than can be kept in memory
+ *
+ * Values are counted in logarithmically sized buckets, so any quantile is accurate to within the relative accuracy
+ * (1% by default) of the true value however many values are added. Sketches with the same accuracy can be merged, so
+ * each thread can build its own and combine them at the end. Memory is bounded by the range of the values rather than
+ * their number - a few KB for values between 1KB and 100GB.
+ *
+ * Values of zero or less are counted together and reported as zero.
+ *
+ * Based on DDSketch (Masson, Rim & Lee, VLDB 2019)
+ */
+class QuantileSketch
+{
+public:
+    explicit QuantileSketch(double relativeAccuracy = 0.01);
+
+    void Add(double value);
+
+    /**
+     * Add all the values counted by another sketch. Throws if the sketches have different accuracies
+     */
+    void Merge(const QuantileSketch &other);
+
+    /**
+     * @param quantile Between 0 and 1
+     */
+    double Quantile(double quantile) const;
+
+    uint64_t Count() const;
+
+    double Min() const;
+
+    double Max() const;
+
+    double Mean() const;
+
+    /**
+     * Count, min, max, mean and the p50/p90/p95/p99 quantiles
+     */
+    nlohmann::json ToJson() const;
+
+private:
+    int bucketIndex(double value) const;
+
+    double bucketValue(int index) const;
+
+    void collapseLowest();
+
+private:
+    double mGamma;
+    double mLogGamma;
+
+    // Bucket i counts values in (gamma^(i-1), gamma^i]. mBuckets[0] is bucket mOffset
+    std::vector<uint64_t> mBuckets;
+    int mOffset;
+
+    uint64_t mZeroCount;
+    uint64_t mCount;
+    double mMin;
+    double mMax;
+    double mSum;
+};
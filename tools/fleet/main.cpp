@@ -0,0 +1,248 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE file the
+* following copyright and licenses apply:
+*
+* Copyright 2023 Sky UK
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "FleetAggregator.h"
+#include "ReportFormat.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <getopt.h>
+#include <thread>
+
+#include "inja/inja.hpp"
+
+#define INCBIN_STYLE INCBIN_STYLE_SNAKE
+#define INCBIN_PREFIX g_
+
+#include <incbin.h>
+
+INCBIN(fleetHtml, "./templates/fleet.html");
+
+static std::filesystem::path gOutputDirectory = std::filesystem::current_path();
+static unsigned int gJobs = std::max(1u, std::thread::hardware_concurrency());
+static double gAccuracyPercent = 1.0;
+
+static void displayUsage()
+{
+    printf("Usage: memcapture-fleet <option(s)> <report directory or file>...\n");
+    printf("    Summarise MemCapture data reports (any --format) from many devices into fleet-wide distributions\n\n");
+    printf("    -h, --help          Print this help and exit\n");
+    printf("    -o, --output-dir    Directory to save fleet.json and fleet.html in. Default current directory\n");
+    printf("    -j, --jobs          Number of reports to parse at once. Default %u (one per core)\n", gJobs);
+    printf("    -e, --accuracy      Relative accuracy of the quantiles, in percent. Default %.1f\n", gAccuracyPercent);
+}
+
+static void parseArgs(const int argc, char **argv)
+{
+    struct option longopts[] = {
+            {"help",       no_argument,       nullptr, (int) 'h'},
+            {"output-dir", required_argument, nullptr, (int) 'o'},
+            {"jobs",       required_argument, nullptr, (int) 'j'},
+            {"accuracy",   required_argument, nullptr, (int) 'e'},
+            {nullptr, 0,                      nullptr, 0}
+    };
+
+    opterr = 0;
+
+    int option;
+    int longindex;
+
+    while ((option = getopt_long(argc, argv, "ho:j:e:", longopts, &longindex)) != -1) {
+        switch (option) {
+            case 'h':
+                displayUsage();
+                exit(EXIT_SUCCESS);
+            case 'o':
+                gOutputDirectory = std::filesystem::path(optarg);
+                break;
+            case 'j':
+                gJobs = std::max(1, std::atoi(optarg));
+                break;
+            case 'e':
+                gAccuracyPercent = std::atof(optarg);
+                if (gAccuracyPercent <= 0 || gAccuracyPercent >= 100) {
+                    LOG_ERROR("Accuracy must be between 0 and 100%%");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            default:
+                displayUsage();
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if (optind >= argc) {
+        displayUsage();
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * Only the latest report MemCapture saved in a directory (report.json etc). This skips the older reports a daemon
+ * rotates to report.1.json..., which would count the same device several times, and any fleet.json/diff.json output
+ */
+static bool isReport(const std::filesystem::path &path)
+{
+    if (path.stem() != "report") {
+        return false;
+    }
+
+    auto extension = path.extension().string();
+    return extension == ReportExtension(ReportFormat::Json) || extension == ReportExtension(ReportFormat::Cbor) ||
+           extension == ReportExtension(ReportFormat::MsgPack);
+}
+
+/**
+ * Find every data report under the given paths. Directories are searched recursively, so reports can be stored in a
+ * directory per device. Files named on the command line are always used
+ */
+static std::vector<std::filesystem::path> findReports(int count, char **paths)
+{
+    std::vector<std::filesystem::path> reports;
+
+    for (int i = 0; i < count; i++) {
+        std::filesystem::path path(paths[i]);
+        std::error_code ec;
+
+        if (std::filesystem::is_directory(path, ec)) {
+            for (const auto &entry: std::filesystem::recursive_directory_iterator(
+                    path, std::filesystem::directory_options::skip_permission_denied, ec)) {
+                if (entry.is_regular_file() && isReport(entry.path())) {
+                    reports.emplace_back(entry.path());
+                }
+            }
+        } else if (std::filesystem::is_regular_file(path, ec)) {
+            reports.emplace_back(path);
+        } else {
+            LOG_WARN("%s is not a file or directory", path.string().c_str());
+        }
+
+        if (ec) {
+            LOG_WARN("Error searching %s: %s", path.string().c_str(), ec.message().c_str());
+        }
+    }
+
+    return reports;
+}
+
+/**
+ * Worker thread - take the next report from the list until there are none left
+ */
+static void aggregateReports(const std::vector<std::filesystem::path> &reports, std::atomic<size_t> &next,
+                             std::atomic<size_t> &skipped, FleetAggregator &aggregator)
+{
+    size_t index;
+    while ((index = next.fetch_add(1)) < reports.size()) {
+        try {
+            auto report = ReadReport(reports[index]);
+            if (!report.is_object() || !report.contains("processes")) {
+                LOG_WARN("%s is not a MemCapture data report, skipping", reports[index].string().c_str());
+                skipped++;
+                continue;
+            }
+
+            aggregator.Add(report);
+        } catch (const std::exception &e) {
+            LOG_WARN("Failed to read %s with error %s", reports[index].string().c_str(), e.what());
+            skipped++;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    parseArgs(argc, argv);
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto reports = findReports(argc - optind, argv + optind);
+    if (reports.empty()) {
+        LOG_ERROR("No reports found");
+        return EXIT_FAILURE;
+    }
+
+    auto jobs = (unsigned int) std::min<size_t>(gJobs, reports.size());
+    LOG_INFO("Aggregating %zu reports with %u threads", reports.size(), jobs);
+
+    // Each thread parses one report at a time into its own aggregator, so only the sketches and one parsed report per
+    // thread are in memory at once. The aggregators are merged at the end
+    std::vector<FleetAggregator> partials(jobs, FleetAggregator(gAccuracyPercent / 100));
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> skipped(0);
+
+    std::vector<std::thread> threads;
+    threads.reserve(jobs);
+    for (unsigned int i = 0; i < jobs; i++) {
+        threads.emplace_back(aggregateReports, std::cref(reports), std::ref(next), std::ref(skipped),
+                             std::ref(partials[i]));
+    }
+
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    FleetAggregator fleet(gAccuracyPercent / 100);
+    for (const auto &partial: partials) {
+        fleet.Merge(partial);
+    }
+    partials.clear();
+
+    if (fleet.Devices() == 0) {
+        LOG_ERROR("None of the reports could be read");
+        return EXIT_FAILURE;
+    }
+
+    nlohmann::json result = fleet.ToJson();
+    result["metadata"]["skipped"] = skipped.load();
+
+    auto end = std::chrono::steady_clock::now();
+    LOG_INFO("Aggregated %llu reports in %lld ms (%zu skipped)", (unsigned long long) fleet.Devices(),
+             (long long) std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(), skipped.load());
+
+    try {
+        std::filesystem::create_directories(gOutputDirectory);
+
+        std::filesystem::path jsonFilepath = gOutputDirectory / "fleet.json";
+        if (!WriteReport(result, ReportFormat::Json, jsonFilepath)) {
+            return EXIT_FAILURE;
+        }
+        LOG_INFO("Saved fleet summary to %s", jsonFilepath.string().c_str());
+
+        inja::Environment env;
+        env.set_trim_blocks(true);
+        env.set_lstrip_blocks(true);
+
+        auto htmlTemplateString = std::string(g_fleetHtml_data, g_fleetHtml_data + g_fleetHtml_size);
+
+        std::filesystem::path htmlFilepath = gOutputDirectory / "fleet.html";
+        std::ofstream outputHtml(htmlFilepath, std::ios::trunc | std::ios::binary);
+        outputHtml << env.render(htmlTemplateString, result);
+        LOG_INFO("Saved fleet report to %s", htmlFilepath.string().c_str());
+    } catch (const std::exception &e) {
+        LOG_ERROR("Failed to save fleet summary with exception %s", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}